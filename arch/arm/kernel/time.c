@@ -29,7 +29,10 @@
 #include <linux/sysdev.h>
 #include <linux/timer.h>
 #include <linux/irq.h>
+#include <linux/clockchips.h>
+#include <linux/cnt32_to_63.h>
 
+#include <asm/div64.h>
 #include <asm/leds.h>
 #include <asm/thread_info.h>
 #include <asm/stacktrace.h>
@@ -92,16 +95,6 @@ static unsigned long dummy_gettimeoffset(void)
 unsigned long (*gettimeoffset)(void) = dummy_gettimeoffset;
 #endif
 
-/*
- * Scheduler clock - returns current time in nanosec units.
- * This is the default implementation.  Sub-architecture
- * implementations can override this.
- */
-unsigned long long __attribute__((weak)) sched_clock(void)
-{
-	return (unsigned long long)jiffies * (1000000000 / HZ);
-}
-
 static unsigned long next_rtc_update;
 
 /*
@@ -674,22 +667,46 @@ out:
 }
 
 /*
- * IRQs are disabled before entering here from do_gettimeofday()
+ * Generic timekeeping calls this every ~11 minutes once NTP is
+ * synchronised, wmt_set_rtc() takes the time from xtime itself.
  */
-static unsigned long wmt_gettimeoffset(void)
+static int wmt_rtc_valid;
+
+int update_persistent_clock(struct timespec now)
 {
-	unsigned long ticks_to_match, elapsed, usec;
+	if (!wmt_rtc_valid)
+		return -ENODEV;
+
+	return wmt_set_rtc();
+}
 
-	/* Get ticks before next timer match */
-	ticks_to_match = OSM1_VAL - (unsigned long)wmt_read_oscr();
+/*
+ * Scheduler clock - returns current time in nanosec units,
+ * from the free running OS Timer counter.
+ * OSCR runs at CLOCK_TICK_RATE (3MHz), so the resolution is 333 ns.
+ * cnt32_to_63() extends the 32-bit counter as long as sched_clock()
+ * is called at least once per counter half period (~715 seconds).
+ */
+#define OSCR2NS_SCALE_FACTOR	10
+
+static unsigned long oscr2ns_scale;
+
+static void __init set_oscr2ns_scale(unsigned long oscr_rate)
+{
+	unsigned long long v = 1000000000ULL << OSCR2NS_SCALE_FACTOR;
 
-	/* We need elapsed ticks since last match */
-	elapsed = LATCH - ticks_to_match;
+	do_div(v, oscr_rate);
+	oscr2ns_scale = v;
+	/* Keep it even so the top bit of cnt32_to_63() drops out */
+	if (oscr2ns_scale & 1)
+		oscr2ns_scale++;
+}
 
-	/* Now convert them to usec */
-	usec = (unsigned long)(elapsed * (tick_nsec / 1000))/LATCH;
+unsigned long long sched_clock(void)
+{
+	unsigned long long v = cnt32_to_63(wmt_read_oscr());
 
-	return usec;
+	return (v * oscr2ns_scale) >> OSCR2NS_SCALE_FACTOR;
 }
 
 /*
@@ -714,31 +731,93 @@ static inline void do_profile(struct pt_regs *regs)
 	}
 }
 
+/*
+ * OS Timer 1 match drives the clock event device, OS Timer 0 is left
+ * for the watchdog. Matches closer than MIN_OSCR_DELTA ticks may be
+ * missed because of the match register write latency.
+ */
+#define MIN_OSCR_DELTA		16
+
 static irqreturn_t
 wmt_timer_interrupt(int irq, void *dev_id)
 {
-	unsigned int next_match;
+	struct clock_event_device *c = dev_id;
 
-	do {
-		do_leds();
-		timer_tick();
+	/* Disarm match on OS Timer 1, then signal the event */
+	OSTI_VAL &= ~OSTI_E1;
+	OSTS_VAL = OSTS_M1;
+	c->event_handler(c);
+
+	return IRQ_HANDLED;
+}
+
+static int
+wmt_osm1_set_next_event(unsigned long delta, struct clock_event_device *dev)
+{
+	unsigned long flags, next, oscr;
+
+	raw_local_irq_save(flags);
+	while (OSTA_VAL & OSTA_MWA1)
+		;
+	next = wmt_read_oscr() + delta;
+	OSM1_VAL = next;
+	OSTI_VAL |= OSTI_E1;
+	oscr = wmt_read_oscr();
+	raw_local_irq_restore(flags);
+
+	return (signed long)(next - oscr) <= MIN_OSCR_DELTA ? -ETIME : 0;
+}
+
+static void
+wmt_osm1_set_mode(enum clock_event_mode mode, struct clock_event_device *dev)
+{
+	unsigned long flags;
 
-		/* Clear match on OS Timer 1 */
+	switch (mode) {
+	case CLOCK_EVT_MODE_ONESHOT:
+	case CLOCK_EVT_MODE_UNUSED:
+	case CLOCK_EVT_MODE_SHUTDOWN:
+		/* Nothing armed until the next set_next_event() */
+		raw_local_irq_save(flags);
+		OSTI_VAL &= ~OSTI_E1;
 		OSTS_VAL = OSTS_M1;
-		next_match = (OSM1_VAL += LATCH);
-		do_set_rtc();
-	} while ((signed long)(next_match - wmt_read_oscr()) <= 0);
+		raw_local_irq_restore(flags);
+		break;
+
+	case CLOCK_EVT_MODE_RESUME:
+	case CLOCK_EVT_MODE_PERIODIC:
+		break;
+	}
+}
 
-	/* TODO: add do_profile()  */
-//	do_profile(regs);
+static struct clock_event_device ckevt_wmt_osm1 = {
+	.name		= "osm1",
+	.features	= CLOCK_EVT_FEAT_ONESHOT,
+	.shift		= 32,
+	.rating		= 200,
+	.set_next_event	= wmt_osm1_set_next_event,
+	.set_mode	= wmt_osm1_set_mode,
+};
 
-	return IRQ_HANDLED;
+static cycle_t wmt_read_cycles(struct clocksource *cs)
+{
+	return wmt_read_oscr();
 }
 
+static struct clocksource cksrc_wmt_oscr = {
+	.name		= "oscr",
+	.rating		= 200,
+	.read		= wmt_read_cycles,
+	.mask		= CLOCKSOURCE_MASK(32),
+	.shift		= 20,
+	.flags		= CLOCK_SOURCE_IS_CONTINUOUS,
+};
+
 static struct irqaction wmt_timer_irq = {
 	.name	  = "timer",
-	.flags	  = IRQF_DISABLED | IRQF_TIMER,
+	.flags	  = IRQF_DISABLED | IRQF_TIMER | IRQF_IRQPOLL,
 	.handler  = wmt_timer_interrupt,
+	.dev_id	  = &ckevt_wmt_osm1,
 };
 
 /* rtc_init()
@@ -793,30 +872,23 @@ static void __init rtc_init(void)
  */
 void __init time_init(void)
 {
-	unsigned int i = 0;
 	struct timespec tv;
 
-	if (system_timer->offset == NULL)
-		system_timer->offset = dummy_gettimeoffset;
-
 	/* system_timer->init(); */
 	/* Stop ostimer. */
 	OSTC_VAL = 0;
 
 	/* Init RTC, A0,A1 has RTC hardware bug */
 	if ((*(volatile unsigned int *)0xd8120000)>0x34260102) {
-        rtc_init();
-        gettimeoffset   = wmt_gettimeoffset;
-        set_rtc         = wmt_set_rtc;               /* draft, need to verify */
+		rtc_init();
+		wmt_rtc_valid	= 1;
 
-        tv.tv_nsec      = 0;
-        tv.tv_sec       = wmt_get_rtc_time();
-    } else {
-        gettimeoffset   = wmt_gettimeoffset;
-        //set_rtc         = wmt_set_rtc;               /* draft, need to verify */
-        tv.tv_nsec      = 0;
-        tv.tv_sec       = 0;
-    }
+		tv.tv_nsec	= 0;
+		tv.tv_sec	= wmt_get_rtc_time();
+	} else {
+		tv.tv_nsec	= 0;
+		tv.tv_sec	= 0;
+	}
 
 	do_settimeofday(&tv);
 
@@ -825,22 +897,36 @@ void __init time_init(void)
 		;
 	OSM1_VAL = 0;
 
-	/* Clear status on all timers. */
+	/* Disable match interrupt, clear status on all timers. */
+	OSTI_VAL &= ~OSTI_E1;
 	OSTS_VAL = OSTS_MASK;     /* 0xF */
 
-	/* Use OS Timer 1 as kernel timer because watchdog may use OS Timer 0. */
-	i = setup_irq(IRQ_OST1, &wmt_timer_irq);
-
-	/* Enable match on timer 1 to cause interrupts. */
-	OSTI_VAL |= OSTI_E1;
-
 	/* Let OS Timer free run. */
 	OSTC_VAL = OSTC_ENABLE;
 
-	/* Initialize free-running timer and force first match. */
+	/* Initialize free-running timer. */
 	while (OSTA_VAL & OSTA_CWA)
 		;
 	OSCR_VAL = 0;
+
+	set_oscr2ns_scale(CLOCK_TICK_RATE);
+
+	ckevt_wmt_osm1.mult =
+		div_sc(CLOCK_TICK_RATE, NSEC_PER_SEC, ckevt_wmt_osm1.shift);
+	ckevt_wmt_osm1.max_delta_ns =
+		clockevent_delta2ns(0x7fffffff, &ckevt_wmt_osm1);
+	ckevt_wmt_osm1.min_delta_ns =
+		clockevent_delta2ns(MIN_OSCR_DELTA * 2, &ckevt_wmt_osm1) + 1;
+	ckevt_wmt_osm1.cpumask = cpumask_of(0);
+
+	cksrc_wmt_oscr.mult =
+		clocksource_hz2mult(CLOCK_TICK_RATE, cksrc_wmt_oscr.shift);
+
+	/* Use OS Timer 1 as kernel timer because watchdog may use OS Timer 0. */
+	setup_irq(IRQ_OST1, &wmt_timer_irq);
+
+	clocksource_register(&cksrc_wmt_oscr);
+	clockevents_register_device(&ckevt_wmt_osm1);
 }
 
 /*
@@ -867,13 +953,10 @@ late_initcall(time_calibrate);
 
 struct sys_timer wmt_timer = {
 	.init		= time_init,
-	.offset		= wmt_gettimeoffset,
 };
 
 EXPORT_SYMBOL(wmt_timer);
 
 /* TODO: add timer PM
- *       CONFIG_NO_IDLE_HZ
- *       irqaction
  *       do_profile
  */
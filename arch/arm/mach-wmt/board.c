@@ -107,7 +107,9 @@ static void __init wmt_map_io(void)
 	iotable_init(wmt_io_desc, ARRAY_SIZE(wmt_io_desc));
 
 	wmt_register_uart(0, 1);	/* mount ttyS0 (or ttyVT0) to UART0*/
-	//wmt_register_uart(1, 2);	/* mount ttyS1 to UART1*/
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+	wmt_register_uart(1, 2);	/* mount ttyS1 to UART1, RX/TX by DMA*/
+#endif
 }
 
 extern struct sys_timer wmt_timer;
@@ -0,0 +1,518 @@
+/*
+  linux/arch/arm/mach-wmt/clock.c
+
+  clk API on top of the power management controller
+	Some descriptions of such software. Copyright (c) 2008  WonderMedia Technologies, Inc.
+
+	This program is free software: you can redistribute it and/or modify it under the
+	terms of the GNU General Public License as published by the Free Software Foundation,
+	either version 2 of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful, but WITHOUT
+	ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+	PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License along with
+	this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	WonderMedia Technologies, Inc.
+	10F, 529, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C.
+
+  The tree is 25MHz crystal -> PLL A..E -> device divisors -> clock gates.
+  Rates are read back from the PMC, so clocks set through auto_pll_divisor()
+  by drivers not using this API stay correct, see wmt_clk_rate_changed().
+
+  A clock is only gated when its use count drops to zero if it is marked
+  CLK_IDLE_GATE, i.e. all of its users go through clk_enable()/clk_disable().
+  Other clocks are still poked directly by their drivers and are never
+  turned off from here.
+*/
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/errno.h>
+#include <linux/clk.h>
+#include <linux/err.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+#include <mach/hardware.h>
+#include <asm/div64.h>
+
+#include "clock.h"
+
+#define WMT_CLK_SRC_FREQ	25000000
+
+static LIST_HEAD(clocks);
+static DEFINE_MUTEX(clocks_mutex);
+static DEFINE_SPINLOCK(clockfw_lock);
+static int wmt_clk_ready;
+
+#define DEFINE_WMT_CLK(_var, _name, _parent, _dev, _offs, _flags) \
+static struct clk _var = {					\
+	.name		= _name,				\
+	.parent		= _parent,				\
+	.dev		= _dev,					\
+	.div_offs	= _offs,				\
+	.flags		= _flags,				\
+}
+
+#define DEFINE_WMT_PLL(_var, _name, _pll)			\
+static struct clk _var = {					\
+	.name		= _name,				\
+	.parent		= &clk_ref,				\
+	.pll		= _pll,					\
+	.flags		= CLK_PLL,				\
+}
+
+static struct clk clk_ref = {
+	.name		= "ref",
+	.rate		= WMT_CLK_SRC_FREQ,
+	.flags		= CLK_FIXED,
+};
+
+DEFINE_WMT_PLL(clk_plla, "pll_a", 0);
+DEFINE_WMT_PLL(clk_pllb, "pll_b", 1);
+DEFINE_WMT_PLL(clk_pllc, "pll_c", 2);
+DEFINE_WMT_PLL(clk_plld, "pll_d", 3);
+DEFINE_WMT_PLL(clk_plle, "pll_e", 4);
+
+/* Bus clocks, the AHB divides the ARM clock */
+DEFINE_WMT_CLK(clk_arm, "arm", &clk_plla, DEV_ARM, 0x300, CLK_DIV);
+DEFINE_WMT_CLK(clk_ahb, "ahb", &clk_arm, DEV_AHB, 0x304, CLK_DIV);
+DEFINE_WMT_CLK(clk_apb, "apb", &clk_plla, DEV_APB, 0x320, CLK_DIV);
+
+/* Devices with their own divisor */
+DEFINE_WMT_CLK(clk_sdmmc0, "sdmmc0", &clk_pllb, DEV_SDMMC0, 0x328, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_sdmmc1, "sdmmc1", &clk_pllb, DEV_SDMMC1, 0x340, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_i2c0, "i2c0", &clk_pllb, DEV_I2C0, 0x36C, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_i2c1, "i2c1", &clk_pllb, DEV_I2C1, 0x378, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_pwm, "pwm", &clk_pllb, DEV_PWM, 0x348, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_spi0, "spi0", &clk_pllb, DEV_SPI0, 0x33C, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_vdu, "vdu", &clk_pllb, DEV_VDU, 0x31C, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_nand, "nand", &clk_pllb, DEV_NAND, 0x330, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_sf, "sf", &clk_pllb, DEV_SF, 0x314, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_na12, "na12", &clk_pllb, DEV_NA12, 0x35C, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_dvo, "dvo", &clk_pllc, DEV_DVO, 0x374, CLK_GATE | CLK_DIV | CLK_SET_PLL);
+DEFINE_WMT_CLK(clk_ddrmc, "ddrmc", &clk_plld, DEV_DDRMC, 0x310, CLK_GATE | CLK_DIV);
+DEFINE_WMT_CLK(clk_na0, "na0", &clk_plle, DEV_NA0, 0x358, CLK_GATE | CLK_DIV | CLK_IDLE_GATE);
+
+/* VPP shares the NA12 divisor */
+DEFINE_WMT_CLK(clk_vpp, "vpp", &clk_na12, DEV_VPP, 0, CLK_GATE);
+
+/* Gate only, clocked from the bus */
+DEFINE_WMT_CLK(clk_cir, "cir", &clk_apb, DEV_CIR, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_uart0, "uart0", &clk_ahb, DEV_UART0, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_uart1, "uart1", &clk_ahb, DEV_UART1, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_i2s, "i2s", &clk_ahb, DEV_I2S, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_rtc, "rtc", &clk_ahb, DEV_RTC, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_keypad, "keypad", &clk_ahb, DEV_KEYPAD, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_gpio, "gpio", &clk_ahb, DEV_GPIO, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_camera, "camera", &clk_ahb, DEV_CAMERA, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_govrhd, "govrhd", &clk_ahb, DEV_GOVRHD, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_vid, "vid", &clk_ahb, DEV_VID, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_scc, "scc", &clk_ahb, DEV_SCC, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_mbox, "mbox", &clk_ahb, DEV_MBOX, 0, CLK_GATE | CLK_IDLE_GATE);
+DEFINE_WMT_CLK(clk_ge, "ge", &clk_ahb, DEV_GE, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_scl444u, "scl444u", &clk_ahb, DEV_SCL444U, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_govw, "govw", &clk_ahb, DEV_GOVW, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_dma, "dma", &clk_ahb, DEV_DMA, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_rot, "rot", &clk_ahb, DEV_ROT, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_uhdc, "uhdc", &clk_ahb, DEV_UHDC, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_perm, "perm", &clk_ahb, DEV_PERM, 0, CLK_GATE | CLK_IDLE_GATE);
+DEFINE_WMT_CLK(clk_dspcfg, "dspcfg", &clk_ahb, DEV_DSPCFG, 0, CLK_GATE | CLK_IDLE_GATE);
+DEFINE_WMT_CLK(clk_ahbb, "ahbb", &clk_ahb, DEV_AHBB, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_ethmac, "ethmac", &clk_ahb, DEV_ETHMAC, 0, CLK_GATE);
+DEFINE_WMT_CLK(clk_ethphy, "ethphy", &clk_ahb, DEV_ETHPHY, 0, CLK_GATE);
+
+/* The DSP divisor source is not described, its rate reads as 0 */
+DEFINE_WMT_CLK(clk_dsp, "dsp", NULL, DEV_DSP, 0, CLK_GATE | CLK_IDLE_GATE);
+
+#define CLK(dev, con, ck)	\
+	{			\
+		.dev_id = dev,	\
+		.con_id = con,	\
+		.clk = ck,	\
+	}
+
+static struct clk_lookup wmt_clks[] = {
+	CLK(NULL, "ref", &clk_ref),
+	CLK(NULL, "pll_a", &clk_plla),
+	CLK(NULL, "pll_b", &clk_pllb),
+	CLK(NULL, "pll_c", &clk_pllc),
+	CLK(NULL, "pll_d", &clk_plld),
+	CLK(NULL, "pll_e", &clk_plle),
+	CLK(NULL, "arm", &clk_arm),
+	CLK(NULL, "ahb", &clk_ahb),
+	CLK(NULL, "apb", &clk_apb),
+	CLK(NULL, "sdmmc0", &clk_sdmmc0),
+	CLK(NULL, "sdmmc1", &clk_sdmmc1),
+	CLK(NULL, "i2c0", &clk_i2c0),
+	CLK(NULL, "i2c1", &clk_i2c1),
+	CLK(NULL, "pwm", &clk_pwm),
+	CLK(NULL, "spi0", &clk_spi0),
+	CLK(NULL, "vdu", &clk_vdu),
+	CLK(NULL, "nand", &clk_nand),
+	CLK(NULL, "sf", &clk_sf),
+	CLK(NULL, "na12", &clk_na12),
+	CLK(NULL, "dvo", &clk_dvo),
+	CLK(NULL, "ddrmc", &clk_ddrmc),
+	CLK(NULL, "na0", &clk_na0),
+	CLK(NULL, "vpp", &clk_vpp),
+	CLK(NULL, "cir", &clk_cir),
+	CLK(NULL, "uart0", &clk_uart0),
+	CLK(NULL, "uart1", &clk_uart1),
+	CLK(NULL, "i2s", &clk_i2s),
+	CLK(NULL, "rtc", &clk_rtc),
+	CLK(NULL, "keypad", &clk_keypad),
+	CLK(NULL, "gpio", &clk_gpio),
+	CLK(NULL, "camera", &clk_camera),
+	CLK(NULL, "govrhd", &clk_govrhd),
+	CLK(NULL, "vid", &clk_vid),
+	CLK(NULL, "scc", &clk_scc),
+	CLK(NULL, "dsp", &clk_dsp),
+	CLK(NULL, "mbox", &clk_mbox),
+	CLK(NULL, "ge", &clk_ge),
+	CLK(NULL, "scl444u", &clk_scl444u),
+	CLK(NULL, "govw", &clk_govw),
+	CLK(NULL, "dma", &clk_dma),
+	CLK(NULL, "rot", &clk_rot),
+	CLK(NULL, "uhdc", &clk_uhdc),
+	CLK(NULL, "perm", &clk_perm),
+	CLK(NULL, "dspcfg", &clk_dspcfg),
+	CLK(NULL, "ahbb", &clk_ahbb),
+	CLK(NULL, "ethmac", &clk_ethmac),
+	CLK(NULL, "ethphy", &clk_ethphy),
+};
+
+static inline volatile unsigned int *wmt_clk_gate_reg(struct clk *clk)
+{
+	return (clk->dev / 32) ? PMCEU_REG : PMCEL_REG;
+}
+
+static inline unsigned int wmt_clk_gate_bit(struct clk *clk)
+{
+	return 1 << (clk->dev % 32);
+}
+
+static int wmt_clk_is_on(struct clk *clk)
+{
+	if (!(clk->flags & CLK_GATE))
+		return 1;
+	return (*wmt_clk_gate_reg(clk) & wmt_clk_gate_bit(clk)) ? 1 : 0;
+}
+
+static void wmt_clk_gate(struct clk *clk, int on)
+{
+	volatile unsigned int *reg = wmt_clk_gate_reg(clk);
+	unsigned int stat;
+
+	stat = *reg;
+	if (on)
+		stat |= wmt_clk_gate_bit(clk);
+	else
+		stat &= ~wmt_clk_gate_bit(clk);
+	*reg = stat;
+
+	while (*reg != stat)
+		;
+}
+
+/* Read the rate of one clock back from the PMC */
+static unsigned long wmt_clk_read_rate(struct clk *clk)
+{
+	unsigned long long rate;
+	unsigned int val, n, d, p, div;
+
+	if (clk->flags & CLK_FIXED)
+		return clk->rate;
+
+	if (clk->flags & CLK_PLL) {
+		val = REG32_VAL(PMPMA_ADDR + 4 * clk->pll);
+		n = val & 0x3FF;
+		d = (val >> 10) & 0x7;
+		p = (val >> 13) & 0x3;
+		if (d == 0)
+			return 0;
+		rate = (unsigned long long)clk->parent->rate * n;
+		do_div(rate, d << p);
+		return (unsigned long)rate;
+	}
+
+	if (!clk->parent)
+		return 0;
+
+	if (!(clk->flags & CLK_DIV))
+		return clk->parent->rate;
+
+	val = REG8_VAL(__PMC_BASE + clk->div_offs);
+	div = val & 0x1F;
+	if (div == 0)
+		div = 32;
+	if ((clk->dev == DEV_SDMMC0 || clk->dev == DEV_SDMMC1) && (val & BIT5))
+		div *= 64;
+
+	return clk->parent->rate / div;
+}
+
+/* Recalculate clk and everything clocked from it, call with clockfw_lock */
+static void wmt_clk_propagate(struct clk *clk)
+{
+	struct clk *ck;
+
+	clk->rate = wmt_clk_read_rate(clk);
+
+	list_for_each_entry(ck, &clocks, node) {
+		if (ck->parent == clk)
+			wmt_clk_propagate(ck);
+	}
+}
+
+static void __clk_enable(struct clk *clk)
+{
+	if (clk->parent)
+		__clk_enable(clk->parent);
+	if (clk->usecount++ == 0 && (clk->flags & CLK_GATE))
+		wmt_clk_gate(clk, 1);
+}
+
+static void __clk_disable(struct clk *clk)
+{
+	if (WARN_ON(clk->usecount == 0))
+		return;
+	if (--clk->usecount == 0 && (clk->flags & CLK_IDLE_GATE))
+		wmt_clk_gate(clk, 0);
+	if (clk->parent)
+		__clk_disable(clk->parent);
+}
+
+int clk_enable(struct clk *clk)
+{
+	unsigned long flags;
+
+	if (clk == NULL || IS_ERR(clk))
+		return -EINVAL;
+
+	spin_lock_irqsave(&clockfw_lock, flags);
+	__clk_enable(clk);
+	spin_unlock_irqrestore(&clockfw_lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(clk_enable);
+
+void clk_disable(struct clk *clk)
+{
+	unsigned long flags;
+
+	if (clk == NULL || IS_ERR(clk))
+		return;
+
+	spin_lock_irqsave(&clockfw_lock, flags);
+	__clk_disable(clk);
+	spin_unlock_irqrestore(&clockfw_lock, flags);
+}
+EXPORT_SYMBOL(clk_disable);
+
+unsigned long clk_get_rate(struct clk *clk)
+{
+	if (clk == NULL || IS_ERR(clk))
+		return 0;
+
+	return clk->rate;
+}
+EXPORT_SYMBOL(clk_get_rate);
+
+long clk_round_rate(struct clk *clk, unsigned long rate)
+{
+	unsigned long parent_rate;
+	int div;
+
+	if (clk == NULL || IS_ERR(clk))
+		return -EINVAL;
+
+	if (!(clk->flags & CLK_DIV) || (clk->flags & CLK_SET_PLL) || !clk->parent)
+		return clk->rate;
+
+	/* Same search as set_divisor(), the result never exceeds rate */
+	parent_rate = clk->parent->rate;
+	for (div = 1; div <= 32; div++) {
+		if (parent_rate / div <= rate)
+			break;
+	}
+	if (div > 32)
+		return -EINVAL;
+
+	return parent_rate / div;
+}
+EXPORT_SYMBOL(clk_round_rate);
+
+int clk_set_rate(struct clk *clk, unsigned long rate)
+{
+	int ret, was_on;
+	unsigned long flags;
+
+	if (clk == NULL || IS_ERR(clk))
+		return -EINVAL;
+
+	if (!(clk->flags & CLK_DIV))
+		return -EINVAL;
+
+	mutex_lock(&clocks_mutex);
+	was_on = wmt_clk_is_on(clk);
+	if (clk->flags & CLK_SET_PLL)
+		ret = auto_pll_divisor(clk->dev, SET_PLLDIV, 0, rate);
+	else
+		ret = auto_pll_divisor(clk->dev, SET_DIV, 0, rate);
+
+	/* auto_pll_divisor() turns the gate on, keep it as it was */
+	spin_lock_irqsave(&clockfw_lock, flags);
+	if (!was_on && clk->usecount == 0)
+		wmt_clk_gate(clk, 0);
+	spin_unlock_irqrestore(&clockfw_lock, flags);
+	mutex_unlock(&clocks_mutex);
+
+	return (ret > 0) ? 0 : -EINVAL;
+}
+EXPORT_SYMBOL(clk_set_rate);
+
+struct clk *clk_get_parent(struct clk *clk)
+{
+	if (clk == NULL || IS_ERR(clk))
+		return NULL;
+
+	return clk->parent;
+}
+EXPORT_SYMBOL(clk_get_parent);
+
+int clk_set_parent(struct clk *clk, struct clk *parent)
+{
+	/* the PMC has no clock source muxes */
+	return -EINVAL;
+}
+EXPORT_SYMBOL(clk_set_parent);
+
+/*
+ * Called by auto_pll_divisor() after a divisor or PLL of dev changed,
+ * refresh the rates of the whole branch.
+ */
+void wmt_clk_rate_changed(enum dev_id dev)
+{
+	struct clk *ck, *clk = NULL;
+	unsigned long flags;
+
+	if (!wmt_clk_ready)
+		return;
+
+	spin_lock_irqsave(&clockfw_lock, flags);
+	list_for_each_entry(ck, &clocks, node) {
+		if (!(ck->flags & CLK_DIV) || ck->dev != dev)
+			continue;
+		clk = ck;
+		break;
+	}
+	if (clk) {
+		/* SET_PLL and SET_PLLDIV may have moved the parent PLL */
+		if (clk->parent && (clk->parent->flags & CLK_PLL))
+			clk = clk->parent;
+		wmt_clk_propagate(clk);
+	}
+	spin_unlock_irqrestore(&clockfw_lock, flags);
+}
+
+static int __init wmt_clk_init(void)
+{
+	int i;
+
+	mutex_lock(&clocks_mutex);
+	for (i = 0; i < ARRAY_SIZE(wmt_clks); i++)
+		list_add_tail(&wmt_clks[i].clk->node, &clocks);
+	mutex_unlock(&clocks_mutex);
+
+	spin_lock_irq(&clockfw_lock);
+	wmt_clk_propagate(&clk_ref);
+	wmt_clk_ready = 1;
+	spin_unlock_irq(&clockfw_lock);
+
+	for (i = 0; i < ARRAY_SIZE(wmt_clks); i++)
+		clkdev_add(&wmt_clks[i]);
+
+	return 0;
+}
+postcore_initcall(wmt_clk_init);
+
+/*
+ * Gate the CLK_IDLE_GATE clocks left on by the boot loader which
+ * nobody has enabled.
+ */
+static int __init wmt_clk_disable_unused(void)
+{
+	struct clk *ck;
+
+	spin_lock_irq(&clockfw_lock);
+	list_for_each_entry(ck, &clocks, node) {
+		if (ck->usecount > 0 || !(ck->flags & CLK_IDLE_GATE))
+			continue;
+		if (!wmt_clk_is_on(ck))
+			continue;
+
+		pr_info("Clocks: disable unused %s\n", ck->name);
+		wmt_clk_gate(ck, 0);
+	}
+	spin_unlock_irq(&clockfw_lock);
+
+	return 0;
+}
+late_initcall(wmt_clk_disable_unused);
+
+#ifdef CONFIG_DEBUG_FS
+static void wmt_clk_dump(struct seq_file *s, struct clk *parent, int level)
+{
+	struct clk *ck;
+
+	list_for_each_entry(ck, &clocks, node) {
+		if (ck->parent != parent)
+			continue;
+
+		seq_printf(s, "%*s%-*s %3d %4s %10lu Hz%s\n",
+			level * 2, "", 16 - level * 2, ck->name,
+			ck->usecount, wmt_clk_is_on(ck) ? "on" : "off",
+			ck->rate,
+			(ck->flags & CLK_IDLE_GATE) ? " idle-gate" : "");
+		wmt_clk_dump(s, ck, level + 1);
+	}
+}
+
+static int wmt_clk_show(struct seq_file *s, void *unused)
+{
+	seq_printf(s, "%-16s %3s %4s %13s\n", "clock", "use", "gate", "rate");
+
+	mutex_lock(&clocks_mutex);
+	wmt_clk_dump(s, NULL, 0);
+	mutex_unlock(&clocks_mutex);
+
+	return 0;
+}
+
+static int wmt_clk_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wmt_clk_show, NULL);
+}
+
+static const struct file_operations wmt_clk_operations = {
+	.open		= wmt_clk_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init wmt_clk_debugfs_init(void)
+{
+	debugfs_create_file("wmt_clocks", S_IFREG | S_IRUGO, NULL, NULL,
+				&wmt_clk_operations);
+	return 0;
+}
+device_initcall(wmt_clk_debugfs_init);
+#endif
@@ -0,0 +1,50 @@
+/*
+  linux/arch/arm/mach-wmt/clock.h
+
+  Clock tree of the power management controller
+	Some descriptions of such software. Copyright (c) 2008  WonderMedia Technologies, Inc.
+
+	This program is free software: you can redistribute it and/or modify it under the
+	terms of the GNU General Public License as published by the Free Software Foundation,
+	either version 2 of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful, but WITHOUT
+	ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+	PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License along with
+	this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	WonderMedia Technologies, Inc.
+	10F, 529, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C.
+*/
+#ifndef __ARCH_ARM_WMT_CLOCK_H
+#define __ARCH_ARM_WMT_CLOCK_H
+
+#include <linux/list.h>
+#include <asm/clkdev.h>
+
+#include "wmt_clk.h"
+
+struct clk {
+	struct list_head	node;
+	const char		*name;
+	struct clk		*parent;
+	enum dev_id		dev;		/* PMC device id for gate and divisor */
+	int			pll;		/* PLL number for CLK_PLL */
+	int			div_offs;	/* divisor register offset in PMC */
+	unsigned long		rate;
+	int			usecount;
+	unsigned int		flags;
+};
+
+/* Clock flags */
+#define CLK_PLL			BIT0	/* PLL A..E output */
+#define CLK_GATE		BIT1	/* has a clock enable bit in PMCEL/PMCEU */
+#define CLK_DIV			BIT2	/* has a divisor register */
+#define CLK_SET_PLL		BIT3	/* owns its PLL, set_rate moves the PLL too */
+#define CLK_IDLE_GATE		BIT4	/* gate off at boot when nobody holds it */
+#define CLK_FIXED		BIT5	/* crystal, rate never changes */
+
+extern void wmt_clk_rate_changed(enum dev_id dev);
+
+#endif
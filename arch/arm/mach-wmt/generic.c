@@ -89,7 +89,7 @@ static struct resource wmt_uart0_resources[] = {
 		.flags  = IORESOURCE_MEM,
 	},
 };
-/*
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
 static struct resource wmt_uart1_resources[] = {
 	[0] = {
 		.start  = 0xd82b0000,
@@ -97,21 +97,21 @@ static struct resource wmt_uart1_resources[] = {
 		.flags  = IORESOURCE_MEM,
 	},
 };
-*/
+#endif
 static struct platform_device wmt_uart0_device = {
 	.name           = "uart",
 	.id             = 0,
 	.num_resources  = ARRAY_SIZE(wmt_uart0_resources),
 	.resource       = wmt_uart0_resources,
 };
-/*
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
 static struct platform_device wmt_uart1_device = {
 	.name           = "uart",
 	.id             = 1,
 	.num_resources  = ARRAY_SIZE(wmt_uart1_resources),
 	.resource       = wmt_uart1_resources,
 };
-*/
+#endif
 static struct resource wmt_sf_resources[] = {
 	[0] = {
 		.start  = 0xd8002000,
@@ -274,7 +274,9 @@ static struct platform_device vt34xx_spi_device = {
 
 static struct platform_device *wmt_devices[] __initdata = {
 	&wmt_uart0_device,
-	//&wmt_uart1_device,
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+	&wmt_uart1_device,
+#endif
 	&wmt_sf_device,
 	&wmt_nand_device,
 	&wmt_i2s_device,
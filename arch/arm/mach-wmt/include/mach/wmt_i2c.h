@@ -214,6 +214,7 @@
 
 #define I2C_TR_STD_VALUE                0xFF64    /* standard mode*/
 #define I2C_TR_FAST_VALUE               0xFF19    /* fast mode*/
+#define I2C_TR_FAST_PLUS_VALUE          0xFF0A    /* fast mode plus, 1MHz*/
 
 
 /*
@@ -266,6 +267,7 @@ enum i2c_mode_e {
 	I2C_STANDARD_MODE = 0 ,
 	I2C_FAST_MODE     = 1,
 	I2C_HS_MODE	= 2,
+	I2C_FAST_PLUS_MODE = 3,
 };
 
 struct i2c_regs_s {
@@ -305,6 +307,8 @@ struct i2c_regs_s {
 #define I2C_SET_STANDARD_MODE           0x07A0
 #define I2C_SET_FAST_MODE                       0x07A1
 
+struct wmt_i2c_port;
+
 struct i2c_algo_wmt_data {
 	int  (*write_msg)(unsigned int slave_addr, char *buf, unsigned int length , int restart, int last) ;
 	int  (*read_msg)(unsigned int slave_addr, char *buf, unsigned int length , int restart, int last) ;
@@ -314,6 +318,7 @@ struct i2c_algo_wmt_data {
 	int  (*wait_bus_not_busy) (void);
 	void (*reset) (void);
 	void (*set_mode)(enum i2c_mode_e) ;
+	struct wmt_i2c_port *port;	/* interrupt driven xfer, see i2c-algo-wmt.h */
 	int  udelay;
 	int  timeout;
 };
@@ -0,0 +1,130 @@
+/*++
+	linux/include/asm-arm/arch-wmt/wmt_mmio.h
+
+	Some descriptions of such software. Copyright (c) 2008  WonderMedia Technologies, Inc.
+
+	This program is free software: you can redistribute it and/or modify it under the
+	terms of the GNU General Public License as published by the Free Software Foundation,
+	either version 2 of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful, but WITHOUT
+	ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+	PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License along with
+	this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	WonderMedia Technologies, Inc.
+	10F, 529, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C.
+--*/
+
+/*
+ * Register access tracing into the ftrace ring buffer, see
+ * arch/arm/mach-wmt/mmio_trace.c. Devices are switched on in
+ * /proc/wmt-mmio, the events are wmt_mmio/wmt_mmio_access and
+ * wmt_mmio/wmt_mmio_seq.
+ *
+ * A driver doing its accesses with readl()/writel() gets them traced by
+ * defining WMT_MMIO_TRACE_DEV after its other includes:
+ *
+ *	#define WMT_MMIO_TRACE_DEV	WMT_MMIO_NAND
+ *	#include <mach/wmt_mmio.h>
+ *
+ * Without CONFIG_WMT_MMIO_TRACE all of this compiles away.
+ */
+#ifndef __WMT_MMIO_H
+#define __WMT_MMIO_H
+
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <asm/io.h>
+
+enum wmt_mmio_dev {
+	WMT_MMIO_VPP,
+	WMT_MMIO_GE,
+	WMT_MMIO_NAND,
+	WMT_MMIO_SD,
+	WMT_MMIO_UDC,
+	WMT_MMIO_NR
+};
+
+/* flags of wmt_mmio_trace(): access size in bytes, or'ed with */
+#define WMT_MMIO_WRITE		0x80
+
+extern unsigned int wmt_read_oscr(void);
+
+#ifdef CONFIG_WMT_MMIO_TRACE
+
+extern unsigned long wmt_mmio_trace_mask;	/* 1 << WMT_MMIO_xxx */
+
+extern void __wmt_mmio_trace(int dev, unsigned long addr, u32 val, int flags,
+	unsigned long ip);
+extern u32 __wmt_mmio_seq(const char *name, int begin, u32 ost);
+extern void wmt_mmio_set_virt(int dev, void __iomem *virt, unsigned long phys,
+	unsigned long size);
+
+static inline void wmt_mmio_trace(int dev, unsigned long addr, u32 val,
+	int flags, unsigned long ip)
+{
+	if (unlikely(wmt_mmio_trace_mask & (1 << dev)))
+		__wmt_mmio_trace(dev, addr, val, flags, ip);
+}
+
+/*
+ * Mark a register sequence, wmt_mmio_seq_end() reports the OS timer
+ * ticks since the matching wmt_mmio_seq_begin().
+ */
+static inline u32 wmt_mmio_seq_begin(const char *name)
+{
+	if (unlikely(wmt_mmio_trace_mask))
+		return __wmt_mmio_seq(name, 1, 0);
+	return 0;
+}
+
+static inline void wmt_mmio_seq_end(const char *name, u32 begin)
+{
+	if (unlikely(wmt_mmio_trace_mask))
+		__wmt_mmio_seq(name, 0, begin);
+}
+
+#ifdef WMT_MMIO_TRACE_DEV
+#undef readb
+#undef readw
+#undef readl
+#undef writeb
+#undef writew
+#undef writel
+
+#define __wmt_mmio_read(c, type, raw, size) ({				\
+	const volatile void __iomem *__a = (c);				\
+	type __v = raw(__mem_pci(__a));					\
+	wmt_mmio_trace(WMT_MMIO_TRACE_DEV, (unsigned long)__a, __v,	\
+		size, _THIS_IP_);					\
+	__v; })
+
+#define __wmt_mmio_write(v, c, type, raw, size) ({			\
+	volatile void __iomem *__a = (c);				\
+	type __v = (v);							\
+	wmt_mmio_trace(WMT_MMIO_TRACE_DEV, (unsigned long)__a, __v,	\
+		WMT_MMIO_WRITE | size, _THIS_IP_);			\
+	raw(__v, __mem_pci(__a)); })
+
+#define readb(c)	__wmt_mmio_read(c, __u8, __raw_readb, 1)
+#define readw(c)	__wmt_mmio_read(c, __u16, __raw_readw, 2)
+#define readl(c)	__wmt_mmio_read(c, __u32, __raw_readl, 4)
+#define writeb(v, c)	__wmt_mmio_write(v, c, __u8, __raw_writeb, 1)
+#define writew(v, c)	__wmt_mmio_write(v, c, __u16, __raw_writew, 2)
+#define writel(v, c)	__wmt_mmio_write(v, c, __u32, __raw_writel, 4)
+#endif /* WMT_MMIO_TRACE_DEV */
+
+#else
+
+static inline void wmt_mmio_trace(int dev, unsigned long addr, u32 val,
+	int flags, unsigned long ip) { }
+static inline u32 wmt_mmio_seq_begin(const char *name) { return 0; }
+static inline void wmt_mmio_seq_end(const char *name, u32 begin) { }
+static inline void wmt_mmio_set_virt(int dev, void __iomem *virt,
+	unsigned long phys, unsigned long size) { }
+
+#endif /* CONFIG_WMT_MMIO_TRACE */
+
+#endif /* __WMT_MMIO_H */
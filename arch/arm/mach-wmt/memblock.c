@@ -68,6 +68,9 @@
 #include <linux/major.h>
 #include <linux/sched.h>
 #include <linux/swap.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
 
 #include "com-mb.h"
 #include <mach/memblock.h>
@@ -107,6 +110,10 @@
 
 #define MBAFLAG_STATIC		0x80000000	// static, without release 
 										// if there is no mb inside
+#define MBAFLAG_LENT		0x40000000	// static, pages lent to the page
+										// allocator as MIGRATE_CMA
+
+#define MB_LEND_DELAY		(10 * HZ)	// idle time before lending
 
 #define MBUSRCH_ALL			0x00000000	// search all mbu
 #define MBUSRCH_CREATOR		0x00000001	// search creator
@@ -207,6 +214,11 @@ struct mb_area_struct{
 
 	/* cur max free pages of this MBA */
 	unsigned long	 		max_available_pages;
+
+#ifdef CONFIG_CMA
+	/* when the last MB of a static MBA was freed */
+	unsigned long			idle_jiffies;
+#endif
 };
 
 /*
@@ -307,6 +319,18 @@ static spinlock_t mb_ioctl_lock;
 static spinlock_t mb_task_mm_lock;
 static spinlock_t mb_task_lock;
 static struct page *pg_user[12800]; // 12800 pages = 50 MB
+#ifdef CONFIG_CMA
+static DEFINE_MUTEX(mb_lend_mutex);
+static void mb_lend_idle(struct work_struct *work);
+static DECLARE_DELAYED_WORK(mb_lend_work, mb_lend_idle);
+static struct {
+	unsigned int			claims;		// lent MBAs taken back
+	unsigned int			fails;		// ... and failed to
+	unsigned long			busy_pages;	// pages not migrated on failures
+	unsigned long			last_us;	// latency of the last claim
+	unsigned long			max_us;
+} mb_lend_stat;
+#endif
 static char show_mb_buffer[MB_SHOW_BUFSIZE];
 static char show_mba_buffer[MBA_SHOW_BUFSIZE];
 
@@ -766,6 +790,7 @@ static int mb_show_mba(
 					mba->nr_mb,
 					PAGE_KB(mba->max_available_pages),
 					PAGE_KB(mba->tot_free_pages),
+					(mba->flags & MBAFLAG_LENT)?"lent":
 					(mba->flags | MBAFLAG_STATIC)?"static":"dynamic");
 
 	if(follow){
@@ -812,6 +837,8 @@ static void mb_update_mbah(void)
 	list_for_each_entry(mba, &mbah->mba_list, mba_list){
 		unsigned long zs,nr_pages;	// zone start
 
+		if(mba->flags & MBAFLAG_LENT)
+			continue;
 		zs = mba->pgi.pfn_start;
 		mba_free = mba_max = nr_pages = 0;
 		list_for_each_entry(mb, &mba->mb_list, mb_list){
@@ -831,6 +858,116 @@ static void mb_update_mbah(void)
 	return;
 }
 
+#ifdef CONFIG_CMA
+/*
+ * Static MBAs of the boot time pool are lent to the page allocator while
+ * no MB lives in them: their pageblocks become MIGRATE_CMA and serve page
+ * cache and anonymous pages, which are migrated away again when a driver
+ * allocates from the MBA. Needs whole pageblocks.
+ */
+static int mb_lendable(struct mb_area_struct *mba)
+{
+	return (mba->flags & MBAFLAG_STATIC) && mba->tgid == MB_DEF_TGID &&
+		!(mba->pgi.pfn_start & (pageblock_nr_pages - 1)) &&
+		!(mba->pgi.pfn_end & (pageblock_nr_pages - 1));
+}
+
+// mb_do_lock held
+static void mb_lend_mba(struct mb_area_struct *mba)
+{
+	unsigned long pfn;
+
+	for(pfn = mba->pgi.pfn_start; pfn < mba->pgi.pfn_end; pfn += pageblock_nr_pages)
+		init_cma_reserved_pageblock(pfn_to_page(pfn));
+	mba->flags |= MBAFLAG_LENT;
+	mba->tot_free_pages = mba->max_available_pages = 0;
+	MB_DBG("MBA(%p) 0x%lx ~ 0x%lx lent\n",mba,
+		mba->pgi.pfn_start << PAGE_SHIFT, mba->pgi.pfn_end << PAGE_SHIFT);
+}
+
+static void mb_lend_idle(struct work_struct *work)
+{
+	struct mb_area_struct *mba;
+	unsigned long flags;
+	int lent = 0, again = 0;
+
+	mutex_lock(&mb_lend_mutex);
+	spin_lock_irqsave(&mb_do_lock, flags);
+	list_for_each_entry(mba, &wmt_mbah->mba_list, mba_list){
+		if(mba->nr_mb || (mba->flags & MBAFLAG_LENT) || !mb_lendable(mba))
+			continue;
+		if(time_before(jiffies, mba->idle_jiffies + MB_LEND_DELAY)){
+			again = 1;
+			continue;
+		}
+		mb_lend_mba(mba);
+		lent++;
+	}
+	if(lent)
+		mb_update_mbah();
+	spin_unlock_irqrestore(&mb_do_lock, flags);
+	if(again)
+		schedule_delayed_work(&mb_lend_work, MB_LEND_DELAY);
+	mutex_unlock(&mb_lend_mutex);
+}
+
+/*
+ * Take a lent MBA back if no MBA in use has room for pages.
+ * Sleeps, so it runs before mb_do_allocate() takes its lock.
+ */
+static void mb_claim_lent(unsigned int pages)
+{
+	struct mb_area_struct *entry, *mba = NULL;
+	unsigned long flags, busy = 0, pfn, us;
+	ktime_t start;
+	int ret;
+
+	mutex_lock(&mb_lend_mutex);
+	spin_lock_irqsave(&mb_do_lock, flags);
+	if(pages > wmt_mbah->max_available_pages){
+		list_for_each_entry(entry, &wmt_mbah->mba_list, mba_list){
+			if((entry->flags & MBAFLAG_LENT) && entry->pages >= pages){
+				mba = entry;
+				break;
+			}
+		}
+	}
+	spin_unlock_irqrestore(&mb_do_lock, flags);
+	if(!mba)
+		goto out;
+
+	start = ktime_get();
+	ret = alloc_contig_range(mba->pgi.pfn_start, mba->pgi.pfn_end, &busy);
+	us = (unsigned long)ktime_to_us(ktime_sub(ktime_get(), start));
+	mb_lend_stat.last_us = us;
+	mb_lend_stat.max_us = max(mb_lend_stat.max_us, us);
+	if(ret){
+		mb_lend_stat.fails++;
+		mb_lend_stat.busy_pages += busy;
+		MB_WARN("claim lent MBA 0x%lx fail (%d), %ld pages busy, %ld us\n",
+			mba->start, ret, busy, us);
+		goto out;
+	}
+	mb_lend_stat.claims++;
+	MB_DBG("MBA(%p) claimed in %ld us\n", mba, us);
+
+	for(pfn = mba->pgi.pfn_start; pfn < mba->pgi.pfn_end; pfn++)
+		SetPageReserved(pfn_to_page(pfn));
+
+	spin_lock_irqsave(&mb_do_lock, flags);
+	mba->flags &= ~MBAFLAG_LENT;
+	mba->tot_free_pages = mba->max_available_pages = mba->pages;
+	mba->idle_jiffies = jiffies;
+	mb_update_mbah();
+	spin_unlock_irqrestore(&mb_do_lock, flags);
+
+	// lend it again if the allocation does not end up in it
+	schedule_delayed_work(&mb_lend_work, MB_LEND_DELAY);
+out:
+	mutex_unlock(&mb_lend_mutex);
+}
+#endif
+
 static struct mb_area_struct * mb_allocate_mba(unsigned int pages)
 {
 	struct mba_host_struct *mbah = wmt_mbah;
@@ -1075,6 +1212,13 @@ static int mb_free_mb(struct mb_struct *mb)
 	if(!mba->nr_mb && !(mba->flags & MBAFLAG_STATIC))
 		return mb_free_mba(mba);
 
+#ifdef CONFIG_CMA
+	if(!mba->nr_mb && mb_lendable(mba)){
+		mba->idle_jiffies = jiffies;
+		schedule_delayed_work(&mb_lend_work, MB_LEND_DELAY);
+	}
+#endif
+
 	// update max mb size and free mb size
 	mbah->tot_free_pages -= mba->tot_free_pages;	// sub old one and then add new one
 	zs = mba->pgi.pfn_start;
@@ -1330,6 +1474,9 @@ unsigned long mb_do_allocate(
 	MB_DBG("IN, TGID %d task %s TGID %d size %lx tp %x name %s\n",
 		tgid,current->comm,current->tgid,size,type,name);
 
+#ifdef CONFIG_CMA
+	mb_claim_lent(pages);
+#endif
 	spin_lock_irqsave(&mb_do_lock, flags);
 
 	if(pages > wmt_mbah->max_available_pages){
@@ -2197,6 +2344,13 @@ static int mb_probe(struct platform_device *dev)
 	spin_unlock_irqrestore(&mb_do_lock,flags);
 
 	mb_update_mbah();
+#ifdef CONFIG_CMA
+	// nothing plays yet, lend the pool until somebody needs it
+	list_for_each_entry(mba, &wmt_mbah->mba_list, mba_list){
+		mba->idle_jiffies = jiffies - MB_LEND_DELAY;
+	}
+	schedule_delayed_work(&mb_lend_work, 0);
+#endif
 	MB_INFO("MAX MB Area size: Max %ld Kbs Min %ld Kbs\n",
 		PAGE_KB(1 << MBMAX_ORDER),PAGE_KB(1 << MBMIN_ORDER));
 
@@ -2281,6 +2435,20 @@ int mb_area_read_proc(
 		p += sprintf(p,"total size:      %8ld kB\n",PAGE_KB(wmt_mbah->tot_pages));
 		p += sprintf(p,"total free size: %8ld kB\n",PAGE_KB(wmt_mbah->tot_free_pages));
 		p += sprintf(p,"max MB size:     %8ld kB\n\n",PAGE_KB(wmt_mbah->max_available_pages));
+#ifdef CONFIG_CMA
+{
+		unsigned long lent = 0;
+		list_for_each_entry(mba, &wmt_mbah->mba_list, mba_list){
+			if(mba->flags & MBAFLAG_LENT)
+				lent += mba->pages;
+		}
+		p += sprintf(p,"lent size:       %8ld kB\n",PAGE_KB(lent));
+		p += sprintf(p,"lent claims:     %8d (fail %d, busy %ld pages)\n",
+					mb_lend_stat.claims,mb_lend_stat.fails,mb_lend_stat.busy_pages);
+		p += sprintf(p,"claim latency:   %8ld us (max %ld us)\n\n",
+					mb_lend_stat.last_us,mb_lend_stat.max_us);
+}
+#endif
 		
 		list_for_each_entry(mba, &wmt_mbah->mba_list, mba_list){ 
 			p += sprintf(p, "(ID)         [MB Area]  address     size [  zs,  ze]"
@@ -0,0 +1,187 @@
+/*++
+	linux/arch/arm/mach-wmt/mmio_trace.c
+
+	Some descriptions of such software. Copyright (c) 2008  WonderMedia Technologies, Inc.
+
+	This program is free software: you can redistribute it and/or modify it under the
+	terms of the GNU General Public License as published by the Free Software Foundation,
+	either version 2 of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful, but WITHOUT
+	ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+	PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License along with
+	this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	WonderMedia Technologies, Inc.
+	10F, 529, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C.
+
+	Register access tracer. Drivers report their accesses through
+	<mach/wmt_mmio.h>, accesses of a switched on device inside its
+	address filter go to the ftrace ring buffer with the OS timer count.
+
+	$ echo "nand on" > /proc/wmt-mmio
+	$ echo "vpp 0xd8050f00 0xd8050fff" > /proc/wmt-mmio
+	$ echo 1 > /sys/kernel/debug/tracing/events/wmt_mmio/enable
+	$ cat /sys/kernel/debug/tracing/trace
+--*/
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/proc_fs.h>
+#include <linux/string.h>
+
+#include <asm/uaccess.h>
+#include <mach/hardware.h>
+#include <mach/wmt_mmio.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/wmt_mmio.h>
+
+struct wmt_mmio_dev_s {
+	const char *name;
+	unsigned long base;		/* register block, for /proc only */
+	unsigned long start;		/* filter, physical, inclusive */
+	unsigned long end;
+	void __iomem *virt;		/* ioremap of the driver, if any */
+	unsigned long phys;
+	unsigned long size;
+	unsigned long hits;		/* accesses while switched on */
+	unsigned long traced;		/* ... and inside the filter */
+};
+
+static struct wmt_mmio_dev_s wmt_mmio_devs[WMT_MMIO_NR] = {
+	[WMT_MMIO_VPP]	= { "vpp",	VPU_BASE_ADDR & ~0xFFF,		0, ~0UL },
+	[WMT_MMIO_GE]	= { "ge",	GE1_BASE_ADDR,			0, ~0UL },
+	[WMT_MMIO_NAND]	= { "nand",	NF_CTRL_CFG_BASE_ADDR,		0, ~0UL },
+	[WMT_MMIO_SD]	= { "sd",	SD0_SDIO_MMC_BASE_ADDR,		0, ~0UL },
+	[WMT_MMIO_UDC]	= { "udc",	USB20_DEVICE_CFG_BASE_ADDR,	0, ~0UL },
+};
+
+unsigned long wmt_mmio_trace_mask;
+EXPORT_SYMBOL(wmt_mmio_trace_mask);
+
+void __wmt_mmio_trace(int dev, unsigned long addr, u32 val, int flags,
+	unsigned long ip)
+{
+	struct wmt_mmio_dev_s *d = &wmt_mmio_devs[dev];
+
+	d->hits++;
+	if (d->virt && addr - (unsigned long)d->virt < d->size)
+		addr = addr - (unsigned long)d->virt + d->phys;
+	if (addr < d->start || addr > d->end)
+		return;
+	d->traced++;
+	trace_wmt_mmio_access(dev, addr, val, flags, ip);
+}
+EXPORT_SYMBOL(__wmt_mmio_trace);
+
+u32 __wmt_mmio_seq(const char *name, int begin, u32 ost)
+{
+	u32 now = wmt_read_oscr();
+
+	trace_wmt_mmio_seq(name, begin, now, begin ? 0 : now - ost);
+	return now;
+}
+EXPORT_SYMBOL(__wmt_mmio_seq);
+
+/*!*************************************************************************
+* wmt_mmio_set_virt
+*/
+/*!
+* \brief
+*	Tell the tracer where a driver ioremap()ed its registers, so its
+*	accesses are traced and filtered with physical addresses.
+*
+* \retval  none
+*/
+void wmt_mmio_set_virt(int dev, void __iomem *virt, unsigned long phys,
+	unsigned long size)
+{
+	struct wmt_mmio_dev_s *d = &wmt_mmio_devs[dev];
+
+	d->phys = phys;
+	d->size = size;
+	d->virt = virt;
+}
+EXPORT_SYMBOL(wmt_mmio_set_virt);
+
+static int wmt_mmio_proc_read(char *page, char **start, off_t off,
+	int count, int *eof, void *data)
+{
+	struct wmt_mmio_dev_s *d;
+	char *p = page;
+	int i;
+
+	p += sprintf(p, "dev  on base       filter                hits       traced\n");
+	for (i = 0; i < WMT_MMIO_NR; i++) {
+		d = &wmt_mmio_devs[i];
+		p += sprintf(p, "%-4s %d  0x%08lx 0x%08lx-0x%08lx %-10lu %lu\n",
+			d->name, (int)(wmt_mmio_trace_mask >> i) & 1, d->base,
+			d->start, d->end, d->hits, d->traced);
+	}
+	*eof = 1;
+	return p - page;
+}
+
+/*
+ * "<dev> on", "<dev> off", "<dev> <start> <end>", "off" for all devices
+ * and "clear" for the counters.
+ */
+static int wmt_mmio_proc_write(struct file *file, const char __user *buffer,
+	unsigned long count, void *data)
+{
+	char buf[64], name[8], arg[16];
+	unsigned long start, end;
+	int i, n;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, buffer, count))
+		return -EFAULT;
+	buf[count] = 0;
+
+	n = sscanf(buf, "%7s %15s %lx", name, arg, &end);
+	if (n == 1 && !strcmp(name, "off")) {
+		wmt_mmio_trace_mask = 0;
+		return count;
+	}
+	if (n == 1 && !strcmp(name, "clear")) {
+		for (i = 0; i < WMT_MMIO_NR; i++)
+			wmt_mmio_devs[i].hits = wmt_mmio_devs[i].traced = 0;
+		return count;
+	}
+
+	for (i = 0; i < WMT_MMIO_NR; i++)
+		if (n >= 2 && !strcmp(name, wmt_mmio_devs[i].name))
+			break;
+	if (i == WMT_MMIO_NR)
+		return -EINVAL;
+
+	if (n == 2 && !strcmp(arg, "on"))
+		set_bit(i, &wmt_mmio_trace_mask);
+	else if (n == 2 && !strcmp(arg, "off"))
+		clear_bit(i, &wmt_mmio_trace_mask);
+	else if (n == 3 && !strict_strtoul(arg, 16, &start) && start <= end) {
+		wmt_mmio_devs[i].start = start;
+		wmt_mmio_devs[i].end = end;
+	} else
+		return -EINVAL;
+
+	return count;
+}
+
+static int __init wmt_mmio_trace_init(void)
+{
+	struct proc_dir_entry *entry;
+
+	entry = create_proc_entry("wmt-mmio", S_IRUGO | S_IWUSR, NULL);
+	if (entry == NULL)
+		return -ENOMEM;
+	entry->read_proc = wmt_mmio_proc_read;
+	entry->write_proc = wmt_mmio_proc_write;
+	return 0;
+}
+
+module_init(wmt_mmio_trace_init);
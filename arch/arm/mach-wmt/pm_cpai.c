@@ -117,8 +117,10 @@ static void PM_I2C_PreResume(void)
 	*(volatile unsigned short *)(0xD8280008) = 0x07;
 	if (wmt_i2c0_speed_mode == 0)
 		*(volatile unsigned short *)(0xD828000C) = I2C_TR_STD_VALUE;
-	else
+	else if (wmt_i2c0_speed_mode == 1)
 		*(volatile unsigned short *)(0xD828000C) = I2C_TR_FAST_VALUE;
+	else
+		*(volatile unsigned short *)(0xD828000C) = I2C_TR_FAST_PLUS_VALUE;
 		
 	*(volatile unsigned short *)(0xD8280000) = 0x0001;
 
@@ -132,8 +134,10 @@ static void PM_I2C_PreResume(void)
 	*(volatile unsigned short *)(0xD8320008) = 0x07;
 	if (wmt_i2c1_speed_mode == 0)
 		*(volatile unsigned short *)(0xD832000C) = I2C_TR_STD_VALUE;
-	else
+	else if (wmt_i2c1_speed_mode == 1)
 		*(volatile unsigned short *)(0xD832000C) = I2C_TR_FAST_VALUE;
+	else
+		*(volatile unsigned short *)(0xD832000C) = I2C_TR_FAST_PLUS_VALUE;
 	*(volatile unsigned short *)(0xD8320000) = 0x0001;
 }
 
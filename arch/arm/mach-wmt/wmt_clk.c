@@ -11,6 +11,7 @@
 
 #include <linux/mtd/mtd.h>
 #include "wmt_clk.h"
+#include "clock.h"
 
 #define PMC_BASE 0xD8130000
 #define PMC_PLL 0xD8130200
@@ -480,14 +481,17 @@ int auto_pll_divisor(enum dev_id dev, enum clk_cmd cmd, int unit, int freq)
 		case SET_DIV:
 			divisor = 0;
 			last_freq = set_divisor(dev, unit, freq, &divisor);
+			wmt_clk_rate_changed(dev);
 			return last_freq;
 		case SET_PLL:
 			divisor = 0;
 			last_freq = set_pll_speed(dev, unit, freq, &divisor);
+			wmt_clk_rate_changed(dev);
 			return last_freq;
 		case SET_PLLDIV:
 			divisor = 0;
 			last_freq = set_pll_divisor(dev, unit, freq, &divisor);
+			wmt_clk_rate_changed(dev);
 			return last_freq;
 		default:
 		printk(KERN_INFO"clock cmd unknow");
@@ -578,6 +582,7 @@ int manu_pll_divisor(enum dev_id dev, int PLLN, int PLLD, int PLLP, int dev_div)
 	;
 	while ((*(volatile unsigned int *)(PMC_BASE+4))&0x1FF)
 	;
+	wmt_clk_rate_changed(dev);
 	return freq;
 }
 EXPORT_SYMBOL(manu_pll_divisor);
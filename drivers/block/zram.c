@@ -0,0 +1,672 @@
+/*
+ * Compressed RAM block device.
+ *
+ * Pages written to the device are compressed with LZO and kept in a pool
+ * of order-0 pages, so that it can be used as a swap device on boards
+ * without a disk. Anonymous memory typically compresses to a third of its
+ * size, which gives back more memory than the device takes.
+ *
+ * The device only does whole, page aligned I/O, which is what swap does.
+ * Swap tells the driver about freed slots through swap_slot_free_notify,
+ * so their memory is released right away instead of when they are
+ * overwritten.
+ *
+ * Statistics are in /sys/block/zram<id>/.
+ *
+ * Parts derived from drivers/block/brd.c.
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/blkdev.h>
+#include <linux/bio.h>
+#include <linux/highmem.h>
+#include <linux/gfp.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/lzo.h>
+#include <linux/swap.h>
+#include <linux/device.h>
+#include <linux/genhd.h>
+
+#define SECTOR_SHIFT		9
+#define PAGE_SECTORS_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
+#define PAGE_SECTORS		(1 << PAGE_SECTORS_SHIFT)
+
+/* Pages compressing to more than this are stored as they are */
+#define ZRAM_MAX_ZPAGE_SIZE	(PAGE_SIZE / 4 * 3)
+
+/*
+ * The pool has a size class every ZRAM_CLASS_SIZE bytes. Objects of a
+ * class are packed into runs of up to ZRAM_RUN_MAX_PAGES pages and may
+ * straddle two pages of their run, so nothing but the tail of a run and
+ * the rounding to the class size is wasted.
+ */
+#define ZRAM_CLASS_SHIFT	5
+#define ZRAM_CLASS_SIZE		(1 << ZRAM_CLASS_SHIFT)
+#define ZRAM_NR_CLASSES		(ZRAM_MAX_ZPAGE_SIZE >> ZRAM_CLASS_SHIFT)
+#define ZRAM_RUN_MAX_PAGES	4
+#define ZRAM_OBJ_END		0xffff
+
+struct zram_run {
+	struct list_head	list;	/* in its class while it has room */
+	struct page		*pages[ZRAM_RUN_MAX_PAGES];
+	u16			inuse;
+	u16			free;	/* first free object, chained */
+	u8			class;
+};
+
+struct zram_class {
+	struct list_head	runs;
+	u16			size;
+	u16			objs;	/* objects per run */
+	u8			run_pages;
+};
+
+/* Slot flags */
+#define ZRAM_ZERO		0x01	/* page of zeroes, nothing stored */
+#define ZRAM_WHOLE		0x02	/* handle is an uncompressed page */
+
+struct zram_slot {
+	void			*handle;	/* struct zram_run or page */
+	u16			idx;		/* object in the run */
+	u16			size;		/* compressed size */
+	u8			flags;
+};
+
+struct zram_stats {
+	u64			num_reads;
+	u64			num_writes;
+	u64			failed_reads;
+	u64			failed_writes;
+	u64			invalid_io;
+	u64			notify_free;
+	u64			compr_size;	/* bytes in pool objects */
+	u32			pages_zero;
+	u32			pages_stored;	/* compressed */
+	u32			pages_whole;	/* stored uncompressed */
+	u32			pool_pages;
+};
+
+struct zram {
+	struct request_queue	*queue;
+	struct gendisk		*disk;
+	unsigned long		nr_pages;
+
+	/* serializes I/O, protects cbuf and workmem */
+	struct mutex		lock;
+	void			*workmem;
+	void			*cbuf;
+
+	/* protects table, classes and stats, taken under swap_lock */
+	spinlock_t		table_lock;
+	struct zram_slot	*table;
+	struct zram_class	classes[ZRAM_NR_CLASSES];
+	struct zram_stats	stats;
+};
+
+static int zram_major;
+static struct zram *zram_devices;
+
+static unsigned int num_devices = 1;
+module_param(num_devices, uint, 0);
+MODULE_PARM_DESC(num_devices, "Number of zram devices");
+static unsigned long disksize_kb;
+module_param(disksize_kb, ulong, 0);
+MODULE_PARM_DESC(disksize_kb, "Size of each device in kbytes, default 25% of RAM");
+
+/*
+ * Copy len bytes from or to object idx of run, which may straddle two
+ * of its pages.
+ */
+static void zram_obj_copy(struct zram_class *c, struct zram_run *run,
+			  u16 idx, void *buf, size_t len, int to_obj)
+{
+	unsigned long off = (unsigned long)idx * c->size;
+	struct page *page = run->pages[off >> PAGE_SHIFT];
+	size_t poff = off & ~PAGE_MASK;
+	size_t n = min_t(size_t, len, PAGE_SIZE - poff);
+	void *p;
+
+	p = kmap_atomic(page, KM_USER1);
+	if (to_obj)
+		memcpy(p + poff, buf, n);
+	else
+		memcpy(buf, p + poff, n);
+	kunmap_atomic(p, KM_USER1);
+
+	if (n == len)
+		return;
+	page = run->pages[(off >> PAGE_SHIFT) + 1];
+	p = kmap_atomic(page, KM_USER1);
+	if (to_obj)
+		memcpy(p, buf + n, len - n);
+	else
+		memcpy(buf + n, p, len - n);
+	kunmap_atomic(p, KM_USER1);
+}
+
+/* Free objects hold the index of the next one in their first bytes */
+static u16 zram_obj_next(struct zram_class *c, struct zram_run *run, u16 idx)
+{
+	u16 next;
+
+	zram_obj_copy(c, run, idx, &next, sizeof(next), 0);
+	return next;
+}
+
+static void zram_obj_set_next(struct zram_class *c, struct zram_run *run,
+			      u16 idx, u16 next)
+{
+	zram_obj_copy(c, run, idx, &next, sizeof(next), 1);
+}
+
+static void zram_run_free(struct zram *zram, struct zram_run *run)
+{
+	int i;
+
+	for (i = 0; i < zram->classes[run->class].run_pages; i++) {
+		__free_page(run->pages[i]);
+		zram->stats.pool_pages--;
+	}
+	kfree(run);
+}
+
+static struct zram_run *zram_run_alloc(struct zram *zram, int class)
+{
+	struct zram_class *c = &zram->classes[class];
+	struct zram_run *run;
+	int i;
+
+	run = kzalloc(sizeof(*run), GFP_NOIO);
+	if (!run)
+		return NULL;
+	for (i = 0; i < c->run_pages; i++) {
+		run->pages[i] = alloc_page(GFP_NOIO | __GFP_HIGHMEM |
+					   __GFP_NOWARN);
+		if (!run->pages[i])
+			goto out_free;
+	}
+	run->class = class;
+	INIT_LIST_HEAD(&run->list);
+	for (i = 0; i < c->objs; i++)
+		zram_obj_set_next(c, run, i, i + 1 < c->objs ? i + 1 : ZRAM_OBJ_END);
+	return run;
+
+out_free:
+	while (--i >= 0)
+		__free_page(run->pages[i]);
+	kfree(run);
+	return NULL;
+}
+
+/*
+ * Get an object of at least size bytes. Returns with table_lock held
+ * on success.
+ */
+static int zram_pool_alloc(struct zram *zram, size_t size,
+			   struct zram_run **runp, u16 *idxp)
+{
+	int class = (size - 1) >> ZRAM_CLASS_SHIFT;
+	struct zram_class *c = &zram->classes[class];
+	struct zram_run *run;
+
+	spin_lock(&zram->table_lock);
+	if (list_empty(&c->runs)) {
+		spin_unlock(&zram->table_lock);
+		run = zram_run_alloc(zram, class);
+		if (!run)
+			return -ENOMEM;
+		spin_lock(&zram->table_lock);
+		list_add(&run->list, &c->runs);
+		zram->stats.pool_pages += c->run_pages;
+	}
+
+	run = list_first_entry(&c->runs, struct zram_run, list);
+	*runp = run;
+	*idxp = run->free;
+	run->free = zram_obj_next(c, run, run->free);
+	run->inuse++;
+	if (run->free == ZRAM_OBJ_END)
+		list_del_init(&run->list);
+	return 0;
+}
+
+/* Called with table_lock held */
+static void zram_pool_free(struct zram *zram, struct zram_run *run, u16 idx)
+{
+	struct zram_class *c = &zram->classes[run->class];
+
+	zram_obj_set_next(c, run, idx, run->free);
+	if (run->free == ZRAM_OBJ_END)
+		list_add(&run->list, &c->runs);
+	run->free = idx;
+	if (--run->inuse == 0) {
+		list_del(&run->list);
+		zram_run_free(zram, run);
+	}
+}
+
+/* Called with table_lock held */
+static void zram_free_slot(struct zram *zram, unsigned long index)
+{
+	struct zram_slot *slot = &zram->table[index];
+
+	if (slot->flags & ZRAM_ZERO) {
+		zram->stats.pages_zero--;
+	} else if (slot->flags & ZRAM_WHOLE) {
+		__free_page(slot->handle);
+		zram->stats.pages_whole--;
+	} else if (slot->handle) {
+		zram_pool_free(zram, slot->handle, slot->idx);
+		zram->stats.compr_size -= slot->size;
+		zram->stats.pages_stored--;
+	}
+	slot->handle = NULL;
+	slot->flags = 0;
+	slot->size = 0;
+}
+
+static int zram_page_zero(const void *p)
+{
+	const unsigned long *w = p;
+	int i;
+
+	for (i = 0; i < PAGE_SIZE / sizeof(*w); i++)
+		if (w[i])
+			return 0;
+	return 1;
+}
+
+static int zram_read(struct zram *zram, struct page *page, unsigned long index)
+{
+	struct zram_slot *slot = &zram->table[index];
+	size_t clen, dlen = PAGE_SIZE;
+	void *dst;
+	int ret;
+
+	spin_lock(&zram->table_lock);
+	if (!slot->handle) {
+		/* never written or zero: swap readahead may read those */
+		spin_unlock(&zram->table_lock);
+		clear_highpage(page);
+		return 0;
+	}
+	if (slot->flags & ZRAM_WHOLE) {
+		copy_highpage(page, slot->handle);
+		spin_unlock(&zram->table_lock);
+		return 0;
+	}
+	zram_obj_copy(&zram->classes[((struct zram_run *)slot->handle)->class],
+		      slot->handle, slot->idx, zram->cbuf, slot->size, 0);
+	clen = slot->size;
+	spin_unlock(&zram->table_lock);
+
+	dst = kmap_atomic(page, KM_USER0);
+	ret = lzo1x_decompress_safe(zram->cbuf, clen, dst, &dlen);
+	kunmap_atomic(dst, KM_USER0);
+	flush_dcache_page(page);
+
+	if (ret != LZO_E_OK || dlen != PAGE_SIZE) {
+		printk(KERN_ERR "zram: decompression of page %lu failed: %d\n",
+		       index, ret);
+		return -EIO;
+	}
+	return 0;
+}
+
+static int zram_write(struct zram *zram, struct page *page, unsigned long index)
+{
+	struct zram_slot *slot = &zram->table[index];
+	struct zram_run *run;
+	struct page *whole;
+	size_t clen;
+	void *src;
+	u16 idx;
+	int ret;
+
+	src = kmap_atomic(page, KM_USER0);
+	if (zram_page_zero(src)) {
+		kunmap_atomic(src, KM_USER0);
+		spin_lock(&zram->table_lock);
+		zram_free_slot(zram, index);
+		slot->flags = ZRAM_ZERO;
+		zram->stats.pages_zero++;
+		spin_unlock(&zram->table_lock);
+		return 0;
+	}
+	ret = lzo1x_1_compress(src, PAGE_SIZE, zram->cbuf, &clen,
+			       zram->workmem);
+	kunmap_atomic(src, KM_USER0);
+	if (ret != LZO_E_OK) {
+		printk(KERN_ERR "zram: compression of page %lu failed: %d\n",
+		       index, ret);
+		return -EIO;
+	}
+
+	if (clen > ZRAM_MAX_ZPAGE_SIZE) {
+		whole = alloc_page(GFP_NOIO | __GFP_HIGHMEM | __GFP_NOWARN);
+		if (!whole)
+			return -ENOMEM;
+		copy_highpage(whole, page);
+		spin_lock(&zram->table_lock);
+		zram_free_slot(zram, index);
+		slot->handle = whole;
+		slot->flags = ZRAM_WHOLE;
+		zram->stats.pages_whole++;
+		spin_unlock(&zram->table_lock);
+		return 0;
+	}
+
+	if (zram_pool_alloc(zram, clen, &run, &idx))
+		return -ENOMEM;
+	zram_obj_copy(&zram->classes[run->class], run, idx, zram->cbuf,
+		      clen, 1);
+	zram_free_slot(zram, index);
+	slot->handle = run;
+	slot->idx = idx;
+	slot->size = clen;
+	zram->stats.compr_size += clen;
+	zram->stats.pages_stored++;
+	spin_unlock(&zram->table_lock);
+	return 0;
+}
+
+static int zram_make_request(struct request_queue *q, struct bio *bio)
+{
+	struct zram *zram = q->queuedata;
+	unsigned long index;
+	struct bio_vec *bvec;
+	int rw, i, err = 0;
+
+	rw = bio_rw(bio);
+	if (rw == READA)
+		rw = READ;
+
+	index = bio->bi_sector >> PAGE_SECTORS_SHIFT;
+	if ((bio->bi_sector & (PAGE_SECTORS - 1)) ||
+	    (bio->bi_size & ~PAGE_MASK) ||
+	    index + (bio->bi_size >> PAGE_SHIFT) > zram->nr_pages) {
+		err = -EINVAL;
+		goto out;
+	}
+
+	mutex_lock(&zram->lock);
+	bio_for_each_segment(bvec, bio, i) {
+		if (bvec->bv_len != PAGE_SIZE || bvec->bv_offset) {
+			err = -EINVAL;
+			break;
+		}
+		if (rw == READ) {
+			zram->stats.num_reads++;
+			err = zram_read(zram, bvec->bv_page, index);
+			if (err)
+				zram->stats.failed_reads++;
+		} else {
+			zram->stats.num_writes++;
+			err = zram_write(zram, bvec->bv_page, index);
+			if (err)
+				zram->stats.failed_writes++;
+		}
+		if (err)
+			break;
+		index++;
+	}
+	mutex_unlock(&zram->lock);
+
+out:
+	if (err == -EINVAL)
+		zram->stats.invalid_io++;
+	bio_endio(bio, err);
+	return 0;
+}
+
+static void zram_slot_free_notify(struct block_device *bdev,
+				  unsigned long index)
+{
+	struct zram *zram = bdev->bd_disk->private_data;
+
+	if (index >= zram->nr_pages)
+		return;
+	spin_lock(&zram->table_lock);
+	zram_free_slot(zram, index);
+	zram->stats.notify_free++;
+	spin_unlock(&zram->table_lock);
+}
+
+static const struct block_device_operations zram_fops = {
+	.owner =		THIS_MODULE,
+	.swap_slot_free_notify = zram_slot_free_notify,
+};
+
+static struct zram *dev_to_zram(struct device *dev)
+{
+	return dev_to_disk(dev)->private_data;
+}
+
+#define ZRAM_STAT_ATTR(name, expr)					\
+static ssize_t name##_show(struct device *dev,				\
+			   struct device_attribute *attr, char *buf)	\
+{									\
+	struct zram *zram = dev_to_zram(dev);				\
+	unsigned long long val;						\
+									\
+	spin_lock(&zram->table_lock);					\
+	val = (expr);							\
+	spin_unlock(&zram->table_lock);					\
+	return sprintf(buf, "%llu\n", val);				\
+}									\
+static DEVICE_ATTR(name, S_IRUGO, name##_show, NULL)
+
+ZRAM_STAT_ATTR(disksize, (u64)zram->nr_pages << PAGE_SHIFT);
+ZRAM_STAT_ATTR(num_reads, zram->stats.num_reads);
+ZRAM_STAT_ATTR(num_writes, zram->stats.num_writes);
+ZRAM_STAT_ATTR(failed_reads, zram->stats.failed_reads);
+ZRAM_STAT_ATTR(failed_writes, zram->stats.failed_writes);
+ZRAM_STAT_ATTR(invalid_io, zram->stats.invalid_io);
+ZRAM_STAT_ATTR(notify_free, zram->stats.notify_free);
+ZRAM_STAT_ATTR(zero_pages, zram->stats.pages_zero);
+ZRAM_STAT_ATTR(orig_data_size,
+	(u64)(zram->stats.pages_stored + zram->stats.pages_whole) << PAGE_SHIFT);
+ZRAM_STAT_ATTR(compr_data_size,
+	zram->stats.compr_size + ((u64)zram->stats.pages_whole << PAGE_SHIFT));
+ZRAM_STAT_ATTR(mem_used_total,
+	(u64)(zram->stats.pool_pages + zram->stats.pages_whole) << PAGE_SHIFT);
+
+/* original size over memory used, in hundredths */
+static ssize_t compr_ratio_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	u64 orig, used;
+
+	spin_lock(&zram->table_lock);
+	orig = (u64)(zram->stats.pages_stored + zram->stats.pages_whole) << PAGE_SHIFT;
+	used = (u64)(zram->stats.pool_pages + zram->stats.pages_whole) << PAGE_SHIFT;
+	spin_unlock(&zram->table_lock);
+
+	if (!used)
+		return sprintf(buf, "0.00\n");
+	orig *= 100;
+	do_div(orig, used);
+	return sprintf(buf, "%u.%02u\n", (unsigned int)orig / 100,
+		       (unsigned int)orig % 100);
+}
+static DEVICE_ATTR(compr_ratio, S_IRUGO, compr_ratio_show, NULL);
+
+static struct attribute *zram_attrs[] = {
+	&dev_attr_disksize.attr,
+	&dev_attr_num_reads.attr,
+	&dev_attr_num_writes.attr,
+	&dev_attr_failed_reads.attr,
+	&dev_attr_failed_writes.attr,
+	&dev_attr_invalid_io.attr,
+	&dev_attr_notify_free.attr,
+	&dev_attr_zero_pages.attr,
+	&dev_attr_orig_data_size.attr,
+	&dev_attr_compr_data_size.attr,
+	&dev_attr_mem_used_total.attr,
+	&dev_attr_compr_ratio.attr,
+	NULL,
+};
+
+static struct attribute_group zram_attr_group = {
+	.attrs = zram_attrs,
+};
+
+/* Run length wasting the least of its pages for objects of size */
+static int zram_run_pages(int size)
+{
+	int i, best = 1, best_used = 0;
+
+	for (i = 1; i <= ZRAM_RUN_MAX_PAGES; i++) {
+		int bytes = i * PAGE_SIZE;
+		int used = (bytes / size) * size * 100 / bytes;
+
+		if (used > best_used) {
+			best_used = used;
+			best = i;
+		}
+	}
+	return best;
+}
+
+static void zram_free_device(struct zram *zram)
+{
+	unsigned long index;
+
+	if (zram->table) {
+		for (index = 0; index < zram->nr_pages; index++)
+			zram_free_slot(zram, index);
+		vfree(zram->table);
+	}
+	kfree(zram->workmem);
+	free_pages((unsigned long)zram->cbuf, 1);
+	if (zram->disk)
+		put_disk(zram->disk);
+	if (zram->queue)
+		blk_cleanup_queue(zram->queue);
+}
+
+static int zram_create_device(struct zram *zram, int id, u64 disksize)
+{
+	int i;
+
+	mutex_init(&zram->lock);
+	spin_lock_init(&zram->table_lock);
+	for (i = 0; i < ZRAM_NR_CLASSES; i++) {
+		struct zram_class *c = &zram->classes[i];
+
+		INIT_LIST_HEAD(&c->runs);
+		c->size = (i + 1) << ZRAM_CLASS_SHIFT;
+		c->run_pages = zram_run_pages(c->size);
+		c->objs = c->run_pages * PAGE_SIZE / c->size;
+	}
+
+	zram->nr_pages = disksize >> PAGE_SHIFT;
+	zram->table = vmalloc(zram->nr_pages * sizeof(*zram->table));
+	/* zram_free_device() walks the table even if the rest failed */
+	if (zram->table)
+		memset(zram->table, 0, zram->nr_pages * sizeof(*zram->table));
+	zram->workmem = kmalloc(LZO1X_1_MEM_COMPRESS, GFP_KERNEL);
+	/* compressed pages may be larger than PAGE_SIZE */
+	zram->cbuf = (void *)__get_free_pages(GFP_KERNEL, 1);
+	if (!zram->table || !zram->workmem || !zram->cbuf)
+		return -ENOMEM;
+
+	zram->queue = blk_alloc_queue(GFP_KERNEL);
+	if (!zram->queue)
+		return -ENOMEM;
+	zram->queue->queuedata = zram;
+	blk_queue_make_request(zram->queue, zram_make_request);
+	blk_queue_logical_block_size(zram->queue, PAGE_SIZE);
+	queue_flag_set_unlocked(QUEUE_FLAG_NONROT, zram->queue);
+
+	zram->disk = alloc_disk(1);
+	if (!zram->disk)
+		return -ENOMEM;
+	zram->disk->major = zram_major;
+	zram->disk->first_minor = id;
+	zram->disk->fops = &zram_fops;
+	zram->disk->queue = zram->queue;
+	zram->disk->private_data = zram;
+	snprintf(zram->disk->disk_name, 16, "zram%d", id);
+	set_capacity(zram->disk, zram->nr_pages << PAGE_SECTORS_SHIFT);
+	add_disk(zram->disk);
+
+	if (sysfs_create_group(&disk_to_dev(zram->disk)->kobj,
+			       &zram_attr_group))
+		printk(KERN_WARNING "zram%d: no sysfs statistics\n", id);
+	return 0;
+}
+
+static void zram_destroy_device(struct zram *zram)
+{
+	if (zram->disk && (zram->disk->flags & GENHD_FL_UP)) {
+		sysfs_remove_group(&disk_to_dev(zram->disk)->kobj,
+				   &zram_attr_group);
+		del_gendisk(zram->disk);
+	}
+	zram_free_device(zram);
+}
+
+static int __init zram_init(void)
+{
+	u64 disksize;
+	int i, ret;
+
+	if (!num_devices || num_devices > 16)
+		return -EINVAL;
+
+	disksize = (u64)disksize_kb << 10;
+	if (!disksize)
+		disksize = ((u64)totalram_pages << PAGE_SHIFT) / 4;
+	disksize &= PAGE_MASK;
+
+	zram_major = register_blkdev(0, "zram");
+	if (zram_major <= 0)
+		return -EBUSY;
+
+	zram_devices = kzalloc(num_devices * sizeof(*zram_devices), GFP_KERNEL);
+	if (!zram_devices) {
+		ret = -ENOMEM;
+		goto out_unregister;
+	}
+
+	for (i = 0; i < num_devices; i++) {
+		ret = zram_create_device(&zram_devices[i], i, disksize);
+		if (ret)
+			goto out_destroy;
+	}
+
+	printk(KERN_INFO "zram: %u device(s) of %llu kB\n", num_devices,
+	       (unsigned long long)disksize >> 10);
+	return 0;
+
+out_destroy:
+	while (i >= 0)
+		zram_destroy_device(&zram_devices[i--]);
+	kfree(zram_devices);
+out_unregister:
+	unregister_blkdev(zram_major, "zram");
+	return ret;
+}
+
+static void __exit zram_exit(void)
+{
+	int i;
+
+	for (i = 0; i < num_devices; i++)
+		zram_destroy_device(&zram_devices[i]);
+	kfree(zram_devices);
+	unregister_blkdev(zram_major, "zram");
+}
+
+module_init(zram_init);
+module_exit(zram_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Compressed RAM block device");
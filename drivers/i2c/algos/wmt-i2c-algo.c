@@ -35,6 +35,10 @@
 #include <linux/errno.h>
 #include <linux/i2c.h>
 #include <linux/i2c-id.h>
+#include <linux/i2c-algo-wmt.h>
+#include <linux/jiffies.h>
+#include <linux/sched.h>
+#include <linux/proc_fs.h>
 
 #include <mach/hardware.h>
 
@@ -51,6 +55,435 @@
 
 #endif
 
+#define WMT_I2C_XFER_TIMEOUT		500	/* ms per message */
+#define WMT_I2C_BUS_SPIN		100	/* us polled before sleeping */
+#define WMT_I2C_BUS_TIMEOUT		20	/* ms */
+
+extern unsigned int wmt_read_oscr(void);
+
+/*!*************************************************************************
+* wmt_i2c_port_init()
+*
+* Private Function
+*/
+/*!
+* \brief Software initial of a controller, registers are not touched
+*
+* \retval  NULL
+*/
+void wmt_i2c_port_init(
+	struct wmt_i2c_port *port, 	/*!<; //[IN] controller */
+	unsigned int base, 			/*!<; //[IN] register base */
+	int irq_no, 				/*!<; //[IN] controller IRQ */
+	unsigned short div			/*!<; //[IN] I2C_DIV_REG value */
+)
+{
+	port->regs = (struct i2c_regs_s *)base;
+	port->irq_no = irq_no;
+	port->div = div;
+	port->msgs = NULL;
+	init_waitqueue_head(&port->wait);
+	spin_lock_init(&port->lock);
+	memset(&port->stats, 0, sizeof(port->stats));
+}
+
+/*!*************************************************************************
+* wmt_i2c_port_set_mode()
+*
+* Private Function
+*/
+/*!
+* \brief set transfer mode (Fast/Fast plus/Standard)
+*
+* \retval  NULL
+*/
+void wmt_i2c_port_set_mode(
+	struct wmt_i2c_port *port, 	/*!<; //[IN] controller */
+	enum i2c_mode_e mode		/*!<; //[IN] mode */
+)
+{
+	port->i2c_mode = mode;
+
+	if (mode == I2C_STANDARD_MODE) {
+		DPRINTK("I2C: set standard mode \n");
+		port->regs->tr_reg = I2C_TR_STD_VALUE;
+	} else if (mode == I2C_FAST_MODE) {
+		DPRINTK("I2C: set fast mode \n");
+		port->regs->tr_reg = I2C_TR_FAST_VALUE;
+	} else if (mode == I2C_FAST_PLUS_MODE) {
+		DPRINTK("I2C: set fast mode plus \n");
+		port->regs->tr_reg = I2C_TR_FAST_PLUS_VALUE;
+	}
+}
+
+/*!*************************************************************************
+* wmt_i2c_port_reset()
+*
+* Private Function
+*/
+/*!
+* \brief Hardware initial, interrupts enabled and current mode timing
+*
+* \retval  NULL
+*/
+void wmt_i2c_port_reset(
+	struct wmt_i2c_port *port 	/*!<; //[IN] controller */
+)
+{
+	struct i2c_regs_s *regs = port->regs;
+	unsigned short tmp;
+
+	regs->cr_reg  = 0;
+	regs->div_reg = port->div;
+	regs->isr_reg = I2C_ISR_ALL_WRITE_CLEAR;   /* 0x0007*/
+	regs->imr_reg = I2C_IMR_ALL_ENABLE;        /* 0x0007*/
+
+	regs->cr_reg  = I2C_CR_ENABLE;
+	tmp = regs->csr_reg;                     /* read clear*/
+	regs->isr_reg = I2C_ISR_ALL_WRITE_CLEAR; /* 0x0007*/
+
+	wmt_i2c_port_set_mode(port, port->i2c_mode);
+	DPRINTK("Resetting I2C Controller Unit\n");
+}
+
+/*!*************************************************************************
+* wmt_i2c_port_wait_bus()
+*
+* Private Function
+*/
+/*!
+* \brief Wait for the STOP of the previous transfer. Poll shortly, then
+*        give the CPU away between checks.
+*
+* \retval 0 if success
+*/
+static int wmt_i2c_port_wait_bus(struct wmt_i2c_port *port)
+{
+	unsigned long timeout;
+	int spin;
+
+	for (spin = 0; spin < WMT_I2C_BUS_SPIN; spin++) {
+		if ((port->regs->csr_reg & I2C_STATUS_MASK) == I2C_READY)
+			return 0;
+		udelay(1);
+	}
+
+	timeout = jiffies + msecs_to_jiffies(WMT_I2C_BUS_TIMEOUT);
+	for (;;) {
+		if ((port->regs->csr_reg & I2C_STATUS_MASK) == I2C_READY)
+			return 0;
+		if (time_after(jiffies, timeout))
+			break;
+		schedule_timeout_uninterruptible(1);
+	}
+
+	printk(KERN_ERR "i2c_err : wait but not ready time-out (irq %d)\n", port->irq_no);
+	return -EBUSY;
+}
+
+/*
+ * Skip writes to the API probe address, they never go on the wire.
+ * Returns 0 when no message is left.
+ */
+static int wmt_i2c_port_skip(struct wmt_i2c_port *port)
+{
+	struct i2c_msg *pmsg;
+
+	while (port->cur < port->num) {
+		pmsg = &port->msgs[port->cur];
+		if ((pmsg->flags & I2C_M_RD) || pmsg->addr != WMT_I2C_API_I2C_ADDR)
+			return 1;
+		port->cur++;
+	}
+	return 0;
+}
+
+/*!*************************************************************************
+* wmt_i2c_port_start_msg()
+*
+* Private Function
+*/
+/*!
+* \brief Put address and first byte of port->msgs[port->cur] on the bus.
+*        Called with port->lock held, also from the interrupt handler for
+*        a repeated start.
+*
+* \retval  NULL
+*/
+static void wmt_i2c_port_start_msg(
+	struct wmt_i2c_port *port, 	/*!<; //[IN] controller */
+	int restart					/*!<; //[IN] bus is held from the previous message */
+)
+{
+	struct i2c_regs_s *regs = port->regs;
+	struct i2c_msg *pmsg = &port->msgs[port->cur];
+	unsigned short tcr_value;
+
+	port->pos = 0;
+
+	tcr_value = (unsigned short)(pmsg->addr & I2C_TCR_SLAVE_ADDR_MASK);
+	if (port->i2c_mode == I2C_FAST_MODE || port->i2c_mode == I2C_FAST_PLUS_MODE)
+		tcr_value |= I2C_TCR_FAST_MODE;
+
+	if (pmsg->flags & I2C_M_RD) {
+		tcr_value |= I2C_TCR_MASTER_READ;
+		regs->cr_reg &= ~(I2C_CR_TX_END | I2C_CR_TX_NEXT_NO_ACK);
+		if (restart == 0)
+			regs->cr_reg |= I2C_CR_CPU_RDY; /*release SCL*/
+		if (pmsg->len == 1)
+			regs->cr_reg |= I2C_CR_TX_NEXT_NO_ACK; /*only 8-bit to read*/
+	} else {
+		/* special case allow length:0, for i2c_smbus_xfer*/
+		if (pmsg->len == 0)
+			regs->cdr_reg = 0;
+		else
+			regs->cdr_reg = (unsigned short)(pmsg->buf[0] & I2C_CDR_DATA_WRITE_MASK);
+		if (restart == 0) {
+			regs->cr_reg &= ~(I2C_CR_TX_END); /*clear Tx end*/
+			regs->cr_reg |= I2C_CR_CPU_RDY; /*release SCL*/
+		}
+	}
+
+	regs->tcr_reg = tcr_value;
+
+	/*repeat start case*/
+	if (restart == 1)
+		regs->cr_reg |= I2C_CR_CPU_RDY;
+}
+
+/*!*************************************************************************
+* wmt_i2c_port_byte_end()
+*
+* Private Function
+*/
+/*!
+* \brief Advance the transfer by one byte, moves on to the next message
+*        with a repeated start when the current one is done.
+*
+* \retval 0 if success
+*/
+static int wmt_i2c_port_byte_end(struct wmt_i2c_port *port)
+{
+	struct i2c_regs_s *regs = port->regs;
+	struct i2c_msg *pmsg = &port->msgs[port->cur];
+	int last = (port->cur + 1 == port->num);
+
+	if (pmsg->flags & I2C_M_RD) {
+		pmsg->buf[port->pos++] = (regs->cdr_reg >> 8);
+		if (port->pos < pmsg->len) {
+			if (port->pos == pmsg->len - 1) /* next read is the last one*/
+				regs->cr_reg |= (I2C_CR_TX_NEXT_NO_ACK | I2C_CR_CPU_RDY);
+			else
+				regs->cr_reg |= I2C_CR_CPU_RDY;
+			return 0;
+		}
+	} else {
+		if ((regs->csr_reg & I2C_CSR_RCV_ACK_MASK) == I2C_CSR_RCV_NOT_ACK) {
+			DPRINTK("i2c_err : write RCV NACK error\n\r");
+			port->stats.nack++;
+			return -EIO;
+		}
+		if (pmsg->len == 0) {
+			regs->cr_reg = (I2C_CR_TX_END|I2C_CR_CPU_RDY|I2C_CR_ENABLE);
+		} else if (++port->pos < pmsg->len) {
+			regs->cdr_reg = (unsigned short)(pmsg->buf[port->pos] & I2C_CDR_DATA_WRITE_MASK);
+			regs->cr_reg = (I2C_CR_CPU_RDY | I2C_CR_ENABLE);
+			return 0;
+		} else if (last) {  /* stop case*/
+			regs->cr_reg = (I2C_CR_TX_END|I2C_CR_CPU_RDY|I2C_CR_ENABLE);
+		} else {  /* hold the bus for the restart*/
+			regs->cr_reg = I2C_CR_ENABLE;
+		}
+	}
+
+	port->stats.bytes += pmsg->len;
+	port->cur++;
+	if (wmt_i2c_port_skip(port))
+		wmt_i2c_port_start_msg(port, 1);
+	return 0;
+}
+
+/*!*************************************************************************
+* wmt_i2c_port_handler()
+*
+* Private Function
+*/
+/*!
+* \brief Controller interrupt, runs the transfer state machine and wakes
+*        up the caller when the last message is done or on error
+*
+* \retval  IRQ_HANDLED
+*/
+irqreturn_t wmt_i2c_port_handler(
+	int this_irq, 			/*!<; //[IN] IRQ number */
+	void *dev_id 			/*!<; //[IN] struct wmt_i2c_port */
+)
+{
+	struct wmt_i2c_port *port = dev_id;
+	struct i2c_regs_s *regs = port->regs;
+	unsigned short isr_status;
+	unsigned short tmp;
+	int ret = 0;
+
+	isr_status = regs->isr_reg;
+
+	spin_lock(&port->lock);
+	if (isr_status & I2C_ISR_NACK_ADDR) {
+		regs->isr_reg = I2C_ISR_NACK_ADDR_WRITE_CLEAR;
+		tmp = regs->csr_reg;  /* read clear*/
+		port->stats.nack++;
+		ret = -EIO;
+	}
+	if (isr_status & I2C_ISR_SCL_TIME_OUT) {
+		regs->isr_reg = I2C_ISR_SCL_TIME_OUT_WRITE_CLEAR;
+		port->stats.scl_timeout++;
+		ret = -ETIMEDOUT;
+	}
+	if (isr_status & I2C_ISR_BYTE_END)
+		regs->isr_reg = I2C_ISR_BYTE_END_WRITE_CLEAR;
+	else if (ret == 0) {
+		DPRINTK("i2c_err : unknown I2C ISR Handle 0x%4.4X", isr_status);
+		goto out;
+	}
+
+	/* nothing in flight, e.g. the caller already gave up */
+	if (port->msgs == NULL)
+		goto out;
+
+	if (ret == 0)
+		ret = wmt_i2c_port_byte_end(port);
+	if (ret < 0 || port->cur == port->num) {
+		port->result = ret;
+		port->msgs = NULL;
+		wake_up(&port->wait);
+	}
+out:
+	spin_unlock(&port->lock);
+	return IRQ_HANDLED;
+}
+
+/*!*************************************************************************
+* wmt_i2c_port_xfer()
+*
+* Private Function
+*/
+/*!
+* \brief Run a whole message array, messages after the first one use a
+*        repeated start
+*
+* \retval  number of messages if success
+*/
+int wmt_i2c_port_xfer(
+	struct wmt_i2c_port *port, 	/*!<; //[IN] controller */
+	struct i2c_msg msgs[], 		/*!<; //[IN] transfer data  */
+	int num						/*!<; //[IN] transfer data length */
+)
+{
+	struct wmt_i2c_stats *stats = &port->stats;
+	unsigned long flags;
+	unsigned int start_time, lat;
+	int ret, i;
+
+	if (port->enabled == 0)
+		return -ENXIO;
+	for (i = 0; i < num; i++) {
+		if ((msgs[i].flags & I2C_M_RD) && msgs[i].len == 0)
+			return -EINVAL;
+	}
+
+	start_time = wmt_read_oscr();
+	stats->xfers++;
+	stats->msgs += num;
+
+	/* first message for the wire, see wmt_i2c_port_skip() */
+	for (i = 0; i < num; i++) {
+		if ((msgs[i].flags & I2C_M_RD) || msgs[i].addr != WMT_I2C_API_I2C_ADDR)
+			break;
+	}
+	if (i == num)
+		return num;
+
+	ret = wmt_i2c_port_wait_bus(port);
+	if (ret < 0) {
+		stats->bus_busy++;
+		goto out;
+	}
+
+	spin_lock_irqsave(&port->lock, flags);
+	port->result = 0;
+	port->num = num;
+	port->cur = i;
+	port->msgs = msgs;
+	wmt_i2c_port_start_msg(port, 0);
+	spin_unlock_irqrestore(&port->lock, flags);
+
+	wait_event_timeout(port->wait, port->msgs == NULL,
+		msecs_to_jiffies(WMT_I2C_XFER_TIMEOUT * num));
+
+	spin_lock_irqsave(&port->lock, flags);
+	if (port->msgs != NULL) {
+		DPRINTK("i2c_err : software timeout, msg %d byte %d\n", port->cur, port->pos);
+		port->msgs = NULL;
+		stats->sw_timeout++;
+		ret = -ETIMEDOUT;
+	} else
+		ret = port->result;
+	spin_unlock_irqrestore(&port->lock, flags);
+
+out:
+	if (ret < 0) {
+		stats->errors++;
+		return ret;
+	}
+	lat = (wmt_read_oscr() - start_time) / (CLOCK_TICK_RATE / 1000000);
+	stats->lat_last = lat;
+	stats->lat_sum += lat;
+	if (lat > stats->lat_max)
+		stats->lat_max = lat;
+	return num;
+}
+
+/*!*************************************************************************
+* wmt_i2c_read_proc()
+*
+* Private Function
+*/
+/*!
+* \brief Show transfer statistics in /proc/wmt-i2c<nr>
+*
+* \retval  length of data
+*/
+static int wmt_i2c_read_proc(char *page, char **start, off_t off, int count, int *eof, void *data)
+{
+	struct wmt_i2c_port *port = data;
+	struct wmt_i2c_stats *stats = &port->stats;
+	unsigned long long avg = 0;
+	unsigned long good;
+	char *p = page;
+
+	good = stats->xfers - stats->errors;
+	if (good) {
+		avg = stats->lat_sum;
+		do_div(avg, good);
+	}
+
+	p += sprintf(p, "mode        : %s\n",
+		(port->i2c_mode == I2C_FAST_PLUS_MODE) ? "fast plus" :
+		(port->i2c_mode == I2C_FAST_MODE) ? "fast" : "standard");
+	p += sprintf(p, "xfers       : %lu\n", stats->xfers);
+	p += sprintf(p, "msgs        : %lu\n", stats->msgs);
+	p += sprintf(p, "bytes       : %lu\n", stats->bytes);
+	p += sprintf(p, "errors      : %lu\n", stats->errors);
+	p += sprintf(p, "nack        : %lu\n", stats->nack);
+	p += sprintf(p, "scl timeout : %lu\n", stats->scl_timeout);
+	p += sprintf(p, "sw timeout  : %lu\n", stats->sw_timeout);
+	p += sprintf(p, "bus busy    : %lu\n", stats->bus_busy);
+	p += sprintf(p, "latency us  : last %u max %u avg %llu\n",
+		stats->lat_last, stats->lat_max, avg);
+
+	*eof = 1;
+	return p - page;
+}
 /*!*************************************************************************
 * wmt_i2c_valid_messages()
 *
@@ -109,6 +542,8 @@ static int wmt_i2c_do_xfer(
 	int ret = 0 ;
 
 	adap = i2c_adap->algo_data;
+	if (adap->port)
+		return wmt_i2c_port_xfer(adap->port, msgs, num);
 
 	/*ret = adap->wait_bus_not_busy();*/
 	for (i = 0 ; i < 10; ++i)
@@ -258,6 +693,8 @@ struct i2c_algorithm wmt_i2c_algorithm  = {
 */
 int wmt_i2c_add_bus(struct i2c_adapter *i2c_adap)
 {
+	struct i2c_algo_wmt_data *adap = i2c_adap->algo_data;
+
 	printk(KERN_INFO"i2c: adding %s.\n", i2c_adap->name);
 
 	i2c_adap->algo = &wmt_i2c_algorithm;
@@ -268,6 +705,12 @@ int wmt_i2c_add_bus(struct i2c_adapter *i2c_adap)
 	*/
 	i2c_add_numbered_adapter(i2c_adap);
 
+	if (adap->port) {
+		sprintf(adap->port->proc_name, "wmt-i2c%d", i2c_adap->nr);
+		create_proc_read_entry(adap->port->proc_name, 0, NULL,
+			wmt_i2c_read_proc, adap->port);
+	}
+
 	/* adap->reset();*/
 
 	return 0;
@@ -284,11 +727,15 @@ int wmt_i2c_add_bus(struct i2c_adapter *i2c_adap)
 */
 int wmt_i2c_del_bus(struct i2c_adapter *i2c_adap)
 {
+	struct i2c_algo_wmt_data *adap = i2c_adap->algo_data;
 	int res;
 	res = i2c_del_adapter(i2c_adap);
 	if (res < 0)
 		return res;
 
+	if (adap->port)
+		remove_proc_entry(adap->port->proc_name, NULL);
+
 	printk(KERN_INFO "i2c: removing %s.\n", i2c_adap->name);
 
 	return 0;
@@ -311,6 +758,11 @@ static int __init wmt_i2c_algo_init(void)
 
 EXPORT_SYMBOL(wmt_i2c_add_bus);
 EXPORT_SYMBOL(wmt_i2c_del_bus);
+EXPORT_SYMBOL(wmt_i2c_port_init);
+EXPORT_SYMBOL(wmt_i2c_port_reset);
+EXPORT_SYMBOL(wmt_i2c_port_set_mode);
+EXPORT_SYMBOL(wmt_i2c_port_xfer);
+EXPORT_SYMBOL(wmt_i2c_port_handler);
 
 MODULE_AUTHOR("VIA RISC & DSP SW Team");
 MODULE_DESCRIPTION("WMT I2C ALGO Driver");
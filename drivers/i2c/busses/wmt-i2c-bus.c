@@ -40,6 +40,7 @@
 #include <linux/delay.h>
 #include <linux/errno.h>
 #include <linux/interrupt.h>
+#include <linux/i2c-algo-wmt.h>
 
 #include <mach/hardware.h>
 #include <asm/irq.h>
@@ -59,25 +60,10 @@
 #endif
 
 
-#define MAX_BUS_READY_CNT		50	  /* jiffy*/
-#define MAX_TX_TIMEOUT			500   /* ms*/
-#define MAX_RX_TIMEOUT			500	  /* ms*/
 #define PMC_ClOCK_ENABLE_LOWER          0xd8130250
 #define CTRL_I2C                        0xD8110000
 #define PU_CTRL_I2C                     0xD8110600
 
-extern unsigned int wmt_read_oscr(void);
-struct wmt_i2c_s {
-	struct i2c_regs_s *regs;
-	int irq_no ;
-	enum i2c_mode_e i2c_mode ;
-	int volatile isr_nack ;
-	int volatile isr_byte_end ;
-	int volatile isr_timeout ;
-	int volatile isr_int_pending ;
-};
-
-static int i2c_wmt_wait_bus_not_busy(void);
 extern int wmt_getsyspara(char *varname, unsigned char *varval, int *varlen);
 static unsigned int speed_mode = 0;
 unsigned int wmt_i2c0_speed_mode = 0;
@@ -88,17 +74,15 @@ EXPORT_SYMBOL(wmt_i2c0_is_master);
 /**/
 /*  variable*/
 /*-------------------------------------------------*/
-static volatile struct wmt_i2c_s i2c ;
+static struct wmt_i2c_port i2c ;
 
-DECLARE_WAIT_QUEUE_HEAD(i2c_wait);
-spinlock_t i2c_wmt_irqlock = SPIN_LOCK_UNLOCKED;
 /*!*************************************************************************
 * i2c_wmt_set_mode()
 *
 * Private Function by Paul Kwong, 2007/1/12
 */
 /*!
-* \brief set transfer mode (Fast/Standard/HS)
+* \brief set transfer mode (Fast/Fast plus/Standard)
 *
 * \retval  NULL
 */
@@ -106,394 +90,7 @@ static void i2c_wmt_set_mode(enum i2c_mode_e mode  /*!<; //[IN] mode */)
 {
 	if (is_master == 0)
 		return;
-	i2c.i2c_mode = mode ;
-
-	if (i2c.i2c_mode == I2C_STANDARD_MODE)  {
-		DPRINTK("I2C: set standard mode \n");
-		i2c.regs->tr_reg = I2C_TR_STD_VALUE ;   /* 0x8041*/
-	} else if (i2c.i2c_mode == I2C_FAST_MODE) {
-		DPRINTK("I2C: set fast mode \n");
-		i2c.regs->tr_reg = I2C_TR_FAST_VALUE ; /* 0x8011*/
-	}
-}
-
-
-/*!*************************************************************************
-* i2c_wmt_read_msg()
-*
-* Private Function by Paul Kwong, 2007/1/12
-*/
-/*!
-* \brief Read message from slave
-*
-* \retval 0 if success
-*/
-static int i2c_wmt_read_msg(
-	unsigned int slave_addr, 	/*!<; //[IN] Salve address */
-	char *buf, 				/*!<; //[OUT] Pointer to data */
-	unsigned int length,		/*!<; //Data length */
-	int restart, 				/*!<; //Need to restart after a complete read */
-	int last 					/*!<; //Last read */
-)
-{
-	unsigned short tcr_value ;
-	unsigned int xfer_length ;
-	int is_timeout ;
-	int ret  = 0 ;
-	int wait_event_result  = 0 ;
-
-	if (is_master == 0)
-		return -ENXIO;
-	if (length <= 0)
-		return -1 ;
-	xfer_length = 0 ;
-
-	if (restart == 0)
-		ret = i2c_wmt_wait_bus_not_busy()  ;
-	if (ret < 0)
-		return ret ;
-
-	i2c.isr_nack    	= 0 ;
-	i2c.isr_byte_end	= 0 ;
-	i2c.isr_timeout 	= 0 ;
-	i2c.isr_int_pending = 0;
-
-	i2c.regs->cr_reg &= ~(I2C_CR_TX_END); /*clear Tx end*/
-	i2c.regs->cr_reg &= ~(I2C_CR_TX_NEXT_NO_ACK); /*clear NEXT_NO_ACK*/
-	if (restart == 0)
-		i2c.regs->cr_reg |= (I2C_CR_CPU_RDY); /*release SCL*/
-
-	tcr_value = 0 ;
-	if (i2c.i2c_mode == I2C_STANDARD_MODE)  {
-		tcr_value = (unsigned short)(I2C_TCR_STANDARD_MODE|I2C_TCR_MASTER_READ |\
-				(slave_addr & I2C_TCR_SLAVE_ADDR_MASK)) ;
-	} else if (i2c.i2c_mode == I2C_FAST_MODE) {
-		tcr_value = (unsigned short)(I2C_TCR_FAST_MODE|I2C_TCR_MASTER_READ |\
-				(slave_addr & I2C_TCR_SLAVE_ADDR_MASK)) ;
-	}
-	if (length == 1)
-		i2c.regs->cr_reg |= I2C_CR_TX_NEXT_NO_ACK; /*only 8-bit to read*/
-
-	i2c.regs->tcr_reg = tcr_value ;
-
-	/*repeat start case*/
-	if (restart == 1)
-		i2c.regs->cr_reg |= (I2C_CR_CPU_RDY); /*release SCL*/
-
-	ret  = 0 ;
-	for (; ;) {
-		is_timeout = 0 ;
-		/*
-		wait_event_result = wait_event_interruptible_timeout(i2c_wait, i2c.isr_int_pending ,
-			(MAX_RX_TIMEOUT * HZ / 1000)) ;
-		*/
-		wait_event_result = wait_event_timeout(i2c_wait, i2c.isr_int_pending ,
-			(MAX_RX_TIMEOUT * HZ / 1000)) ;
-		if (likely(wait_event_result > 0)) {
-			DPRINTK("I2C: wait interrupted (rx) \n");
-			ret  = 0 ;
-		} else if (likely(i2c.isr_int_pending == 0)) {
-			DPRINTK("I2C: wait timeout (rx) \n");
-			is_timeout = 1 ;
-			ret = -ETIMEDOUT ;
-		}
-
-		/**/
-		/* fail case*/
-		/**/
-		if (i2c.isr_nack == 1) {
-			DPRINTK("i2c_err : write NACK error (rx) \n\r") ;
-			ret = -EIO ;
-			break ;
-		}
-		if (i2c.isr_timeout == 1) {
-			DPRINTK("i2c_err : write SCL timeout error (rx)\n\r") ;
-			ret = -ETIMEDOUT ;
-			break ;
-		}
-		if (is_timeout == 1) {
-			DPRINTK("i2c_err: write software timeout error (rx) \n\r") ;
-			ret = -ETIMEDOUT ;
-			break ;
-		}
-
-
-		/**/
-		/* pass case*/
-		/**/
-		if (i2c.isr_byte_end == 1) {
-			buf[xfer_length] = (i2c.regs->cdr_reg >> 8) ;
-			++xfer_length ;
-			DPRINTK("i2c_test: received BYTE_END\n\r");
-		}
-		i2c.isr_int_pending = 0;
-		i2c.isr_nack    	= 0 ;
-		i2c.isr_byte_end	= 0 ;
-		i2c.isr_timeout 	= 0 ;
-
-		if (length > xfer_length) {
-			if ((length - 1) ==  xfer_length) { /* next read is the last one*/
-				i2c.regs->cr_reg |= (I2C_CR_TX_NEXT_NO_ACK | I2C_CR_CPU_RDY);
-				DPRINTK("i2c_test: set CPU_RDY & TX_ACK. next data is last.\r\n");
-			} else {
-				i2c.regs->cr_reg |= I2C_CR_CPU_RDY ;
-				DPRINTK("i2c_test: more data to read. only set CPU_RDY. \r\n");
-			}
-		} else if (length == xfer_length) { /* end rx xfer*/
-			if (last == 1) {  /* stop case*/
-				DPRINTK("i2c_test: read completed \r\n");
-				break ;
-			} else {  /* restart case*/
-				/* ??? how to handle the restart after read ?*/
-				DPRINTK("i2c_test: RX ReStart Case \r\n") ;
-				break ;
-			}
-		} else {
-			DPRINTK("i2c_err : read known error\n\r") ;
-			ret = -EIO ;
-			break ;
-		}
-	}
-
-	DPRINTK("i2c_test: read sequence completed\n\r");
-	return ret ;
-}
-
-/*!*************************************************************************
-* i2c_wmt_write_msg()
-*
-* Private Function by Paul Kwong, 2007/1/12
-*/
-/*!
-* \brief Write message to slave
-*
-* \retval 0 if success
-*/
-static int i2c_wmt_write_msg(
-	unsigned int slave_addr, 	/*!<; //[IN] Salve address */
-	char *buf, 				/*!<; //[OUT] Pointer to data */
-	unsigned int length,		/*!<; //Data length */
-	int restart, 				/*!<; //Need to restart after a complete write */
-	int last 					/*!<; //Last read */
-)
-{
-	unsigned short tcr_value ;
-	unsigned int xfer_length ;
-	int is_timeout ;
-	int ret = 0 ;
-	int wait_event_result ;
-
-	DPRINTK("length = %d , slave_addr = %x\n", length , slave_addr);
-	if (slave_addr == WMT_I2C_API_I2C_ADDR)
-		return ret ;
-
-	if (is_master == 0)
-		return -ENXIO;
-
-	/* special case allow length:0, for i2c_smbus_xfer*/
-	/**/
-	if (length < 0)
-		return -1 ;
-	xfer_length = 0 ; /* for array index and also for checking counting*/
-	if (restart == 0)
-		ret = i2c_wmt_wait_bus_not_busy()  ;
-	if (ret < 0)
-		return ret ;
-
-	i2c.isr_nack    	= 0 ;
-	i2c.isr_byte_end	= 0 ;
-	i2c.isr_timeout 	= 0 ;
-	i2c.isr_int_pending = 0;
-
-	/**/
-	/* special case allow length:0, for i2c_smbus_xfer*/
-	/**/
-	if (length == 0)
-		i2c.regs->cdr_reg = 0 ;
-	else
-		i2c.regs->cdr_reg = (unsigned short)(buf[xfer_length] & I2C_CDR_DATA_WRITE_MASK)  ;
-
-	if (restart == 0) {
-		i2c.regs->cr_reg &= ~(I2C_CR_TX_END); /*clear Tx end*/
-		i2c.regs->cr_reg |= (I2C_CR_CPU_RDY); /*release SCL*/
-	}
-
-	/**/
-	/* I2C: Set transfer mode [standard/fast]*/
-	/**/
-	tcr_value = 0 ;
-	if (i2c.i2c_mode == I2C_STANDARD_MODE)
-		tcr_value = (unsigned short)(I2C_TCR_STANDARD_MODE|I2C_TCR_MASTER_WRITE |\
-				(slave_addr & I2C_TCR_SLAVE_ADDR_MASK)) ;
-	else if (i2c.i2c_mode == I2C_FAST_MODE)
-		tcr_value = (unsigned short)(I2C_TCR_FAST_MODE|I2C_TCR_MASTER_WRITE |\
-				(slave_addr & I2C_TCR_SLAVE_ADDR_MASK)) ;
-
-	i2c.regs->tcr_reg = tcr_value ;
-
-	if ( restart == 1 ) {
-	    i2c.regs->cr_reg |= I2C_CR_CPU_RDY ;
-	}
-
-	ret  = 0 ;
-	for (; ;) {
-
-		is_timeout = 0 ;
-		/**/
-		/* I2C: Wait for interrupt. if ( i2c.isr_int_pending == 1 ) ==> an interrupt exsits.*/
-		/**/
-		/*
-		wait_event_result = wait_event_interruptible_timeout(i2c_wait, i2c.isr_int_pending , (MAX_TX_TIMEOUT * HZ / 1000)) ;
-		*/
-		wait_event_result = wait_event_timeout(i2c_wait, i2c.isr_int_pending , (MAX_TX_TIMEOUT * HZ / 1000)) ;
-
-		if (likely(wait_event_result > 0)) {
-			DPRINTK("I2C: wait interrupted (tx)\n");
-			ret  = 0 ;
-		} else if (likely(i2c.isr_int_pending == 0)) {
-			DPRINTK("I2C: wait timeout (tx) \n");
-			is_timeout = 1 ;
-			ret = -ETIMEDOUT ;
-		}
-
-		/**/
-		/* fail case*/
-		/**/
-		if (i2c.isr_nack == 1) {
-			DPRINTK("i2c_err : write NACK error (tx) \n\r") ;
-			ret = -EIO ;
-			break ;
-		}
-		if (i2c.isr_timeout == 1) {
-			DPRINTK("i2c_err : write SCL timeout error (tx)\n\r") ;
-			ret = -ETIMEDOUT ;
-			break ;
-		}
-		if (is_timeout == 1) {
-			DPRINTK("i2c_err : write software timeout error (tx)\n\r") ;
-			ret = -ETIMEDOUT ;
-			break ;
-		}
-
-		/**/
-		/* pass case*/
-		/**/
-		if (i2c.isr_byte_end == 1) {
-			DPRINTK("i2c: isr end byte (tx)\n\r") ;
-			++xfer_length ;
-		}
-		i2c.isr_int_pending = 0 ;
-		i2c.isr_nack    	= 0 ;
-		i2c.isr_byte_end	= 0 ;
-		i2c.isr_timeout 	= 0 ;
-
-
-		if ((i2c.regs->csr_reg & I2C_CSR_RCV_ACK_MASK) == I2C_CSR_RCV_NOT_ACK) {
-			DPRINTK("i2c_err : write RCV NACK error\n\r") ;
-			ret = -EIO ;
-			break ;
-		}
-
-		/**/
-		/* special case allow length:0, for i2c_smbus_xfer*/
-		/**/
-		if (length == 0) {
-			i2c.regs->cr_reg = (I2C_CR_TX_END|I2C_CR_CPU_RDY|I2C_CR_ENABLE) ;
-			break ;
-		}
-		if (length > xfer_length) {
-			i2c.regs->cdr_reg = (unsigned short) (buf[xfer_length] & I2C_CDR_DATA_WRITE_MASK) ;
-			i2c.regs->cr_reg = (I2C_CR_CPU_RDY | I2C_CR_ENABLE) ;
-			DPRINTK("i2c_test: write register data \n\r") ;
-		} else if (length == xfer_length) { /* end tx xfer*/
-			if (last == 1) {  /* stop case*/
-				i2c.regs->cr_reg = (I2C_CR_TX_END|I2C_CR_CPU_RDY|I2C_CR_ENABLE) ;
-				DPRINTK("i2c_test: finish write \n\r") ;
-				break ;
-			} else {  /* restart case*/
-				/* handle the restart for first write then the next is read*/
-				i2c.regs->cr_reg = (I2C_CR_ENABLE) ;
-				DPRINTK("i2c_test: tx restart Case \n\r") ;
-				break ;
-			}
-		} else {
-			DPRINTK("i2c_err : write unknown error\n\r") ;
-			ret = -EIO ;
-			break ;
-		}
-	} ;
-
-	DPRINTK("i2c_test: write sequence completed\n\r");
-
-	return ret ;
-}
-
-
-/*!*************************************************************************
-* i2c_wmt_wait_bus_not_busy
-*
-* Private Function by Paul Kwong, 2007/1/12
-*/
-/*!
-*
-* \retval 0 if success
-*/
-static int i2c_wmt_wait_bus_not_busy(void)
-{
-	int ret ;
-	int cnt ;
-
-	unsigned int start_time, end_time;
-	ret = 0 ;
-	cnt = 0 ;
-	start_time = wmt_read_oscr();
-	while (1) {
-		if ((REG16_VAL(I2C_CSR_ADDR) & I2C_STATUS_MASK) == I2C_READY)
-			break ;
-		udelay(1);
-		end_time = wmt_read_oscr();
-		if (start_time > end_time) {
-			start_time = wmt_read_oscr();
-			continue;
-		}
-		if (end_time - start_time > 60000) {/*20ms*/
-			ret = (-EBUSY) ;
-			printk("i2c_err0 : wait but not ready time-out\n\r") ;
-			break;
-		}
-	}
-#if 0
-	DECLARE_WAITQUEUE(wait, current) ;
-	if (is_master == 0)
-		return 0;
-	add_wait_queue(&i2c_wait, &wait) ;
-
-	ret = 0 ;
-	cnt = 0 ;
-	while (1) {
-		if ((REG16_VAL(I2C_CSR_ADDR) & I2C_STATUS_MASK) == I2C_READY)
-			break ;
-
-		set_current_state(TASK_INTERRUPTIBLE);
-		if (signal_pending(current))
-			break;
-
-		schedule_timeout(1);
-		cnt++ ;
-
-		if (cnt > MAX_BUS_READY_CNT) {
-			ret = (-EBUSY) ;
-			printk("i2c_err : wait but not ready time-out\n\r") ;
-			break;
-		}
-	};
-
-	set_current_state(TASK_RUNNING);
-
-	remove_wait_queue(&i2c_wait, &wait);
-#endif
-
-	return ret ;
+	wmt_i2c_port_set_mode(&i2c, mode);
 }
 
 
@@ -509,110 +106,16 @@ static int i2c_wmt_wait_bus_not_busy(void)
 */
 static void i2c_wmt_reset(void)
 {
-	unsigned short tmp ;
 	if (is_master == 0)
 		return;
 
-	/**/
-	/* software initial*/
-	/**/
-	i2c.regs        = (struct i2c_regs_s *)I2C0_BASE_ADDR ;
-	i2c.irq_no      = IRQ_I2C ;
 	if (speed_mode == 0)
 		i2c.i2c_mode    = I2C_STANDARD_MODE ;
-	else
+	else if (speed_mode == 1)
 		i2c.i2c_mode    = I2C_FAST_MODE ;
-	i2c.isr_nack    = 0 ;
-	i2c.isr_byte_end = 0 ;
-	i2c.isr_timeout = 0 ;
-	i2c.isr_int_pending = 0;
-
-	/**/
-	/* hardware initial*/
-	/**/
-
-
-
-	i2c.regs->cr_reg  = 0 ;
-	//i2c.regs->div_reg = APB_96M_I2C_DIV ;
-
-	i2c.regs->div_reg = APB_166M_I2C_DIV  ;
-	i2c.regs->isr_reg = I2C_ISR_ALL_WRITE_CLEAR ;   /* 0x0007*/
-	i2c.regs->imr_reg = I2C_IMR_ALL_ENABLE ;        /* 0x0007*/
-
-	i2c.regs->cr_reg  = I2C_CR_ENABLE ;
-	tmp = i2c.regs->csr_reg ;                     /* read clear*/
-	i2c.regs->isr_reg = I2C_ISR_ALL_WRITE_CLEAR ; /* 0x0007*/
-
-	if (i2c.i2c_mode == I2C_STANDARD_MODE)
-		i2c.regs->tr_reg = I2C_TR_STD_VALUE ;   /* 0x8041*/
-	else if (i2c.i2c_mode == I2C_FAST_MODE)
-		i2c.regs->tr_reg = I2C_TR_FAST_VALUE ; /* 0x8011*/
-
-	DPRINTK("Resetting I2C Controller Unit\n");
-
-	return ;
-}
-
-/*!*************************************************************************
-* i2c_wmt_handler()
-*
-* Private Function by Paul Kwong, 2007/1/12
-*/
-/*!
-* \brief Check isr_reg status, then clear  i2c.isr_int_pending
-*
-* \retval  IRQ_HANDLED
-*/
-static irqreturn_t i2c_wmt_handler(
-	int this_irq, 			/*!<; //[IN] IRQ number */
-	void *dev_id 		/*!<; //[IN] Pointer to device ID */
-)
-{
-
-	int wakeup ;
-	unsigned short isr_status ;
-	unsigned short tmp ;
-	unsigned long flags;
-
-	isr_status = i2c.regs->isr_reg ;
-	wakeup = 0 ;
-
-	/*
-	* CPU_RDY did not auto clear with 3426 A0
-	* it would be fix up.
-	*/
-	/*i2c.regs->cr_reg = ~(I2C_CR_CPU_RDY) ;*/
-
-	if (isr_status & I2C_ISR_NACK_ADDR) {
-		i2c.regs->isr_reg = I2C_ISR_NACK_ADDR_WRITE_CLEAR ;
-		tmp = i2c.regs->csr_reg ;  /* read clear*/
-		i2c.isr_nack = 1 ;
-		wakeup = 1 ;
-	}
-
-	if (isr_status & I2C_ISR_BYTE_END) {
-		i2c.regs->isr_reg = I2C_ISR_BYTE_END_WRITE_CLEAR ;
-		i2c.isr_byte_end = 1 ;
-		wakeup = 1;
-	}
-
-	if (isr_status & I2C_ISR_SCL_TIME_OUT) {
-		i2c.regs->isr_reg = I2C_ISR_SCL_TIME_OUT_WRITE_CLEAR ;
-		i2c.isr_timeout = 1 ;
-		wakeup = 1;
-	}
-
-
-	if (wakeup) {
-		spin_lock_irqsave(&i2c_wmt_irqlock, flags);
-		i2c.isr_int_pending = 1;
-		spin_unlock_irqrestore(&i2c_wmt_irqlock, flags);
-		/*wake_up_interruptible(&i2c_wait);*/
-		wake_up(&i2c_wait);
-	} else
-		DPRINTK("i2c_err : unknown I2C ISR Handle 0x%4.4X" , isr_status) ;
-	return IRQ_HANDLED;
+	else
+		i2c.i2c_mode    = I2C_FAST_PLUS_MODE ;
+	wmt_i2c_port_reset(&i2c);
 }
 
 /*!*************************************************************************
@@ -630,7 +133,7 @@ static int i2c_wmt_resource_init(void)
 	/* IRQ_I2C  19*/
 	if (is_master == 0)
 		return 0;
-	if (request_irq(i2c.irq_no , &i2c_wmt_handler, IRQF_DISABLED, "i2c", 0) < 0) {
+	if (request_irq(i2c.irq_no , &wmt_i2c_port_handler, IRQF_DISABLED, "i2c", &i2c) < 0) {
 		DPRINTK(KERN_INFO "I2C: Failed to register I2C irq %i\n", i2c.irq_no);
 		return -ENODEV;
 	}
@@ -651,7 +154,7 @@ static void i2c_wmt_resource_release(void)
 {
 	if (is_master == 0)
 		return;
-	free_irq(i2c.irq_no, 0);
+	free_irq(i2c.irq_no, &i2c);
 }
 
 #if 0
@@ -687,11 +190,9 @@ static int i2c_wmt_client_unregister(struct i2c_client *client)
 #endif
 
 static struct i2c_algo_wmt_data i2c_wmt_data = {
-	write_msg:          i2c_wmt_write_msg,
-	read_msg:           i2c_wmt_read_msg,
-	wait_bus_not_busy:  i2c_wmt_wait_bus_not_busy,
 	reset:              i2c_wmt_reset,
 	set_mode:		i2c_wmt_set_mode,
+	port:               &i2c,
 	udelay:             I2C_ALGO_UDELAY,
 	timeout:            I2C_ALGO_TIMEOUT,
 };
@@ -724,7 +225,6 @@ extern int wmt_i2c_del_bus(struct i2c_adapter *);
 */
 static int __init i2c_adap_wmt_init(void)
 {
-	unsigned short tmp ;
 	char varname[] = "wmt.i2c.param";
 #ifdef CONFIG_I2C_SLAVE_WMT
 	char varname1[] = "wmt.bus.i2c.slave_port";
@@ -772,24 +272,22 @@ static int __init i2c_adap_wmt_init(void)
 				ret = sscanf(buf + idx, ",%x:%x", &port_num, &speed_mode);
 			}
 		}
-		if (speed_mode > 1)
+		if (speed_mode > 2)
 			speed_mode = 0;
 		wmt_i2c0_speed_mode = speed_mode;
 
 		/**/
 		/* software initial*/
 		/**/
-		i2c.regs        = (struct i2c_regs_s *)I2C0_BASE_ADDR ;
-		i2c.irq_no      = IRQ_I2C ;
+		wmt_i2c_port_init(&i2c, I2C0_BASE_ADDR, IRQ_I2C, APB_166M_I2C_DIV);
 		printk("PORT 0 speed_mode = %d\n", speed_mode);
 		if (speed_mode == 0)
 			i2c.i2c_mode    = I2C_STANDARD_MODE ;
 		else if (speed_mode == 1)
 			i2c.i2c_mode    = I2C_FAST_MODE ;
-		i2c.isr_nack    = 0 ;
-		i2c.isr_byte_end = 0 ;
-		i2c.isr_timeout = 0 ;
-		i2c.isr_int_pending = 0;
+		else
+			i2c.i2c_mode    = I2C_FAST_PLUS_MODE ;
+		i2c.enabled = 1;
 		/**/
 		/* hardware initial*/
 		/**/
@@ -806,20 +304,7 @@ static int __init i2c_adap_wmt_init(void)
 		GPIO_PULL_CTRL_GP21_I2C_BYTE_VAL |= (BIT0 | BIT1);
 		PMCEL_VAL |= 0x0020;
 
-		i2c.regs->cr_reg  = 0 ;
-		/*i2c.regs->div_reg = APB_96M_I2C_DIV ;*/
-		i2c.regs->div_reg = APB_166M_I2C_DIV  ;
-		i2c.regs->isr_reg = I2C_ISR_ALL_WRITE_CLEAR ;   /* 0x0007*/
-		i2c.regs->imr_reg = I2C_IMR_ALL_ENABLE ;        /* 0x0007*/
-
-		i2c.regs->cr_reg  = I2C_CR_ENABLE ;
-		tmp = i2c.regs->csr_reg ;                     /* read clear*/
-		i2c.regs->isr_reg = I2C_ISR_ALL_WRITE_CLEAR ; /* 0x0007*/
-
-		if (i2c.i2c_mode == I2C_STANDARD_MODE)
-			i2c.regs->tr_reg = I2C_TR_STD_VALUE ;   /* 0x8064*/
-		else if (i2c.i2c_mode == I2C_FAST_MODE)
-			i2c.regs->tr_reg = I2C_TR_FAST_VALUE ; /* 0x8019*/
+		wmt_i2c_port_reset(&i2c);
 	}
 
 
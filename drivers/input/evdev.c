@@ -11,6 +11,7 @@
 #define EVDEV_MINOR_BASE	64
 #define EVDEV_MINORS		32
 #define EVDEV_BUFFER_SIZE	64
+#define EVDEV_MT_BUFFER_SIZE	512	/* a few frames of 10 contacts */
 
 #include <linux/poll.h>
 #include <linux/sched.h>
@@ -37,15 +38,17 @@ struct evdev {
 };
 
 struct evdev_client {
-	struct input_event buffer[EVDEV_BUFFER_SIZE];
 	int head;
 	int tail;
+	int packet_head; /* end of the last complete packet, readers stop here */
 	spinlock_t buffer_lock; /* protects access to buffer, head and tail */
 	struct fasync_struct *fasync;
 	struct evdev *evdev;
 	struct list_head node;
 	struct wake_lock wake_lock;
 	char name[28];
+	int bufsize;
+	struct input_event buffer[];
 };
 
 static struct evdev *evdev_table[EVDEV_MINORS];
@@ -60,10 +63,19 @@ static void evdev_pass_event(struct evdev_client *client,
 	spin_lock(&client->buffer_lock);
 	wake_lock_timeout(&client->wake_lock, 1 * HZ);
 	client->buffer[client->head++] = *event;
-	client->head &= EVDEV_BUFFER_SIZE - 1;
+	client->head &= client->bufsize - 1;
+	if (unlikely(client->head == client->tail)) {
+		/* Full, drop the oldest event rather than the whole buffer */
+		if (client->packet_head == client->tail)
+			client->packet_head = (client->tail + 1) & (client->bufsize - 1);
+		client->tail = (client->tail + 1) & (client->bufsize - 1);
+	}
+	if (event->type == EV_SYN && event->code == SYN_REPORT)
+		client->packet_head = client->head;
 	spin_unlock(&client->buffer_lock);
 
-	kill_fasync(&client->fasync, SIGIO, POLL_IN);
+	if (event->type == EV_SYN && event->code == SYN_REPORT)
+		kill_fasync(&client->fasync, SIGIO, POLL_IN);
 }
 
 /*
@@ -77,7 +89,10 @@ static void evdev_event(struct input_handle *handle,
 	struct input_event event;
 	struct timespec ts;
 
-	ktime_get_ts(&ts);
+	if (handle->dev->timestamp.tv64)
+		ts = ktime_to_timespec(handle->dev->timestamp);
+	else
+		ktime_get_ts(&ts);
 	event.time.tv_sec = ts.tv_sec;
 	event.time.tv_usec = ts.tv_nsec / NSEC_PER_USEC;
 	event.type = type;
@@ -95,7 +110,9 @@ static void evdev_event(struct input_handle *handle,
 
 	rcu_read_unlock();
 
-	wake_up_interruptible(&evdev->wait);
+	/* Readers get whole packets, one wakeup per SYN_REPORT */
+	if (type == EV_SYN && code == SYN_REPORT)
+		wake_up_interruptible(&evdev->wait);
 }
 
 static int evdev_fasync(int fd, struct file *file, int on)
@@ -249,11 +266,23 @@ static int evdev_release(struct inode *inode, struct file *file)
 	return 0;
 }
 
+/*
+ * Multi-touch devices send several events per contact and frame, give
+ * their clients room for a few whole frames.
+ */
+static unsigned int evdev_compute_buffer_size(struct input_dev *dev)
+{
+	if (test_bit(EV_ABS, dev->evbit) && test_bit(ABS_MT_POSITION_X, dev->absbit))
+		return EVDEV_MT_BUFFER_SIZE;
+	return EVDEV_BUFFER_SIZE;
+}
+
 static int evdev_open(struct inode *inode, struct file *file)
 {
 	struct evdev *evdev;
 	struct evdev_client *client;
 	int i = iminor(inode) - EVDEV_MINOR_BASE;
+	unsigned int bufsize;
 	int error;
 
 	if (i >= EVDEV_MINORS)
@@ -270,12 +299,15 @@ static int evdev_open(struct inode *inode, struct file *file)
 	if (!evdev)
 		return -ENODEV;
 
-	client = kzalloc(sizeof(struct evdev_client), GFP_KERNEL);
+	bufsize = evdev_compute_buffer_size(evdev->handle.dev);
+	client = kzalloc(sizeof(struct evdev_client) +
+			 bufsize * sizeof(struct input_event), GFP_KERNEL);
 	if (!client) {
 		error = -ENOMEM;
 		goto err_put_evdev;
 	}
 
+	client->bufsize = bufsize;
 	spin_lock_init(&client->buffer_lock);
 	snprintf(client->name, sizeof(client->name), "%s-%d",
 			dev_name(&evdev->dev), task_tgid_vnr(current));
@@ -339,11 +371,11 @@ static int evdev_fetch_next_event(struct evdev_client *client,
 
 	spin_lock_irq(&client->buffer_lock);
 
-	have_event = client->head != client->tail;
+	have_event = client->packet_head != client->tail;
 	if (have_event) {
 		*event = client->buffer[client->tail++];
-		client->tail &= EVDEV_BUFFER_SIZE - 1;
-		if (client->head == client->tail)
+		client->tail &= client->bufsize - 1;
+		if (client->packet_head == client->tail)
 			wake_unlock(&client->wake_lock);
 	}
 
@@ -363,12 +395,12 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 	if (count < input_event_size())
 		return -EINVAL;
 
-	if (client->head == client->tail && evdev->exist &&
+	if (client->packet_head == client->tail && evdev->exist &&
 	    (file->f_flags & O_NONBLOCK))
 		return -EAGAIN;
 
 	retval = wait_event_interruptible(evdev->wait,
-		client->head != client->tail || !evdev->exist);
+		client->packet_head != client->tail || !evdev->exist);
 	if (retval)
 		return retval;
 
@@ -394,7 +426,7 @@ static unsigned int evdev_poll(struct file *file, poll_table *wait)
 	struct evdev *evdev = client->evdev;
 
 	poll_wait(file, &evdev->wait, wait);
-	return ((client->head == client->tail) ? 0 : (POLLIN | POLLRDNORM)) |
+	return ((client->packet_head == client->tail) ? 0 : (POLLIN | POLLRDNORM)) |
 		(evdev->exist ? 0 : (POLLHUP | POLLERR));
 }
 
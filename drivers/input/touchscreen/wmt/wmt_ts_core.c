@@ -0,0 +1,281 @@
+/*++
+	drivers/input/touchscreen/wmt/wmt_ts_core.c
+
+	Some descriptions of such software. Copyright (c) 2008 WonderMedia Technologies, Inc.
+
+	This program is free software: you can redistribute it and/or modify it under the
+	terms of the GNU General Public License as published by the Free Software Foundation,
+	either version 2 of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful, but WITHOUT
+	ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+	PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License along with
+	this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	WonderMedia Technologies, Inc.
+	10F, 529, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C.
+
+	Acquisition core shared by the WMT touchscreen drivers.
+	The hard interrupt only takes the time, the IRQ thread reads a batch
+	of frames out of the controller FIFO and reports every frame as one
+	packet: all contacts with a tracking id, then a single SYN_REPORT
+	carrying the time of the interrupt which announced it.
+--*/
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/interrupt.h>
+#include <linux/input.h>
+#include <linux/wmt_ts_core.h>
+
+#define WMT_TS_MAX_READS	4	/* FIFO reads per interrupt */
+
+/*
+ * Contact id to slot. Contacts still down keep their slot, slots not
+ * seen in this frame are released before new contacts get one, so a
+ * full panel can lift one finger and put another down in one frame.
+ */
+static void wmt_ts_assign_slots(struct wmt_ts *ts, struct wmt_ts_frame *f, int *slot)
+{
+	int i, j;
+
+	for (j = 0; j < ts->max_contacts; j++)
+		ts->slot[j].seen = 0;
+
+	for (i = 0; i < f->count; i++) {
+		slot[i] = -1;
+		for (j = 0; j < ts->max_contacts; j++) {
+			if (ts->slot[j].tracking_id >= 0 && ts->slot[j].id == f->contact[i].id) {
+				ts->slot[j].seen = 1;
+				slot[i] = j;
+				break;
+			}
+		}
+	}
+
+	for (j = 0; j < ts->max_contacts; j++)
+		if (!ts->slot[j].seen)
+			ts->slot[j].tracking_id = -1;
+
+	for (i = 0; i < f->count; i++) {
+		if (slot[i] >= 0)
+			continue;
+		for (j = 0; j < ts->max_contacts; j++) {
+			if (ts->slot[j].tracking_id < 0) {
+				ts->slot[j].tracking_id = ts->next_tracking_id++ & 0xFFFF;
+				ts->slot[j].id = f->contact[i].id;
+				ts->slot[j].seen = 1;
+				slot[i] = j;
+				break;
+			}
+		}
+		if (slot[i] < 0)
+			ts->stats.contacts_dropped++;
+	}
+}
+
+static void wmt_ts_report_frame(struct wmt_ts *ts, struct wmt_ts_frame *f, ktime_t stamp)
+{
+	struct input_dev *input = ts->input;
+	struct wmt_ts_contact *c;
+	int slot[WMT_TS_MAX_CONTACTS];
+	int i, first = -1;
+
+	if (f->count > WMT_TS_MAX_CONTACTS)
+		f->count = WMT_TS_MAX_CONTACTS;
+	wmt_ts_assign_slots(ts, f, slot);
+
+	input_set_timestamp(input, stamp);
+	for (i = 0; i < f->count; i++) {
+		if (slot[i] < 0)
+			continue;
+		c = &f->contact[i];
+		input_report_abs(input, ABS_MT_TRACKING_ID, ts->slot[slot[i]].tracking_id);
+		input_report_abs(input, ABS_MT_POSITION_X, c->x);
+		input_report_abs(input, ABS_MT_POSITION_Y, c->y);
+		if (c->width)
+			input_report_abs(input, ABS_MT_TOUCH_MAJOR, c->width);
+		input_mt_sync(input);
+		if (first < 0)
+			first = i;
+	}
+
+	/* single touch follows the first contact */
+	if (first < 0) {
+		input_mt_sync(input);
+		input_report_key(input, BTN_TOUCH, 0);
+	} else {
+		input_report_abs(input, ABS_X, f->contact[first].x);
+		input_report_abs(input, ABS_Y, f->contact[first].y);
+		input_report_key(input, BTN_TOUCH, 1);
+	}
+	input_sync(input);
+	ts->stats.frames++;
+}
+
+static irqreturn_t wmt_ts_hard_irq(int irq, void *dev_id)
+{
+	struct wmt_ts *ts = dev_id;
+	unsigned int head = ts->stamp_head;
+
+	if (ts->ops->irq_ack && !ts->ops->irq_ack(ts))
+		return IRQ_NONE;
+
+	ts->stats.irqs++;
+	if (head - ACCESS_ONCE(ts->stamp_tail) < WMT_TS_STAMP_RING) {
+		ts->stamp[head & (WMT_TS_STAMP_RING - 1)] = ktime_get();
+		smp_wmb();
+		ts->stamp_head = head + 1;
+	} else
+		ts->stats.stamps_lost++;
+
+	return IRQ_WAKE_THREAD;
+}
+
+/*
+ * Time of frame i of n. With one interrupt per frame the stamps match
+ * the frames, frames without an own stamp are put frame_ns apart
+ * before the newest one.
+ */
+static ktime_t wmt_ts_frame_stamp(struct wmt_ts *ts, unsigned int tail,
+	unsigned int pending, int i, int n)
+{
+	int k = pending - n + i;
+
+	if (!pending)
+		return ktime_get();
+	if (k >= 0)
+		return ts->stamp[(tail + k) & (WMT_TS_STAMP_RING - 1)];
+	return ktime_sub_ns(ts->stamp[(tail + pending - 1) & (WMT_TS_STAMP_RING - 1)],
+		(u64)(-k) * ts->frame_ns);
+}
+
+static irqreturn_t wmt_ts_thread(int irq, void *dev_id)
+{
+	struct wmt_ts *ts = dev_id;
+	unsigned int head, tail, pending, lat;
+	int batch = ts->batch ? ts->batch : 1;
+	int n, i, reads = 0;
+	ktime_t stamp;
+
+	do {
+		n = ts->ops->read_frames(ts, ts->frames, batch);
+		if (n < 0) {
+			ts->stats.read_errors++;
+			break;
+		}
+		if (n > ts->stats.batch_max)
+			ts->stats.batch_max = n;
+
+		tail = ts->stamp_tail;
+		head = ACCESS_ONCE(ts->stamp_head);
+		smp_rmb();
+		pending = head - tail;
+
+		for (i = 0; i < n; i++) {
+			stamp = wmt_ts_frame_stamp(ts, tail, pending, i, n);
+			wmt_ts_report_frame(ts, &ts->frames[i], stamp);
+		}
+		if (n) {
+			lat = ktime_to_us(ktime_sub(ktime_get(), stamp));
+			ts->stats.lat_last = lat;
+			if (lat > ts->stats.lat_max)
+				ts->stats.lat_max = lat;
+		}
+		ts->stamp_tail = head;
+	} while (n == batch && ++reads < WMT_TS_MAX_READS);
+
+	if (ts->ops->irq_done)
+		ts->ops->irq_done(ts);
+
+	return IRQ_HANDLED;
+}
+
+/*!*************************************************************************
+* wmt_ts_set_abs
+*/
+/*!
+* \brief
+*	Declare single touch and multi-touch axes of ts->input
+*
+* \retval  none
+*/
+void wmt_ts_set_abs(struct wmt_ts *ts, int x_max, int y_max, int width_max)
+{
+	struct input_dev *input = ts->input;
+
+	set_bit(EV_SYN, input->evbit);
+	set_bit(EV_KEY, input->evbit);
+	set_bit(EV_ABS, input->evbit);
+	set_bit(BTN_TOUCH, input->keybit);
+
+	input_set_abs_params(input, ABS_X, 0, x_max, 0, 0);
+	input_set_abs_params(input, ABS_Y, 0, y_max, 0, 0);
+	input_set_abs_params(input, ABS_MT_POSITION_X, 0, x_max, 0, 0);
+	input_set_abs_params(input, ABS_MT_POSITION_Y, 0, y_max, 0, 0);
+	input_set_abs_params(input, ABS_MT_TRACKING_ID, 0, 0xFFFF, 0, 0);
+	if (width_max)
+		input_set_abs_params(input, ABS_MT_TOUCH_MAJOR, 0, width_max, 0, 0);
+}
+EXPORT_SYMBOL(wmt_ts_set_abs);
+
+/*!*************************************************************************
+* wmt_ts_release_all
+*/
+/*!
+* \brief
+*	Lift all contacts, for suspend or a controller reset.
+*	Must not run concurrently with the IRQ thread.
+*
+* \retval  none
+*/
+void wmt_ts_release_all(struct wmt_ts *ts)
+{
+	struct wmt_ts_frame f;
+
+	f.count = 0;
+	wmt_ts_report_frame(ts, &f, ktime_get());
+}
+EXPORT_SYMBOL(wmt_ts_release_all);
+
+/*!*************************************************************************
+* wmt_ts_register
+*/
+/*!
+* \brief
+*	Request the threaded interrupt of ts. ts->input must be registered,
+*	ts->ops, ts->irq and ts->max_contacts set.
+*
+* \retval  0 if success
+*/
+int wmt_ts_register(struct wmt_ts *ts, unsigned long irqflags, const char *name)
+{
+	int i;
+
+	if (!ts->ops || !ts->ops->read_frames || !ts->input)
+		return -EINVAL;
+	if (ts->max_contacts <= 0 || ts->max_contacts > WMT_TS_MAX_CONTACTS)
+		ts->max_contacts = WMT_TS_MAX_CONTACTS;
+	if (ts->batch > WMT_TS_MAX_BATCH)
+		ts->batch = WMT_TS_MAX_BATCH;
+
+	for (i = 0; i < WMT_TS_MAX_CONTACTS; i++)
+		ts->slot[i].tracking_id = -1;
+	ts->stamp_head = ts->stamp_tail = 0;
+	memset(&ts->stats, 0, sizeof(ts->stats));
+
+	return request_threaded_irq(ts->irq, wmt_ts_hard_irq, wmt_ts_thread,
+		irqflags, name, ts);
+}
+EXPORT_SYMBOL(wmt_ts_register);
+
+void wmt_ts_unregister(struct wmt_ts *ts)
+{
+	free_irq(ts->irq, ts);
+	wmt_ts_release_all(ts);
+}
+EXPORT_SYMBOL(wmt_ts_unregister);
+
+MODULE_DESCRIPTION("WMT touchscreen acquisition core");
+MODULE_LICENSE("GPL");
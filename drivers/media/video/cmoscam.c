@@ -52,6 +52,7 @@ static const struct v4l2_file_operations cmos_cam_fops = {
 	.release = cmos_cam_release,
 	.ioctl = video_ioctl2,
 	.mmap = cmos_cam_mmap,
+	.poll = cmos_cam_poll,
 
 };
 
@@ -255,13 +255,16 @@ static int ioctl_decode_proc(jdec_drvinfo_t *drvinfo, jdec_input_t *arg)
     DBG_MSG("filesize: %d, remain: %d, seg_size: %d\n", drvinfo->attr.hdr.filesize, 
                                     drvinfo->_remain_byte, arg->src_size);
     /* Wait for previous segment decoded */
-    while( drvinfo->_status & STA_DMA_START ) {
+    if( drvinfo->_status & STA_DMA_START ) {
+        DBG_MSG("Wait for DMA finished\n");
+        ret = wmt_jdec_wait_segment(drvinfo);
+        if( ret ) {
+            return ret;
+        }
         if(drvinfo->_status & STA_DECODE_DONE) {
             /* This JPEG was decoded already. We do not need to do anything */
             return 0;
         }
-        DBG_MSG("Wait for DMA finished\n");
-        msleep(1);
     }
 
     /*--------------------------------------------------------------------------
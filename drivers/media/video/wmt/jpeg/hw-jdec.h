@@ -201,6 +201,7 @@ int wmt_jdec_probe(void);
 int wmt_jdec_get_capability(jdec_drvinfo_t *drv);
 int wmt_jdec_set_attr(jdec_drvinfo_t *drv);
 int wmt_jdec_decode_proc(jdec_drvinfo_t *drv);
+int wmt_jdec_wait_segment(jdec_drvinfo_t *drv);
 int wmt_jdec_decode_finish(jdec_drvinfo_t *drv);
 int wmt_jdec_decode_flush(jdec_drvinfo_t *drv);
 int wmt_jdec_get_status(jdec_drvinfo_t *drvinfo, jdec_status_t *jsts);
@@ -38,6 +38,8 @@
 *
 *------------------------------------------------------------------------------*/
 
+#include <linux/sched.h>     /* For wait_event_interruptible_timeout() */
+
 #include "hw-jdec.h"
 #include "wmt-jdec.h"
 #include "../wmt-dsplib.h"
@@ -53,6 +55,10 @@
 #define ALIGN64(a)          (((a)+63) & (~63))
 #define MAX(a, b)           ((a)>=(b))?(a):(b)
 
+#define JDEC_THUMB_SIZE     96      /* Minimum edge of SCALE_THUMBS output */
+#define JDEC_MAX_SCALE      3       /* HW supports down to 1/8 */
+#define JDEC_SEG_TIME_OUT   (1000 * HZ / 1000)
+
 static jdec_drvinfo_t *current_drv = 0;
 
 static jdec_capability_t capab_table = {
@@ -159,6 +165,7 @@ int wmt_jdec_seg_done(void)
 
         DBG_MSG("Segment Done(_segment_no: %d, _segment_done: %d)\n", drv->_segment_no, drv->_segment_done);    
     }
+    wake_up_interruptible(&jdec_wait);
     return 0;
 } /* End of wmt_jdec_seg_done() */
 
@@ -184,9 +191,36 @@ int wmt_jdec_decode_done(void)
     if( drv ) {
         drv->_status |= STA_DECODE_DONE;
     }
+    wake_up_interruptible(&jdec_wait);
     return 0;
 } /* End of wmt_jdec_decode_done() */
 
+/*!*************************************************************************
+* wmt_jdec_wait_segment
+* 
+* API Function
+*/
+/*!
+* \brief
+*	Wait until BSDMA has consumed the current segment, so the caller can
+*   feed the next one as soon as the DSP asks for it.
+*
+* \retval  0 if success
+*/ 
+int wmt_jdec_wait_segment(jdec_drvinfo_t *drv)
+{
+    int ret;
+
+    ret = wait_event_interruptible_timeout(jdec_wait,
+                    (!(drv->_status & STA_DMA_START) || (drv->_status & STA_DECODE_DONE)),
+                    JDEC_SEG_TIME_OUT);
+    if( ret == 0 ) {
+        DBG_ERR("Segment time out (status: 0x%x)\n", drv->_status);
+        return -ETIMEDOUT;
+    }
+    return (ret < 0) ? ret : 0;
+} /* End of wmt_jdec_wait_segment() */
+
 /*!*************************************************************************
 * wmt_jdec_set_drv
 * 
@@ -239,6 +273,32 @@ int wmt_jdec_get_capability(jdec_drvinfo_t *drv)
     return 0;
 } /* End of wmt_jdec_get_capability() */
 
+/*!*************************************************************************
+* get_thumb_scale
+* 
+* Private Function
+*/
+/*!
+* \brief
+*	Get the largest HW scale down ratio which still keeps the decoded
+*   picture no smaller than JDEC_THUMB_SIZE
+*
+* \retval  scale ratio (0 ~ JDEC_MAX_SCALE)
+*/ 
+static unsigned int get_thumb_scale(unsigned int width, unsigned int height)
+{
+    unsigned int ratio = 0;
+
+    while( ratio < JDEC_MAX_SCALE ) {
+        if(((width >> (ratio + 1)) < JDEC_THUMB_SIZE) || 
+           ((height >> (ratio + 1)) < JDEC_THUMB_SIZE)) {
+            break;
+        }
+        ratio++;
+    }
+    return ratio;
+} /* End of get_thumb_scale() */
+
 /*!*************************************************************************
 * wmt_jdec_set_attr
 * 
@@ -298,6 +358,19 @@ int wmt_jdec_set_attr(jdec_drvinfo_t *drv)
         case SCALE_EIGHTH:
             drv->scale_ratio = 3;
             break;
+        case SCALE_THUMBS:
+            /* Let HW do the down scaling instead of decoding full size */
+            if(di->pd.enable) {
+                drv->scale_ratio = get_thumb_scale(di->pd.w, di->pd.h);
+            }
+            else {
+                drv->scale_ratio = get_thumb_scale(hdr->sof_w, hdr->sof_h);
+            }
+            DBG_MSG("Thumbnail scale ratio: 1/%d\n", (1 << drv->scale_ratio));
+            /* The DSP only knows the fixed ratios, scale_ratio 1 ~ 3 is
+               SCALE_HALF ~ SCALE_EIGHTH */
+            di->scale_factor = (vd_scale_ratio)(SCALE_ORIGINAL + drv->scale_ratio);
+            break;
         default:
             DBG_ERR("Illegal scale ratio(%d)\n", di->scale_factor);
             drv->scale_ratio = 0;
@@ -763,7 +836,19 @@ int wmt_jdec_get_status(jdec_drvinfo_t *drv, jdec_status_t *jsts)
                 }
                 break;
             }
-            msleep(1);
+            /* Sleep until DSP reports segment done instead of polling */
+            ret = wait_event_interruptible_timeout(jdec_wait, 
+                        (drv->_segment_done || (drv->_status & STA_DECODE_DONE)),
+                        JDEC_SEG_TIME_OUT);
+            if( ret == 0 ) {
+                DBG_ERR("Segment time out (status: 0x%x)\n", drv->_status);
+                ret = -ETIMEDOUT;
+                break;
+            }
+            if( ret < 0 ) {
+                break;
+            }
+            ret = 0;
         } while(1);
     }    
     return ret;
@@ -899,6 +984,10 @@ int wmt_jdec_get_info(char *buf, char **start, off_t offset, int len)
     p += sprintf(p, "multi_seg_en: %d\n", drv->_multi_seg_en);
     p += sprintf(p, "segment no:   %d\n", drv->_segment);
     p += sprintf(p, "remain_byte:  %d\n", drv->_remain_byte);
+    p += sprintf(p, "segment_done: %d\n", drv->_segment_no);
+    if( drv->attr.di.bd.enable ) {
+        p += sprintf(p, "band_height:  %d\n", drv->attr.di.bd.height);
+    }
     p += sprintf(p, "_is_mjpeg:    %d\n", drv->_is_mjpeg);
 EXIT_wmt_jdec_get_info:
     p += sprintf(p, "WMT JDEC End\n\n");
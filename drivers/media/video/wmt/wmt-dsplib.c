@@ -68,7 +68,10 @@
 #include <linux/dma-mapping.h>
 #include <linux/firmware.h>
 #include <linux/platform_device.h>
+#include <linux/proc_fs.h>
+#include <linux/clk.h>
 #include <asm/io.h>
+#include <asm/div64.h>
 #include <mach/hardware.h>
 #include <asm/sizes.h>
 #include <asm/irq.h>
@@ -78,6 +81,7 @@
 #include "wmt-dsplib.h"
 
 #define DSP_TIME_OUT      (10000 * HZ / 1000)
+#define DSP_OSCR_PER_US   (CLOCK_TICK_RATE / 1000000)
 //#define LOAD_FW_ALWAYS
 
 /*----------------------- INTERNAL PRIVATE MARCOS -------------------------*/
@@ -103,8 +107,10 @@ DECLARE_WAIT_QUEUE_HEAD(dsp_irq_event);
 spinlock_t dsp_irqlock = SPIN_LOCK_UNLOCKED;
 
 /* for DSP interface event handle */
-volatile unsigned char dsp_dec_done_flag;
 volatile unsigned char dsp_reset_flag;
+static dsplib_mbox_queue_t dsp_rx_queue;
+static dsplib_stat_t dsp_stat;
+static unsigned int dsp_tx_time;
 
 /* variables for DSP */
 volatile unsigned int dsp_idle_pc = DSP_PC_DEFAULT_VAL;
@@ -120,6 +126,11 @@ char *dsp_raw_buf = NULL;
 char *dsp_raw_buf_ptr = NULL;
 static dma_addr_t dsp_raw_buf_phys = 0;
 
+/* DSP, MBOX, NA0, PERM and DSP CFG clocks, in enable order */
+static const char *dsp_clk_name[] = {"dsp", "mbox", "na0", "perm", "dspcfg"};
+static struct clk *dsp_clk[ARRAY_SIZE(dsp_clk_name)];
+static int dsp_clk_on;
+
 dsplib_fw_t dsp_name[] = {
 								 {"NULL", 0, 0}, {"NULL", 0, 0},
 								 {"wm8650_vdec_jpeg.pm.raw", 0, 0}, {"wm8650_vdec_jpeg.dm.raw", 0, 0},
@@ -155,6 +166,9 @@ static int dsplib_firmware_ld(void);
 static void dsplib_fw_reload(void);
 static void dump_dsp_pc(void);
 static void dsplib_clock_ctrl(unsigned char enable_flag);
+#ifdef CONFIG_PROC_FS
+static int dsplib_read_proc(char *page, char **start, off_t off, int count, int *eof, void *data);
+#endif
 
 
 #ifdef CONFIG_WMT_VIDEO_DECODE_JPEG
@@ -271,8 +285,16 @@ static void dsplib_fw_reload(void)
 */ 
 void dsplib_initial(struct device *device)
 {
+	int i;
+
 	TRACE("Enter\n");
 
+	for (i = 0; i < ARRAY_SIZE(dsp_clk); i++) {
+		dsp_clk[i] = clk_get(NULL, dsp_clk_name[i]);
+		if (IS_ERR(dsp_clk[i]))
+			printk(KERN_ALERT "[%s] no %s clock \n", __FUNCTION__, dsp_clk_name[i]);
+	}
+
 	/* disable DSP clock */
 	dsplib_clock_ctrl(0);
 	
@@ -298,8 +320,12 @@ void dsplib_initial(struct device *device)
        	printk(KERN_ALERT "[%s] Failed to register IRQ_DSP \n", __FUNCTION__);
     }
 
-	dsp_dec_done_flag = 0;
+	dsp_rx_queue.head = dsp_rx_queue.tail = 0;
 	dsp_reset_flag = 0;
+
+#ifdef CONFIG_PROC_FS
+	create_proc_read_entry("wmt-dsplib", 0, NULL, dsplib_read_proc, NULL);
+#endif
 	TRACE("Leave\n");
 }
 
@@ -406,6 +432,7 @@ static void dsplib_enter_idle(void)
 static void dsplib_clock_ctrl(unsigned char enable_flag)
 {
 	unsigned int stat;
+	int i;
 
 	TRACE("Enter\n");
 
@@ -418,19 +445,12 @@ static void dsplib_clock_ctrl(unsigned char enable_flag)
 
 		while(PMDSPPWR_VAL & BIT9);
 
-    	/* enable Bit25 DSP and Bit28 MBOX Clock Enable of Clock Enables Lower Register */
-		stat = PMCEL_VAL;
-    	stat |= (BIT25 | BIT28);
-    	PMCEL_VAL = stat;
-
-    	while(PMCEL_VAL != stat);
-
-    	/* enable Bit1 NA0, Bit8 PERM and Bit9 DSP CFG Clock Enable of Clock Enables Upper Register */
-		stat = PMCEU_VAL;
-    	stat |= (BIT1 | BIT8 | BIT9);
-    	PMCEU_VAL = stat;
-
-    	while(PMCEU_VAL != stat);
+		/* DSP, MBOX, NA0, PERM and DSP CFG clocks are gated by the clock framework */
+		if (!dsp_clk_on) {
+			for (i = 0; i < ARRAY_SIZE(dsp_clk); i++)
+				clk_enable(dsp_clk[i]);
+			dsp_clk_on = 1;
+		}
 	}
 	else {
 		//printk(KERN_ALERT "[%s] disable DSP clock \n", __FUNCTION__);
@@ -441,19 +461,11 @@ static void dsplib_clock_ctrl(unsigned char enable_flag)
 
 		while(PMDSPPWR_VAL & BIT8);
 
-    	/* disable Bit25 DSP and Bit28 MBOX Clock Enable of Clock Enables Lower Register */
-    	stat = PMCEL_VAL;
-		stat &= ~(BIT25 | BIT28);
-		PMCEL_VAL = stat;
-
-		while(PMCEL_VAL != stat);
-
-    	/* disable Bit1 NA0, Bit8 PERM and Bit9 DSP CFG Clock Enable of Clock Enables Upper Register */
-    	stat = PMCEU_VAL;
-		stat &= ~(BIT1 | BIT8 | BIT9);
-		PMCEU_VAL = stat;
-
-		while(PMCEU_VAL != stat);
+		if (dsp_clk_on) {
+			for (i = ARRAY_SIZE(dsp_clk) - 1; i >= 0; i--)
+				clk_disable(dsp_clk[i]);
+			dsp_clk_on = 0;
+		}
 	}
 	
 	TRACE("Leave\n");
@@ -477,11 +489,7 @@ static void dsplib_wakeup_dsp(unsigned char reload_flag)
 	
     TRACE("Enter\n");
 
-	/* check Bit25 DSP Clock Enable of Clock Enables Lower Register at first */
-	stat = PMCEL_VAL;
-	stat &= BIT25;
-	
-	if (!stat) {
+	if (!dsp_clk_on) {
 		/* enable DSP clock */
 		dsplib_clock_ctrl(1);
 	}
@@ -589,6 +597,83 @@ static int dsplib_mbox_tx(
 }
 
 
+/*!*************************************************************************
+* dsplib_rx_stat
+* 
+* Private Function
+*/
+/*!
+* \brief
+*	Count a completion received from DSP and its latency since the last
+*   command sent.  Called from mailbox ISR only.
+*
+* \retval 
+*/ 
+static void dsplib_rx_stat(void)
+{
+    unsigned int lat;
+
+    lat = wmt_read_oscr() - dsp_tx_time;
+    dsp_stat.rx_done++;
+    dsp_stat.lat_last = lat;
+    dsp_stat.lat_total += lat;
+    if ((dsp_stat.lat_min == 0) || (lat < dsp_stat.lat_min))
+        dsp_stat.lat_min = lat;
+    if (lat > dsp_stat.lat_max)
+        dsp_stat.lat_max = lat;
+}
+
+
+/*!*************************************************************************
+* dsplib_rx_post
+* 
+* Private Function
+*/
+/*!
+* \brief
+*	Queue a completion received from DSP and update statistics.
+*   Called from mailbox ISR only.
+*
+* \retval 
+*/ 
+static void dsplib_rx_post(void)
+{
+    dsplib_mbox_queue_t *q = &dsp_rx_queue;
+    dsplib_mbox_t *mbox;
+
+    dsplib_rx_stat();
+    if ((q->head - q->tail) >= DSPLIB_RX_QUEUE_NUM) {
+        dsp_stat.rx_overflow++;
+        return;
+    }
+    mbox = &q->mbox[q->head & (DSPLIB_RX_QUEUE_NUM - 1)];
+    mbox->cmd = mbox_rx_cmd;
+    mbox->w1 = mbox_rx_w1;
+    mbox->w2 = mbox_rx_w2;
+    mbox->w3 = mbox_rx_w3;
+    /* Entry must be visible before consumer sees new head */
+    smp_wmb();
+    q->head++;
+}
+
+
+/*!*************************************************************************
+* dsplib_rx_pending
+* 
+* Private Function
+*/
+/*!
+* \brief
+*	Check whether any completion is waiting in queue
+*
+* \retval  non-zero if pending
+*/ 
+static inline int dsplib_rx_pending(void)
+{
+    return (dsp_rx_queue.head != dsp_rx_queue.tail);
+}
+
+
 /*!*************************************************************************
 * dsplib_isr_mbox_rx
 * 
@@ -629,14 +714,15 @@ static irqreturn_t dsplib_isr_mbox_rx(
             if(decoder_type == VD_JPEG)
                 wmt_jdec_decode_done();
 #endif            
-        	dsp_dec_done_flag = 1;
+            dsplib_rx_post();
             wake_up_interruptible(&dsp_irq_event);
             break;
         case CMD_D2A_VENC_DONE:
-        	dsp_dec_done_flag = 1;
+            dsplib_rx_post();
             wake_up_interruptible(&dsp_irq_event);
             break;            
         case CMD_D2A_VDEC_SEG_DONE:
+            dsplib_rx_stat();
 #ifdef CONFIG_WMT_VIDEO_DECODE_JPEG        	
             if(decoder_type == VD_JPEG)
                 wmt_jdec_seg_done();
@@ -671,6 +757,9 @@ void dsplib_release(void)
 	}
 	
     free_irq(IRQ_DSP, 0);
+#ifdef CONFIG_PROC_FS
+    remove_proc_entry("wmt-dsplib", NULL);
+#endif
     dma_free_coherent(vd_dev, DSP_RAW_BUF_SZ, dsp_raw_buf, dsp_raw_buf_phys);
     decoder_type = 0;
 }
@@ -862,10 +951,14 @@ int dsplib_cmd_send(
 #endif		
 	}
    	else if ((mbox.cmd == CMD_A2D_VDEC) || (mbox.cmd == CMD_A2D_VENC)) {
-		dsp_dec_done_flag = 0;
+		/* Drop stale completions of previous job */
+		dsp_rx_queue.tail = dsp_rx_queue.head;
 	}
     	
+	dsp_tx_time = wmt_read_oscr();
 	ret = dsplib_mbox_tx(mbox.cmd, mbox.w1, mbox.w2, mbox.w3, 0);
+	if (!ret)
+		dsp_stat.tx_cmd++;
 
 	if ((mbox.cmd == CMD_A2D_VDEC_CLOSE) || (mbox.cmd == CMD_A2D_VENC_CLOSE)) {
 		//printk(KERN_ALERT "[%s] CMD_A2D_CLOSE \n", __FUNCTION__);
@@ -907,9 +1000,29 @@ int dsplib_cmd_recv(dsplib_mbox_t *mbox, unsigned int cmd)
     DBG("Received DSP Msg (cmd: 0x%x)\n", mbox->cmd);
 
     if ((mbox->cmd == CMD_D2A_VDEC_DONE) || (mbox->cmd == CMD_D2A_VENC_DONE)){
-        ret = wait_event_interruptible_timeout(dsp_irq_event, (dsp_dec_done_flag != 0), DSP_TIME_OUT);
+        dsplib_mbox_t *done;
+
+        ret = wait_event_interruptible_timeout(dsp_irq_event, dsplib_rx_pending(), DSP_TIME_OUT);
+
+        if (ret > 0) {
+            /* Read entry only after head was observed */
+            smp_rmb();
+            done = &dsp_rx_queue.mbox[dsp_rx_queue.tail & (DSPLIB_RX_QUEUE_NUM - 1)];
+            mbox->cmd = done->cmd;
+            mbox->w1 = done->w1;
+            mbox->w2 = done->w2;
+            mbox->w3 = done->w3;
+            smp_mb();
+            dsp_rx_queue.tail++;
+        }
+        else {
+            mbox->cmd = mbox_rx_cmd;
+            mbox->w1 = mbox_rx_w1;
+            mbox->w2 = mbox_rx_w2;
+            mbox->w3 = mbox_rx_w3;
+        }
 
-        dspinfo = (dsp_done_t *)phys_to_virt(mbox_rx_w1);
+        dspinfo = (dsp_done_t *)phys_to_virt(mbox->w1);
         
         DBG("bs_type:       0x%x\n", dspinfo->bs_type);
         DBG("decode_status: 0x%x\n", dspinfo->decode_status);
@@ -963,11 +1076,12 @@ int dsplib_cmd_recv(dsplib_mbox_t *mbox, unsigned int cmd)
 
         ret = 0;
     }
-
-    mbox->cmd = mbox_rx_cmd;
-    mbox->w1 = mbox_rx_w1;
-    mbox->w2 = mbox_rx_w2;
-    mbox->w3 = mbox_rx_w3;
+    else {
+        mbox->cmd = mbox_rx_cmd;
+        mbox->w1 = mbox_rx_w1;
+        mbox->w2 = mbox_rx_w2;
+        mbox->w3 = mbox_rx_w3;
+    }
 
     DBG("mbox.w1:  0x%x\n", mbox->w1);
     DBG("mbox.w2:  0x%x\n", mbox->w2);
@@ -979,6 +1093,57 @@ int dsplib_cmd_recv(dsplib_mbox_t *mbox, unsigned int cmd)
 } /* End of dsplib_cmd_recv() */
 
 
+#ifdef CONFIG_PROC_FS
+/*!*************************************************************************
+* dsplib_read_proc
+* 
+* Private Function
+*/
+/*!
+* \brief
+*	Show mailbox statistics in /proc/wmt-dsplib
+*
+* \retval  length of data
+*/ 
+static int dsplib_read_proc(
+    char *page,
+    char **start,
+    off_t off,
+    int count,
+    int *eof,
+    void *data)
+{
+    char *p = page;
+    unsigned int avg = 0;
+    int len;
+
+    if (dsp_stat.rx_done) {
+        unsigned long long total = dsp_stat.lat_total;
+
+        do_div(total, dsp_stat.rx_done);
+        avg = (unsigned int)total;
+    }
+
+    p += sprintf(p, "tx_cmd:       %u\n", dsp_stat.tx_cmd);
+    p += sprintf(p, "rx_done:      %u\n", dsp_stat.rx_done);
+    p += sprintf(p, "rx_pending:   %u\n", dsp_rx_queue.head - dsp_rx_queue.tail);
+    p += sprintf(p, "rx_overflow:  %u\n", dsp_stat.rx_overflow);
+    p += sprintf(p, "latency(us):  last %u, min %u, max %u, avg %u\n",
+                 dsp_stat.lat_last / DSP_OSCR_PER_US, dsp_stat.lat_min / DSP_OSCR_PER_US,
+                 dsp_stat.lat_max / DSP_OSCR_PER_US, avg / DSP_OSCR_PER_US);
+    p += sprintf(p, "dsp_reset:    %d\n", dsp_reset_flag);
+
+    len = (p - page) - off;
+    if (len < 0)
+        len = 0;
+    *eof = len <= count;
+    *start = page + off;
+
+    return len;
+}
+#endif
+
+
 /*--------------------End of Function Body -----------------------------------*/
 
 #undef WMT_DSPLIB_C
@@ -141,6 +141,28 @@ typedef struct dsp_done_s {
     int frame_bitcnt;
 } dsp_done_t;
 
+/*
+ * Completions posted by DSP. Filled by mailbox ISR (single producer) and
+ * drained by dsplib_cmd_recv() (single consumer), so no lock is needed.
+ */
+#define DSPLIB_RX_QUEUE_NUM     16      /* Must be power of 2 */
+
+typedef struct dsplib_mbox_queue_s {
+    volatile unsigned int head;         /* Updated by ISR only */
+    volatile unsigned int tail;         /* Updated by dsplib_cmd_recv() only */
+    dsplib_mbox_t mbox[DSPLIB_RX_QUEUE_NUM];
+} dsplib_mbox_queue_t;
+
+typedef struct dsplib_stat_s {
+    unsigned int tx_cmd;                /* Commands sent to DSP */
+    unsigned int rx_done;               /* Frame/segment completions from DSP */
+    unsigned int rx_overflow;           /* Completions dropped by full queue */
+    unsigned int lat_last;              /* Round-trip latency (OSCR ticks) */
+    unsigned int lat_min;
+    unsigned int lat_max;
+    unsigned long long lat_total;
+} dsplib_stat_t;
+
 typedef struct dsplib_fw_s {
   char *name;
   char *start_addr;
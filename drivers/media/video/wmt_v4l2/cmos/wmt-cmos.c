@@ -29,6 +29,9 @@
 #include <linux/platform_device.h>//platform_bus_type
 
 #include <linux/i2c.h>      //I2C_M_RD
+#include <linux/proc_fs.h>
+#include <linux/poll.h>
+#include <asm/div64.h>
 #include <mach/memblock.h>
 
 /* V4L2 */
@@ -102,6 +105,13 @@ static int cmos_dev_minor = 1;
 static int cmos_dev_nr = 1;
 struct file *gfilp;
 
+/* Max. number of capture buffers an application may request */
+static unsigned int queue_depth = MAX_FB_IN_QUEUE;
+module_param(queue_depth, uint, 0644);
+MODULE_PARM_DESC(queue_depth, "Max. number of capture buffers (default 10)");
+
+static struct platform_device cmos_device;
+
 
  #define SA_INTERRUPT IRQF_DISABLED
 
@@ -323,48 +333,97 @@ static int cam_enable(cmos_drvinfo_t *drv, int en)
     return 0;
 } /* End of cam_enable() */
 
-static int print_queue(cmos_drvinfo_t *drv)
+static void cmos_set_vid_addr(cmos_drvinfo_t *drv, struct videobuf_buffer *vb)
 {
-#ifdef CMOS_DEBUG
-    struct list_head *next;
-    cmos_fb_t  *fb;
-    
-    TRACE("Enter\n");
+    unsigned int y_addr;
 
-    list_for_each(next, &drv->head) {
-        fb = (cmos_fb_t *) list_entry(next, cmos_fb_t, list);
-        DBG_MSG("[%d] y_addr: 0x%x, c_addr: 0x%x\n",
-                            fb->id, fb->y_addr, fb->c_addr );
+    if( vb ) {
+        y_addr = wmt_vb_mb_to_phys(vb);
+        wmt_vid_set_addr(y_addr, y_addr + ALIGN64(drv->width) * drv->height);
     }
-    TRACE("Leave\n");
-#endif
-    return 0;
-} /* End of print_queue();*/
+    else {
+        /* No buffer queued, let VID DMA write to default buffer */
+        wmt_vid_set_addr(drv->dft_y_addr, drv->dft_c_addr);
+    }
+    drv->cur_vb = vb;
+} /* End of cmos_set_vid_addr() */
 
-static int put_queue(cmos_drvinfo_t *drv, cmos_fb_t *fb_in)
+/*------------------------------------------------------------------------------
+    videobuf queue operations
+------------------------------------------------------------------------------*/
+
+static int cmos_vb_setup(struct videobuf_queue *vq, unsigned int *count, 
+                         unsigned int *size)
 {
-    TRACE("Enter\n");
+    struct cmos_dev_s *dev = vq->priv_data;
+    cmos_drvinfo_t *drv = &dev->drvinfo;
+    unsigned int max = min(queue_depth, (unsigned int)VIDEO_MAX_FRAME);
 
-    list_add_tail(&fb_in->list, &drv->head);
+    *size = drv->frame_size;
+    if( (*count == 0) || (*count > max) ) {
+        *count = max;
+    }
+    DBG_MSG(" count: %d, size: %d\n", *count, *size);
 
-    print_queue(drv);
+    return 0;
+} /* End of cmos_vb_setup() */
 
-    TRACE("Leave\n");
+static void cmos_vb_free(struct videobuf_queue *vq, struct videobuf_buffer *vb)
+{
+    wmt_vb_mb_free(vq, vb);
+    vb->state = VIDEOBUF_NEEDS_INIT;
+} /* End of cmos_vb_free() */
+
+static int cmos_vb_prepare(struct videobuf_queue *vq, struct videobuf_buffer *vb,
+                           enum v4l2_field field)
+{
+    struct cmos_dev_s *dev = vq->priv_data;
+    cmos_drvinfo_t *drv = &dev->drvinfo;
+    int ret;
+
+    if( (vb->baddr != 0) && (vb->bsize < drv->frame_size) ) {
+        DBG_ERR("User buffer too small (%d < %d)\n", vb->bsize, drv->frame_size);
+        return -EINVAL;
+    }
+    vb->size   = drv->frame_size;
+    vb->width  = drv->width;
+    vb->height = drv->height;
+    vb->field  = field;
+
+    if( vb->state == VIDEOBUF_NEEDS_INIT ) {
+        /* USERPTR must be physically contiguous, e.g. from memblock */
+        ret = videobuf_iolock(vq, vb, NULL);
+        if( ret ) {
+            cmos_vb_free(vq, vb);
+            return ret;
+        }
+    }
+    vb->state = VIDEOBUF_PREPARED;
 
     return 0;
-} /* End of put_queue() */
+} /* End of cmos_vb_prepare() */
 
-static int pop_queue(cmos_drvinfo_t *drv, cmos_fb_t *fb_in)
+/* Called with cmos_lock held */
+static void cmos_vb_queue(struct videobuf_queue *vq, struct videobuf_buffer *vb)
 {
-    TRACE("Enter\n");
+    struct cmos_dev_s *dev = vq->priv_data;
+    cmos_drvinfo_t *drv = &dev->drvinfo;
 
-    list_del(&fb_in->list);
-    print_queue(drv);
-    
-    TRACE("Leave\n");
+    vb->state = VIDEOBUF_QUEUED;
+    list_add_tail(&vb->queue, &drv->head);
+} /* End of cmos_vb_queue() */
 
-    return 0;
-} /* End of pop_queue() */
+static void cmos_vb_release(struct videobuf_queue *vq, struct videobuf_buffer *vb)
+{
+    cmos_vb_free(vq, vb);
+} /* End of cmos_vb_release() */
+
+static struct videobuf_queue_ops cmos_vb_ops = {
+    .buf_setup   = cmos_vb_setup,
+    .buf_prepare = cmos_vb_prepare,
+    .buf_queue   = cmos_vb_queue,
+    .buf_release = cmos_vb_release,
+};
 
 /*------------------------------------------------------------------------------
     Export V4L2 functions for CMOS camera 
@@ -429,14 +488,38 @@ int cmos_cam_s_fmt_cap(struct file *file, void *fh, struct v4l2_format *f)
     struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
     cmos_drvinfo_t *drv = &dev->drvinfo;
     int dev_id = f->fmt.pix.priv; // enable which device
-    
+    unsigned int width, height, frame_size, dft_virt;
     int ret;
 
     TRACE("Enter\n");
 
-	drv->width  = f->fmt.pix.width;
-	drv->height = f->fmt.pix.height;
-    	drv->frame_size = ALIGN64(drv->width) * drv->height << 1; // "<< 1" is for YC422
+    /* Capture buffers are sized for the current format until freed */
+    mutex_lock(&drv->vb_vidq.vb_lock);
+    ret = drv->vb_vidq.streaming || drv->vb_vidq.bufs[0];
+    mutex_unlock(&drv->vb_vidq.vb_lock);
+    if( ret ) {
+        DBG_ERR("Can't change format while buffers are allocated\n");
+        return -EBUSY;
+    }
+    width  = f->fmt.pix.width;
+    height = f->fmt.pix.height;
+    frame_size = ALIGN64(width) * height << 1; // "<< 1" is for YC422
+
+    /* Default buffer catches frames when no capture buffer is queued */
+    dft_virt = (unsigned int) mb_allocate(frame_size);
+    if( dft_virt == 0 ) {
+        DBG_ERR("Allocate MB memory (%d) fail!\n", frame_size);
+        return -ENOMEM;
+    }
+    if( drv->dft_y_addr ) {
+        mb_free((unsigned int) phys_to_virt(drv->dft_y_addr));
+    }
+    drv->width  = width;
+    drv->height = height;
+    drv->frame_size = frame_size;
+    drv->dft_y_addr = (unsigned int) virt_to_phys((void *)dft_virt);
+    drv->dft_c_addr = drv->dft_y_addr + ALIGN64(drv->width) * drv->height;
+    wmt_vid_set_addr(drv->dft_y_addr, drv->dft_c_addr);
    
     DBG_MSG(" width:      %d\n", drv->width);
     DBG_MSG(" height:     %d\n", drv->height);
@@ -485,71 +568,40 @@ int cmos_cam_reqbufs(struct file *file, void *fh, struct v4l2_requestbuffers *rb
     struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
     cmos_drvinfo_t *drv = &dev->drvinfo;
 
-    cmos_fb_t *fb;
-    int  i, j;
-
     TRACE("Enter\n");
-
-    if((rb->type != V4L2_BUF_TYPE_VIDEO_CAPTURE) || (rb->memory != V4L2_MEMORY_MMAP)
-        || (rb->count > MAX_FB_IN_QUEUE) ) {
-        printk("rb->type: 0x%x, rb->memory: 0x%x, rb->count: %d\n", 
-                                               rb->type, rb->memory, rb->count);
-        return -EINVAL;
-    }
- 
-    drv->fb_cnt = rb->count;
-
     DBG_MSG(" Frame Size: %d Bytes\n", drv->frame_size);
-    DBG_MSG(" fb_cnt:     %d\n", drv->fb_cnt);
-
-    /* Allocate memory */
-    for(i=0; i<drv->fb_cnt; i++) {
-        fb = &drv->fb_pool[i];
-        fb->y_addr = (unsigned int) (virt_to_phys((void *)mb_allocate(drv->frame_size)));
-        if( fb->y_addr == 0 ) {
-            /* Allocate MB memory size fail */
-            DBG_ERR("[%d] Allocate MB memory (%d) fail!\n", i, drv->frame_size);
-            for(j=0; j<i; j++) {
-                fb = &drv->fb_pool[j];
-        	    mb_free((unsigned int) phys_to_virt(fb->y_addr) );
-            }
-            return -EINVAL; 
-        }
-        fb->c_addr  = fb->y_addr + ALIGN64(drv->width) * drv->height;
-        fb->id = i;
-        fb->is_busy = 0;
-        fb->done    = 0;
-        DBG_MSG("[%d] fb: 0x%x, y_addr: 0x%x, c_addr: 0x%x\n", 
-                   i, (unsigned int)fb, fb->y_addr, fb->c_addr);
-    }
-    TRACE("Leave\n");
 
-	return 0;
+	return videobuf_reqbufs(&drv->vb_vidq, rb);
 }
 EXPORT_SYMBOL(cmos_cam_reqbufs);
 
+static void cmos_buf_phys(cmos_drvinfo_t *drv, struct v4l2_buffer *b)
+{
+    /* Let AP hand the frame to JPEG encoder or display by physical address */
+    if( (b->memory == V4L2_MEMORY_MMAP) && (b->index < VIDEO_MAX_FRAME) && 
+        drv->vb_vidq.bufs[b->index] ) {
+        b->reserved = wmt_vb_mb_to_phys(drv->vb_vidq.bufs[b->index]);
+    }
+} /* End of cmos_buf_phys() */
+
 int cmos_cam_querybuf(struct file *file, void *fh, struct v4l2_buffer *b)
 {
     struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
     cmos_drvinfo_t *drv = &dev->drvinfo;
+    int ret;
 
     TRACE("Enter (index: %d)\n", b->index);
 
-    if( b->index < MAX_FB_IN_QUEUE ) {
-        cmos_fb_t *fb = &drv->fb_pool[b->index];
-        b->length   = drv->frame_size;
-        b->m.offset = fb->y_addr;
-    }
-    else {
-        b->length   = 0;
-        b->m.offset = 0;
+    ret = videobuf_querybuf(&drv->vb_vidq, b);
+    if( ret == 0 ) {
+        cmos_buf_phys(drv, b);
     }
     DBG_MSG(" b->length:     %d\n", b->length);
     DBG_MSG(" b->m.offset: 0x%x\n", b->m.offset);
 
     TRACE("Leave (index: %d)\n", b->index);
 
-	return 0;
+	return ret;
 }
 EXPORT_SYMBOL(cmos_cam_querybuf);
 
@@ -558,16 +610,9 @@ int cmos_cam_qbuf(struct file *file, void *fh, struct v4l2_buffer *b)
     struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
     cmos_drvinfo_t *drv = &dev->drvinfo;
 
-    cmos_fb_t *fb;
-
     TRACE("Enter (index: %d)\n", b->index);
-    
-    fb = &drv->fb_pool[b->index];
-    put_queue(drv, fb);
 
-    TRACE("Leave (index: %d)\n", b->index);
-
-	return 0;
+	return videobuf_qbuf(&drv->vb_vidq, b);
 }
 EXPORT_SYMBOL(cmos_cam_qbuf);
 
@@ -575,48 +620,27 @@ int cmos_cam_dqbuf(struct file *file, void *fh, struct v4l2_buffer *b)
 {
     struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
     cmos_drvinfo_t    *drv = &dev->drvinfo;
-    unsigned long      flags =0;
-    cmos_fb_t *fb = 0;
+    struct timeval     now;
+    unsigned int       lat;
+    int ret;
 
     TRACE("Enter (index: %d)\n", b->index);
 
-    if( drv->streamoff ) {
-        struct list_head  *next;
-
-        /* CMOS sensor did not work now */
-        list_for_each(next, &drv->head) {
-            fb = (cmos_fb_t *) list_entry(next, cmos_fb_t, list);
-            if( fb ) {
-                pop_queue(drv, fb);    
-                break;
-            }
-        }
-        goto EXIT_cmos_cam_dqbuf;
+    ret = videobuf_dqbuf(&drv->vb_vidq, b, file->f_flags & O_NONBLOCK);
+    if( ret ) {
+        return ret;
     }
-    
-    fb = (cmos_fb_t *)wmt_vid_get_cur_fb();
-    
-    spin_lock_irqsave(&cmos_lock, flags);
-
-    DBG_MSG("Set DQBUF on\n");
-    drv->dqbuf  = 1;
-
-    spin_unlock_irqrestore(&cmos_lock, flags);
-    
-    if( (wait_event_interruptible_timeout( cmos_wait,
-                      (drv->_status & STS_CMOS_FB_DONE), drv->_timeout) == 0) ){
-        DBG_ERR("CMOS Time out in %d ms\n", drv->_timeout);
+    cmos_buf_phys(drv, b);
+
+    do_gettimeofday(&now);
+    lat = (now.tv_sec - b->timestamp.tv_sec) * USEC_PER_SEC + 
+          now.tv_usec - b->timestamp.tv_usec;
+    drv->stat.lat_last   = lat;
+    drv->stat.lat_total += lat;
+    if( lat > drv->stat.lat_max ) {
+        drv->stat.lat_max = lat;
     }
-    drv->_status &= (~STS_CMOS_FB_DONE);
-
-    DBG_MSG("[%d] fb: 0x%p\n", fb->id, fb);
-    pop_queue(drv, fb);    
-
-    b->length   = drv->frame_size;
-    b->m.offset = fb->y_addr;
-    b->index    = fb->id;
 
-EXIT_cmos_cam_dqbuf:
     TRACE("Leave (index: %d)\n", b->index);
 
     return 0;
@@ -676,13 +700,26 @@ int cmos_cam_streamon(struct file *file, void *fh, enum v4l2_buf_type i)
 {
     struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
     cmos_drvinfo_t *drv = &dev->drvinfo;
-    cmos_fb_t  *fb;
+    struct videobuf_buffer *vb = NULL;
+    unsigned long flags = 0;
+    int ret;
 
     TRACE("Enter\n");
 
-    fb = (cmos_fb_t *) list_entry(drv->head.next, cmos_fb_t, list);
+    ret = videobuf_streamon(&drv->vb_vidq);
+    if( ret ) {
+        return ret;
+    }
+    memset(&drv->stat, 0, sizeof(cmos_stat_t));
 
-    wmt_vid_set_cur_fb((vid_fb_t *)fb);
+    spin_lock_irqsave(&cmos_lock, flags);
+    if( !list_empty(&drv->head) ) {
+        vb = list_entry(drv->head.next, struct videobuf_buffer, queue);
+        list_del_init(&vb->queue);
+        vb->state = VIDEOBUF_ACTIVE;
+    }
+    cmos_set_vid_addr(drv, vb);
+    spin_unlock_irqrestore(&cmos_lock, flags);
 
     cam_enable(drv, 1);
     
@@ -696,10 +733,23 @@ int cmos_cam_streamoff(struct file *file, void *fh, enum v4l2_buf_type i)
 {
     struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
     cmos_drvinfo_t *drv = &dev->drvinfo;
+    unsigned long flags = 0;
 
     TRACE("Enter\n");
 
     cam_enable(drv, 0);
+
+    spin_lock_irqsave(&cmos_lock, flags);
+    if( drv->cur_vb ) {
+        drv->cur_vb->state = VIDEOBUF_ERROR;
+        wake_up_all(&drv->cur_vb->done);
+    }
+    cmos_set_vid_addr(drv, NULL);
+    spin_unlock_irqrestore(&cmos_lock, flags);
+
+    /* Queued buffers are removed from drv->head by videobuf_queue_cancel() */
+    videobuf_streamoff(&drv->vb_vidq);
+    INIT_LIST_HEAD(&drv->head);
     
     TRACE("Leave\n");
 
@@ -709,22 +759,22 @@ EXPORT_SYMBOL(cmos_cam_streamoff);
 
 int cmos_cam_mmap(struct file *file, struct vm_area_struct *vma)
 {
-    int ret = 0;
+    struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
     
     TRACE("Enter\n");
 
-	vma->vm_flags |= VM_IO | VM_RESERVED;
-	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
-	if (remap_pfn_range(vma, vma->vm_start, vma->vm_pgoff,
-	                    vma->vm_end - vma->vm_start, vma->vm_page_prot)){
-		ret = -EAGAIN;
-    }
-    TRACE("Leave\n");
-    
-    return ret;
+    return videobuf_mmap_mapper(&dev->drvinfo.vb_vidq, vma);
 }
 EXPORT_SYMBOL(cmos_cam_mmap);
 
+unsigned int cmos_cam_poll(struct file *file, struct poll_table_struct *wait)
+{
+    struct cmos_dev_s *dev = (struct cmos_dev_s *)file->private_data;
+
+    return videobuf_poll_stream(file, &dev->drvinfo.vb_vidq, wait);
+}
+EXPORT_SYMBOL(cmos_cam_poll);
+
 /*!*************************************************************************
 * cmos_isr
 * 
@@ -743,54 +793,43 @@ static void cmos_isr(void)
 {
     struct cmos_dev_s *dev = (struct cmos_dev_s *)dev_in;
     cmos_drvinfo_t    *drv;
-    struct list_head  *next;
-    cmos_fb_t *cur_fb, *fb;
-    unsigned long flags =0;
-    int mb_count=0;   
+    struct videobuf_buffer *vb;
+
     TRACE("Enter\n");
     if( dev == 0 ) {        
         return IRQ_NONE;
     }
     drv = &dev->drvinfo;
 
-    if( drv->dqbuf == 1 ) {
-        spin_lock_irqsave(&cmos_lock, flags);
-        drv->dqbuf = 0;
-        DBG_MSG("Set DBBUF off\n");
-        spin_unlock_irqrestore(&cmos_lock, flags);
-
-        cur_fb = (cmos_fb_t *)wmt_vid_get_cur_fb();
-        list_for_each(next, &drv->head) {
-            fb = (cmos_fb_t *) list_entry(next, cmos_fb_t, list);
-            if( fb == cur_fb ) {
-                /*-------------------------------------------------------------- 
-                    Get next FB 
-                --------------------------------------------------------------*/
-                fb = (cmos_fb_t *) list_entry(cur_fb->list.next, cmos_fb_t, list);
-
-                do{
-		     if (((vid_fb_t *)fb)->y_addr != 0)
-			  mb_count = mb_counter(((vid_fb_t *)fb)->y_addr);
-	                if (mb_count !=1)
-	                {
-	                	fb = (cmos_fb_t *) list_entry(fb->list.next, cmos_fb_t, list);
-				DBG_MSG("mbcount skip 0x%08x mb_count %d \n",((vid_fb_t *)fb)->y_addr,mb_count);
-				continue;
-	                }
-                }while((mb_count !=1)&&(fb != cur_fb));
-                fb->is_busy = 0;
-                fb->done    = 1;
-                DBG_MSG("[%d] done: %d, is_busy: %d\n", cur_fb->id, cur_fb->done, cur_fb->is_busy);
-                DBG_MSG("[%d] New FB done: %d, is_busy: %d\n", fb->id, fb->done, fb->is_busy);
-
-                wmt_vid_set_cur_fb((vid_fb_t *)fb); 
-
-                drv->_status |= STS_CMOS_FB_DONE;
-                wake_up_interruptible(&cmos_wait);
-                break;
-            }
+    spin_lock(&cmos_lock);
+    if( !drv->streamoff ) {
+        /*----------------------------------------------------------------------
+            The frame just finished was written to the buffer set in last ISR
+        ----------------------------------------------------------------------*/
+        vb = drv->cur_vb;
+        if( vb ) {
+            do_gettimeofday(&vb->ts);
+            vb->field_count = drv->stat.frames << 1;
+            vb->state = VIDEOBUF_DONE;
+            wake_up(&vb->done);
+            drv->stat.frames++;
+        }
+        else {
+            drv->stat.dropped++;
         }
-    } /* if( drv->dqbuf == 1 ) */
+        /*----------------------------------------------------------------------
+            Get next FB 
+        ----------------------------------------------------------------------*/
+        vb = NULL;
+        if( !list_empty(&drv->head) ) {
+            vb = list_entry(drv->head.next, struct videobuf_buffer, queue);
+            list_del_init(&vb->queue);
+            vb->state = VIDEOBUF_ACTIVE;
+        }
+        cmos_set_vid_addr(drv, vb);
+    }
+    spin_unlock(&cmos_lock);
+
  	CMOS_REG_SET32(REG_VID_INT_CTRL, REG32_VAL(REG_VID_INT_CTRL));
 
     TRACE("Leave\n");
@@ -847,7 +886,6 @@ static int cmos_open(struct file *filp)
 	drv->height = 480;
 	drv->_timeout = 100;   // ms
 	drv->_status  = STS_CMOS_READY;
-	drv->dqbuf    = 0;
 	drv->frame_size = ALIGN64(drv->width) * drv->height << 1; // "<< 1" is for YC422
 	drv->dft_y_addr = (unsigned int) (virt_to_phys((void *)mb_allocate(drv->frame_size)));
 	if( drv->dft_y_addr == 0 ) {
@@ -861,9 +899,14 @@ static int cmos_open(struct file *filp)
  
     	/* init std_head */
     	INIT_LIST_HEAD(&drv->head);
+	drv->cur_vb = NULL;
 
     	spin_lock_init(&cmos_lock);
 
+	wmt_vb_mb_queue_init(&drv->vb_vidq, &cmos_vb_ops, &cmos_device.dev,
+			&cmos_lock, V4L2_BUF_TYPE_VIDEO_CAPTURE, V4L2_FIELD_NONE,
+			sizeof(struct videobuf_buffer), dev);
+
     /*--------------------------------------------------------------------------
         Step 3:
     --------------------------------------------------------------------------*/
@@ -892,8 +935,6 @@ static int cmos_release(struct file *filp)
 {
     struct cmos_dev_s *dev = (struct cmos_dev_s *)filp->private_data;
     cmos_drvinfo_t *drv = 0;
-    cmos_fb_t *fb;
-    int  i;    
 
     TRACE("Enter\n");
     printk("cmos_release() \n");
@@ -909,14 +950,12 @@ static int cmos_release(struct file *filp)
     DBG_MSG("dev: 0x%x, drv: 0x%x\n", (unsigned int)dev, (unsigned int)drv);
     
     if( drv ) {
-        /* Free memory */
-        for(i=0; i<drv->fb_cnt; i++) {
-            fb = &drv->fb_pool[i];
-            if( fb->y_addr ) {
-        	    mb_free((unsigned int) phys_to_virt(fb->y_addr) );
-        	    memset(fb, 0, sizeof(cmos_fb_t));
-            }
-        }
+        /* Free capture buffers */
+        cam_enable(drv, 0);
+        videobuf_stop(&drv->vb_vidq);
+        videobuf_mmap_free(&drv->vb_vidq);
+        INIT_LIST_HEAD(&drv->head);
+        drv->cur_vb = NULL;
     }
     mb_free((unsigned int) phys_to_virt(drv->dft_y_addr) );
     
@@ -1099,6 +1138,7 @@ static struct platform_device cmos_device = {
 	.dev = { 
 		.release = cmos_platform_release,
 		.dma_mask = &cmos_dma_mask,
+		.coherent_dma_mask = 0xffffffff,
 	},
 	.num_resources = 0,     /* ARRAY_SIZE(rmtctl_resources), */
 	.resource = NULL,       /* rmtctl_resources, */
@@ -1111,6 +1151,45 @@ static struct platform_device cmos_device = {
 
 
 
+#ifdef CONFIG_PROC_FS
+/*!*************************************************************************
+* cmos_read_proc
+* 
+* Private Function
+*/
+/*!
+* \brief
+*       Show capture statistics in /proc/wmt-cmos
+* \retval  length of data
+*/ 
+static int cmos_read_proc(char *page, char **start, off_t off, int count, int *eof, void *data)
+{
+    cmos_drvinfo_t *drv = &dev_s.drvinfo;
+    unsigned long long avg = 0;
+    char *p = page;
+    int len;
+
+    if( drv->stat.frames ) {
+        avg = drv->stat.lat_total;
+        do_div(avg, drv->stat.frames);
+    }
+    p += sprintf(p, "resolution:   %d x %d\n", drv->width, drv->height);
+    p += sprintf(p, "queue_depth:  %d\n", queue_depth);
+    p += sprintf(p, "frames:       %u\n", drv->stat.frames);
+    p += sprintf(p, "dropped:      %u\n", drv->stat.dropped);
+    p += sprintf(p, "latency(us):  last %u, max %u, avg %u\n", 
+                 drv->stat.lat_last, drv->stat.lat_max, (unsigned int)avg);
+
+    len = (p - page) - off;
+    if (len < 0)
+        len = 0;
+    *eof = len <= count;
+    *start = page + off;
+
+    return len;
+} /* End of cmos_read_proc() */
+#endif
+
 /*!*************************************************************************
 * cmos_init
 * 
@@ -1135,6 +1214,9 @@ static int cmos_init(void)
     
 	ret = platform_driver_probe(&cmos_driver, cmos_probe);
 
+#ifdef CONFIG_PROC_FS
+	create_proc_read_entry("wmt-cmos", 0, NULL, cmos_read_proc, NULL);
+#endif
      TRACE("Leave\n");
 
 	return ret;
@@ -1159,6 +1241,9 @@ static void cmos_exit(void)
 
     TRACE("Enter\n");
 	printk(KERN_ALERT "Enter cmos_exit\n");
+#ifdef CONFIG_PROC_FS
+	remove_proc_entry("wmt-cmos", NULL);
+#endif
 	
 	driver_unregister(&cmos_driver);
 	platform_device_unregister(&cmos_device);
@@ -31,6 +31,9 @@
 
 #include "../wmt-vid.h"
 
+#ifdef __KERNEL__
+#include "../wmt-vb-mb.h"
+#endif
 
 #define MAX_FB_IN_QUEUE            10
 
@@ -56,9 +59,19 @@ typedef struct {
   #endif
 } cmos_fb_t;
 
+typedef struct {
+    unsigned int  frames;       /* Frames delivered to application */
+    unsigned int  dropped;      /* Frames lost because no buffer was queued */
+    unsigned int  lat_last;     /* Capture done to DQBUF latency (us) */
+    unsigned int  lat_max;
+    unsigned long long lat_total;
+} cmos_stat_t;
+
 typedef struct {
   #ifdef __KERNEL__
-    struct list_head  head;
+    struct videobuf_queue   vb_vidq;
+    struct list_head        head;    /* Buffers queued for VID DMA */
+    struct videobuf_buffer *cur_vb;  /* Buffer VID DMA is writing now */
   #endif
 
 	unsigned int  frame_size;
@@ -68,11 +81,9 @@ typedef struct {
 	unsigned int  dft_y_addr;
 	unsigned int  dft_c_addr;
     
-    cmos_fb_t     fb_pool[MAX_FB_IN_QUEUE];
-    unsigned int  fb_cnt;
-    
     unsigned int  streamoff;
-    unsigned int  dqbuf;
+
+    cmos_stat_t   stat;
 
     cmos_status   _status;
     unsigned int  _timeout;
@@ -0,0 +1,386 @@
+/*++
+ * linux/drivers/media/video/wmt_v4l2/wmt-vb-mb.c
+ * WonderMedia videobuf buffers in memblock
+ *
+ * Copyright c 2010  WonderMedia  Technologies, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * WonderMedia Technologies, Inc.
+ * 4F, 533, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C
+--*/
+
+/*
+ * videobuf memory type for capture buffers taken from memblock.  It works
+ * like videobuf-dma-contig, but a few VGA frames do not fit in the 4 MB
+ * consistent DMA pool, which other drivers share too.  The kernel mapping
+ * of memblock is cached: buffers are flushed when allocated and the part
+ * copied by read() is invalidated first, user space maps them uncached.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/mm.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <asm/cacheflush.h>
+#include <asm/uaccess.h>
+#include <mach/memblock.h>
+
+#include "wmt-vb-mb.h"
+
+#define THE_MB_USER "WMT-VB"
+
+struct wmt_vb_mb_memory {
+	u32 magic;
+	void *vaddr;
+	unsigned int phys;
+	unsigned long size;
+	int is_userptr;
+};
+
+#define MAGIC_MB_MEM 0x0733ac62
+#define MAGIC_CHECK(is, should)						    \
+	if (unlikely((is) != (should)))	{				    \
+		pr_err("magic mismatch: %x expected %x\n", (is), (should)); \
+		BUG();							    \
+	}
+
+static int wmt_vb_mb_alloc_mem(struct wmt_vb_mb_memory *mem,
+			       unsigned long size)
+{
+	mem->size = PAGE_ALIGN(size);
+	mem->vaddr = (void *)mb_allocate(mem->size);
+	if (!mem->vaddr) {
+		printk(KERN_ERR "wmt-vb-mb: mb_allocate %ld failed\n",
+		       mem->size);
+		return -ENOMEM;
+	}
+	/* no dirty line may be written back over a captured frame */
+	dmac_flush_range(mem->vaddr, mem->vaddr + mem->size);
+	mem->phys = virt_to_phys(mem->vaddr);
+	return 0;
+}
+
+static void wmt_vb_mb_free_mem(struct wmt_vb_mb_memory *mem)
+{
+	mb_free((unsigned long)mem->vaddr);
+	mem->vaddr = NULL;
+	mem->phys = 0;
+}
+
+static void wmt_vb_vm_open(struct vm_area_struct *vma)
+{
+	struct videobuf_mapping *map = vma->vm_private_data;
+
+	map->count++;
+}
+
+static void wmt_vb_vm_close(struct vm_area_struct *vma)
+{
+	struct videobuf_mapping *map = vma->vm_private_data;
+	struct videobuf_queue *q = map->q;
+	struct wmt_vb_mb_memory *mem;
+	int i;
+
+	map->count--;
+	if (map->count)
+		return;
+
+	mutex_lock(&q->vb_lock);
+
+	/* We need first to cancel streams, before unmapping */
+	if (q->streaming)
+		videobuf_queue_cancel(q);
+
+	for (i = 0; i < VIDEO_MAX_FRAME; i++) {
+		if (!q->bufs[i] || q->bufs[i]->map != map)
+			continue;
+
+		mem = q->bufs[i]->priv;
+		if (mem) {
+			MAGIC_CHECK(mem->magic, MAGIC_MB_MEM);
+			if (mem->vaddr)
+				wmt_vb_mb_free_mem(mem);
+		}
+		q->bufs[i]->map   = NULL;
+		q->bufs[i]->baddr = 0;
+	}
+	kfree(map);
+
+	mutex_unlock(&q->vb_lock);
+}
+
+static const struct vm_operations_struct wmt_vb_vm_ops = {
+	.open     = wmt_vb_vm_open,
+	.close    = wmt_vb_vm_close,
+};
+
+/* Accept only physically contiguous pfn-mapped user memory, e.g. memblock */
+static int wmt_vb_mb_user_get(struct wmt_vb_mb_memory *mem,
+			      struct videobuf_buffer *vb)
+{
+	struct mm_struct *mm = current->mm;
+	struct vm_area_struct *vma;
+	unsigned long prev_pfn = 0, this_pfn;
+	unsigned long pages_done, user_address;
+	int ret = -EINVAL;
+
+	mem->size = PAGE_ALIGN(vb->size);
+	mem->is_userptr = 0;
+
+	down_read(&mm->mmap_sem);
+
+	vma = find_vma(mm, vb->baddr);
+	if (!vma || (vb->baddr + mem->size) > vma->vm_end)
+		goto out_up;
+
+	user_address = vb->baddr;
+	for (pages_done = 0; pages_done < (mem->size >> PAGE_SHIFT);
+	     pages_done++) {
+		ret = follow_pfn(vma, user_address, &this_pfn);
+		if (ret)
+			break;
+		if (pages_done == 0)
+			mem->phys = this_pfn << PAGE_SHIFT;
+		else if (this_pfn != (prev_pfn + 1)) {
+			ret = -EFAULT;
+			break;
+		}
+		prev_pfn = this_pfn;
+		user_address += PAGE_SIZE;
+	}
+
+	if (!ret)
+		mem->is_userptr = 1;
+
+out_up:
+	up_read(&mm->mmap_sem);
+	return ret;
+}
+
+static void *__wmt_vb_alloc(size_t size)
+{
+	struct wmt_vb_mb_memory *mem;
+	struct videobuf_buffer *vb;
+
+	vb = kzalloc(size + sizeof(*mem), GFP_KERNEL);
+	if (vb) {
+		mem = vb->priv = ((char *)vb) + size;
+		mem->magic = MAGIC_MB_MEM;
+	}
+	return vb;
+}
+
+static void *__wmt_vb_to_vmalloc(struct videobuf_buffer *buf)
+{
+	struct wmt_vb_mb_memory *mem = buf->priv;
+
+	BUG_ON(!mem);
+	MAGIC_CHECK(mem->magic, MAGIC_MB_MEM);
+
+	return mem->vaddr;
+}
+
+static int __wmt_vb_iolock(struct videobuf_queue *q,
+			   struct videobuf_buffer *vb,
+			   struct v4l2_framebuffer *fbuf)
+{
+	struct wmt_vb_mb_memory *mem = vb->priv;
+
+	BUG_ON(!mem);
+	MAGIC_CHECK(mem->magic, MAGIC_MB_MEM);
+
+	switch (vb->memory) {
+	case V4L2_MEMORY_MMAP:
+		/* allocated by __wmt_vb_mmap_mapper() */
+		if (!mem->vaddr)
+			return -EINVAL;
+		return 0;
+	case V4L2_MEMORY_USERPTR:
+		if (vb->baddr)
+			return wmt_vb_mb_user_get(mem, vb);
+		/* buffer for the read() method */
+		return wmt_vb_mb_alloc_mem(mem, vb->size);
+	default:
+		return -EINVAL;
+	}
+}
+
+static int __wmt_vb_mmap_free(struct videobuf_queue *q)
+{
+	unsigned int i;
+
+	for (i = 0; i < VIDEO_MAX_FRAME; i++) {
+		if (q->bufs[i] && q->bufs[i]->map)
+			return -EBUSY;
+	}
+	return 0;
+}
+
+static int __wmt_vb_mmap_mapper(struct videobuf_queue *q,
+				struct vm_area_struct *vma)
+{
+	struct wmt_vb_mb_memory *mem;
+	struct videobuf_mapping *map;
+	unsigned int first;
+	unsigned long size, offset = vma->vm_pgoff << PAGE_SHIFT;
+
+	if (!(vma->vm_flags & VM_WRITE) || !(vma->vm_flags & VM_SHARED))
+		return -EINVAL;
+
+	/* look for first buffer to map */
+	for (first = 0; first < VIDEO_MAX_FRAME; first++) {
+		if (!q->bufs[first])
+			continue;
+		if (V4L2_MEMORY_MMAP != q->bufs[first]->memory)
+			continue;
+		if (q->bufs[first]->boff == offset)
+			break;
+	}
+	if (VIDEO_MAX_FRAME == first)
+		return -EINVAL;
+
+	mem = q->bufs[first]->priv;
+	BUG_ON(!mem);
+	MAGIC_CHECK(mem->magic, MAGIC_MB_MEM);
+
+	map = kzalloc(sizeof(struct videobuf_mapping), GFP_KERNEL);
+	if (!map)
+		return -ENOMEM;
+
+	if (wmt_vb_mb_alloc_mem(mem, q->bufs[first]->bsize))
+		goto error;
+
+	size = min(vma->vm_end - vma->vm_start, mem->size);
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	if (remap_pfn_range(vma, vma->vm_start, mem->phys >> PAGE_SHIFT,
+			    size, vma->vm_page_prot)) {
+		wmt_vb_mb_free_mem(mem);
+		goto error;
+	}
+
+	map->start = vma->vm_start;
+	map->end = vma->vm_end;
+	map->q = q;
+	q->bufs[first]->map = map;
+	q->bufs[first]->baddr = vma->vm_start;
+
+	vma->vm_ops          = &wmt_vb_vm_ops;
+	vma->vm_flags       |= VM_DONTEXPAND;
+	vma->vm_private_data = map;
+
+	wmt_vb_vm_open(vma);
+	return 0;
+
+error:
+	kfree(map);
+	return -ENOMEM;
+}
+
+static int __wmt_vb_copy_to_user(struct videobuf_queue *q,
+				 char __user *data, size_t count,
+				 int nonblocking)
+{
+	struct wmt_vb_mb_memory *mem = q->read_buf->priv;
+	void *vaddr;
+
+	BUG_ON(!mem);
+	MAGIC_CHECK(mem->magic, MAGIC_MB_MEM);
+	BUG_ON(!mem->vaddr);
+
+	if (count > q->read_buf->size - q->read_off)
+		count = q->read_buf->size - q->read_off;
+
+	/* the frame was written by DMA behind the cache */
+	vaddr = mem->vaddr + q->read_off;
+	dmac_inv_range(vaddr, vaddr + count);
+	if (copy_to_user(data, vaddr, count))
+		return -EFAULT;
+
+	return count;
+}
+
+static int __wmt_vb_copy_stream(struct videobuf_queue *q,
+				char __user *data, size_t count, size_t pos,
+				int vbihack, int nonblocking)
+{
+	int ret;
+
+	ret = __wmt_vb_copy_to_user(q, data, count, nonblocking);
+	if ((ret == -EFAULT) && (pos == 0))
+		return -EFAULT;
+
+	return ret;
+}
+
+static struct videobuf_qtype_ops wmt_vb_mb_qops = {
+	.magic        = MAGIC_QTYPE_OPS,
+
+	.alloc        = __wmt_vb_alloc,
+	.iolock       = __wmt_vb_iolock,
+	.mmap_free    = __wmt_vb_mmap_free,
+	.mmap_mapper  = __wmt_vb_mmap_mapper,
+	.video_copy_to_user = __wmt_vb_copy_to_user,
+	.copy_stream  = __wmt_vb_copy_stream,
+	.vmalloc      = __wmt_vb_to_vmalloc,
+};
+
+void wmt_vb_mb_queue_init(struct videobuf_queue *q,
+			  struct videobuf_queue_ops *ops,
+			  struct device *dev,
+			  spinlock_t *irqlock,
+			  enum v4l2_buf_type type,
+			  enum v4l2_field field,
+			  unsigned int msize,
+			  void *priv)
+{
+	videobuf_queue_core_init(q, ops, dev, irqlock, type, field, msize,
+				 priv, &wmt_vb_mb_qops);
+}
+EXPORT_SYMBOL(wmt_vb_mb_queue_init);
+
+unsigned int wmt_vb_mb_to_phys(struct videobuf_buffer *buf)
+{
+	struct wmt_vb_mb_memory *mem = buf->priv;
+
+	BUG_ON(!mem);
+	MAGIC_CHECK(mem->magic, MAGIC_MB_MEM);
+
+	return mem->phys;
+}
+EXPORT_SYMBOL(wmt_vb_mb_to_phys);
+
+void wmt_vb_mb_free(struct videobuf_queue *q, struct videobuf_buffer *buf)
+{
+	struct wmt_vb_mb_memory *mem = buf->priv;
+
+	/* mmapped buffers are freed by wmt_vb_vm_close() */
+	if (buf->memory != V4L2_MEMORY_USERPTR || !mem)
+		return;
+
+	MAGIC_CHECK(mem->magic, MAGIC_MB_MEM);
+
+	if (buf->baddr) {
+		mem->is_userptr = 0;
+		mem->phys = 0;
+		mem->size = 0;
+		return;
+	}
+
+	/* read() method */
+	if (mem->vaddr)
+		wmt_vb_mb_free_mem(mem);
+}
+EXPORT_SYMBOL(wmt_vb_mb_free);
@@ -0,0 +1,44 @@
+/*++
+ * linux/drivers/media/video/wmt_v4l2/wmt-vb-mb.h
+ * WonderMedia videobuf buffers in memblock
+ *
+ * Copyright c 2010  WonderMedia  Technologies, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * WonderMedia Technologies, Inc.
+ * 4F, 533, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C
+--*/
+#ifndef WMT_VB_MB_H
+#define WMT_VB_MB_H
+
+#include <media/videobuf-core.h>
+
+/*
+ * Same interface as videobuf-dma-contig, but the buffers are physically
+ * contiguous memblock memory instead of the small consistent DMA pool.
+ */
+void wmt_vb_mb_queue_init(struct videobuf_queue *q,
+			  struct videobuf_queue_ops *ops,
+			  struct device *dev,
+			  spinlock_t *irqlock,
+			  enum v4l2_buf_type type,
+			  enum v4l2_field field,
+			  unsigned int msize,
+			  void *priv);
+
+unsigned int wmt_vb_mb_to_phys(struct videobuf_buffer *buf);
+void wmt_vb_mb_free(struct videobuf_queue *q, struct videobuf_buffer *buf);
+
+#endif /* WMT_VB_MB_H */
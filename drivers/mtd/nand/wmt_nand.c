@@ -55,6 +55,9 @@
 #include <mach/hardware.h>
 #include "wmt_nand.h"
 
+#define WMT_MMIO_TRACE_DEV	WMT_MMIO_NAND
+#include <mach/wmt_mmio.h>
+
 
 #ifndef memzero
 #define memzero(s, n)     memset ((s), 0, (n))
@@ -1978,7 +1981,7 @@ static void wmt_nand_enable_hwecc(struct mtd_info *mtd, int mode)
 #endif
 
 /*
- * wmt_nand_cmdfunc - Send command to NAND large page device
+ * __wmt_nand_cmdfunc - Send command to NAND large page device
  * @mtd:	MTD device structure
  * @command:	the command to be sent
  * @column:	the column address for this command, -1 if none
@@ -1988,7 +1991,7 @@ static void wmt_nand_enable_hwecc(struct mtd_info *mtd, int mode)
  * devices We dont have the separate regions as we have in the small page
  * devices.  We must emulate NAND_CMD_READOOB to keep the code compatible.
  */
-static void wmt_nand_cmdfunc(struct mtd_info *mtd, unsigned command, int column, int page_addr)
+static void __wmt_nand_cmdfunc(struct mtd_info *mtd, unsigned command, int column, int page_addr)
 {
 	struct wmt_nand_info *info = wmt_nand_mtd_toinfo(mtd);
 	struct nand_chip *chip = mtd->priv;
@@ -3027,6 +3030,15 @@ read_again:
 		spin_unlock(nand_lock);
 }
 
+static void wmt_nand_cmdfunc(struct mtd_info *mtd, unsigned command, int column, int page_addr)
+{
+	u32 ost;
+
+	ost = wmt_mmio_seq_begin("wmt_nand_cmdfunc");
+	__wmt_nand_cmdfunc(mtd, command, column, page_addr);
+	wmt_mmio_seq_end("wmt_nand_cmdfunc", ost);
+}
+
 
 static void wmt_nand_select_chip(struct mtd_info *mtd, int chipnr)
 {
@@ -3821,6 +3833,7 @@ static int wmt_nand_remove(struct platform_device *pdev)
 	/* free the common resources */
 
 	if (info->reg != NULL) {
+		wmt_mmio_set_virt(WMT_MMIO_NAND, NULL, 0, 0);
 		iounmap(info->reg);
 		info->reg = NULL;
 	}
@@ -4020,6 +4033,7 @@ static int wmt_nand_probe(struct platform_device *pdev)
 		err = -EIO;
 		goto exit_error;
 	}
+	wmt_mmio_set_virt(WMT_MMIO_NAND, info->reg, res->start, size);
 
 /*
  * * extend more partitions
@@ -18,6 +18,7 @@
 #include <linux/gpio.h>
 //#include <linux/wm97xx_batt.h>
 #include <linux/io.h>
+#include <linux/timer.h>
 #include <mach/hardware.h>
 #include <linux/wmt_battery.h>
 #include <mach/wmt_spi.h>
@@ -97,6 +98,38 @@ static int charing_first_update = 0;
 static int discharing_first_update = 0;
 
 int polling_interval= 5000;
+
+/*
+ * ADC filtering. A reading is the trimmed mean of BATT_ADC_SAMPLES
+ * conversions, the capacity is taken from a running estimate which
+ * moves 1/2^BATT_EST_SHIFT of the way to each new reading. The estimate
+ * restarts when the charger is plugged or unplugged, the cell voltage
+ * steps at that point.
+ */
+#define BATT_ADC_SAMPLES	8
+#define BATT_EST_SHIFT		2
+static unsigned int batt_adc_est;
+static int batt_adc_valid;
+
+/*
+ * Poll period multipliers of polling_interval. Discharging above
+ * BATT_LOW_CAPACITY and full on AC the capacity hardly moves.
+ */
+#define BATT_LOW_CAPACITY	15
+#define BATT_POLL_DISCHARGE	3
+#define BATT_POLL_FULL		6
+static int batt_suspended;
+
+/*
+ * DC-in and battery low on GPIO0..7 are watched by the shared GPIO
+ * interrupt, polling is the fallback for other pins.
+ */
+#define BATT_GPIO_INT_EDGE	0x04	/* both edges, same coding as PMWT */
+#define BATT_GPIO_INT_EN	BIT7
+static int dcin_irq_gpio = -1;
+static int batlow_irq_gpio = -1;
+static int batt_irq_requested;
+
 extern int wmt_getsyspara(char *varname, char *varval, int *varlen);
 extern unsigned short wmt_read_batstatus_if(void);
 
@@ -527,13 +560,44 @@ static unsigned short hx_batt_read(void)
 	return spi_buf;
 }
 
+/* Batch of conversions, min and max dropped, rest averaged */
+static unsigned short wmt_batt_adc_sample(void)
+{
+	unsigned short val, min = 0xFFFF, max = 0;
+	unsigned int sum = 0;
+	int i;
+
+	for (i = 0; i < BATT_ADC_SAMPLES; i++) {
+		val = hx_batt_read();
+		sum += val;
+		if (val < min)
+			min = val;
+		if (val > max)
+			max = val;
+	}
+	return (sum - min - max) / (BATT_ADC_SAMPLES - 2);
+}
+
+static unsigned short wmt_batt_adc_filtered(void)
+{
+	unsigned short val = wmt_batt_adc_sample();
+
+	if (!batt_adc_valid) {
+		batt_adc_est = val << BATT_EST_SHIFT;
+		batt_adc_valid = 1;
+	} else
+		batt_adc_est = batt_adc_est + val - (batt_adc_est >> BATT_EST_SHIFT);
+
+	return batt_adc_est >> BATT_EST_SHIFT;
+}
+
 static unsigned long wmt_read_capacity(struct power_supply *bat_ps)
 {
 	unsigned int capacity=0;
 	unsigned short ADC_val = 0;
 	
 	/*printk("Bow: read capacity...\n");*/
-	ADC_val = hx_batt_read();
+	ADC_val = wmt_batt_adc_filtered();
 	/*printk("ADC value = 0x%x  \n",ADC_val);*/
 	if(bat_status== POWER_SUPPLY_STATUS_DISCHARGING){
         if(ADC_val > batt_discharge_max){
@@ -577,7 +641,12 @@ static unsigned long wmt_read_capacity(struct power_supply *bat_ps)
          */
 		/*printk("DISCHARGING Capacity = %d \n",capacity);*/
 	}else{
-		capacity = (ADC_val - batt_charge_min) * 100 / (batt_charge_max - batt_charge_min);
+		if (ADC_val <= batt_charge_min)
+			capacity = 0;
+		else if (ADC_val >= batt_charge_max)
+			capacity = 100;
+		else
+			capacity = (ADC_val - batt_charge_min) * 100 / (batt_charge_max - batt_charge_min);
 		/*printk("CHARGING Capacity = %d \n",capacity);*/
 	}
 	
@@ -669,6 +738,20 @@ static void wmt_bat_external_power_changed(struct power_supply *bat_ps)
 	schedule_work(&bat_work);
 }
 
+/* Next poll in ms, depending on what the battery is doing */
+static int wmt_batt_poll_interval(void)
+{
+	/* nothing tells us about a plugged charger without polling */
+	if (batt_operation && (dcin_irq_gpio < 0))
+		return polling_interval;
+
+	if (!batt_operation || (bat_status == POWER_SUPPLY_STATUS_FULL))
+		return polling_interval * BATT_POLL_FULL;
+	if (bat_dcin || (bat_capacity <= BATT_LOW_CAPACITY))
+		return polling_interval;
+	return polling_interval * BATT_POLL_DISCHARGE;
+}
+
 static void wmt_bat_update(struct power_supply *bat_ps)
 {
 	unsigned int current_percent = 0;
@@ -681,6 +764,8 @@ static void wmt_bat_update(struct power_supply *bat_ps)
 		bat_low = wmt_read_batlow_DT(bat_ps);
 	    bat_dcin= wmt_read_dcin_DT(bat_ps);
 		bat_status = wmt_read_status(bat_ps);
+		if ((bat_dcin != bat_dcin_old) || (bat_status != bat_status_old))
+			batt_adc_valid = 0;
 		/*printk("\Bow: bat_low = %d \n",bat_low);*/
 		/*printk("\Bow: bat_dcin = %d \n",bat_dcin);*/
 
@@ -798,13 +883,12 @@ static void wmt_bat_update(struct power_supply *bat_ps)
     printk("Bow: bat_temp_capacity = %d \n",bat_temp_capacity);
     printk("Bow: capacity %d \n",bat_capacity);
     */
-    if((bat_low) ||
+    if((bat_low != bat_low_old) ||
        (bat_dcin != bat_dcin_old) ||
        (bat_health != bat_health_old) ||
        (bat_online != bat_online_old) ||
        (bat_status != bat_status_old) ||
-       (bat_capacity != bat_capacity_old) ||
-       (bat_capacity <= 0)){
+       (bat_capacity != bat_capacity_old)){
 		power_supply_changed(bat_ps);
     }
 	/*
@@ -824,6 +908,9 @@ static void wmt_bat_update(struct power_supply *bat_ps)
     bat_online_old= bat_online;
     bat_status_old=bat_status;
     bat_capacity_old=bat_capacity;
+	if (!batt_suspended)
+		mod_timer(&polling_timer, jiffies + round_jiffies_relative(
+			msecs_to_jiffies(capacity_first_update ? polling_interval : wmt_batt_poll_interval())));
 	mutex_unlock(&work_lock);
 	/*printk("Bow: update ^^^\n");*/
 }
@@ -862,14 +949,96 @@ static void wmt_battery_work(struct work_struct *work)
 }
 
 
+/*
+ * GPIO0..3 are set up in GPIO_INT_REQ_TYPE_0 and GPIO4..7 in
+ * GPIO_INT_REQ_TYPE_1, one byte per pin. The status bit is the
+ * byte offset of that pin from GPIO_INT_REQ_TYPE_0.
+ */
+static int wmt_batt_gpio_to_int(struct wmt_batgpio_set *gpio)
+{
+	int n;
+
+	if ((gpio->idaddr != GPIO_ID_GP0_BYTE_ADDR) || !(gpio->bitmap & 0xFF))
+		return -1;
+	n = ffs(gpio->bitmap) - 1;
+	if (gpio->bitmap & ~(1 << n))
+		return -1;
+	return n;
+}
+
+static unsigned int wmt_batt_gpio_int_addr(int n)
+{
+	return (n < 4) ? (GPIO_INT_REQ_TYPE_0_ADDR + n) : (GPIO_INT_REQ_TYPE_1_ADDR + n - 4);
+}
+
+static unsigned int wmt_batt_gpio_int_bit(int n)
+{
+	return 1 << (wmt_batt_gpio_int_addr(n) - GPIO_INT_REQ_TYPE_0_ADDR);
+}
+
+static void wmt_batt_gpio_int_enable(int n, int enable)
+{
+	if (n < 0)
+		return;
+	if (enable) {
+		REG8_VAL(wmt_batt_gpio_int_addr(n)) = BATT_GPIO_INT_EDGE;
+		GPIO_INT_REQ_STS_VAL = wmt_batt_gpio_int_bit(n);
+		REG8_VAL(wmt_batt_gpio_int_addr(n)) |= BATT_GPIO_INT_EN;
+	} else
+		REG8_VAL(wmt_batt_gpio_int_addr(n)) &= ~BATT_GPIO_INT_EN;
+}
+
+static irqreturn_t wmt_batt_gpio_isr(int irq, void *dev_id)
+{
+	unsigned int mask = 0, status;
+
+	if (dcin_irq_gpio >= 0)
+		mask |= wmt_batt_gpio_int_bit(dcin_irq_gpio);
+	if (batlow_irq_gpio >= 0)
+		mask |= wmt_batt_gpio_int_bit(batlow_irq_gpio);
+
+	status = GPIO_INT_REQ_STS_VAL & mask;
+	if (!status)
+		return IRQ_NONE;
+	GPIO_INT_REQ_STS_VAL = status;
+
+	/* GPIO levels are read again in the work */
+	if ((dcin_irq_gpio >= 0) && (status & wmt_batt_gpio_int_bit(dcin_irq_gpio)))
+		schedule_work(&ac_work);
+	schedule_work(&bat_work);
+
+	return IRQ_HANDLED;
+}
+
+/* Called after gpio_ini(), falls back to polling when a pin has no interrupt */
+static void wmt_batt_irq_init(struct device *dev)
+{
+	dcin_irq_gpio = wmt_batt_gpio_to_int(&dcin);
+	batlow_irq_gpio = wmt_batt_gpio_to_int(&batlow);
+	if ((dcin_irq_gpio < 0) && (batlow_irq_gpio < 0))
+		return;
+
+	if (!batt_irq_requested) {
+		if (request_irq(IRQ_GPIO, wmt_batt_gpio_isr, IRQF_SHARED, "wmt-battery", &bat_ps)) {
+			dev_err(dev, "Can't allocate irq %d, polling DC-in\n", IRQ_GPIO);
+			dcin_irq_gpio = -1;
+			batlow_irq_gpio = -1;
+			return;
+		}
+		batt_irq_requested = 1;
+	}
+	wmt_batt_gpio_int_enable(dcin_irq_gpio, 1);
+	wmt_batt_gpio_int_enable(batlow_irq_gpio, 1);
+}
+
 static void polling_timer_func(unsigned long unused)
 {
 	/*printk("Bow: polling...\n");*/
+	/* wmt_bat_update() sets up the next poll */
 	schedule_work(&bat_work);
-	schedule_work(&ac_work);
-	mod_timer(&polling_timer,
-		  jiffies + msecs_to_jiffies(polling_interval));
-		 
+	if (dcin_irq_gpio < 0)
+		schedule_work(&ac_work);
+
 	/*printk("Bow: polling ^^^\n");*/
 }
 
@@ -877,7 +1046,12 @@ static void polling_timer_func(unsigned long unused)
 static int wmt_battery_suspend(struct platform_device *dev, pm_message_t state)
 {
 	/*flush_scheduled_work();*/
-	del_timer(&polling_timer);
+	batt_suspended = 1;
+	del_timer_sync(&polling_timer);
+	cancel_work_sync(&bat_work);
+	del_timer_sync(&polling_timer);
+	wmt_batt_gpio_int_enable(dcin_irq_gpio, 0);
+	wmt_batt_gpio_int_enable(batlow_irq_gpio, 0);
 	
 	 if(ADC_USED && spi_mode)	
 		unregister_user(spi_user_rec_b, SPI_USER_ID);
@@ -891,6 +1065,7 @@ static int wmt_battery_resume(struct platform_device *dev)
 	
 	if(batt_operation){
 		gpio_ini();
+		wmt_batt_irq_init(&dev->dev);
         if(ADC_USED&& spi_mode){
 			/* Register a SPI channel.*/
 			spi_user_rec_b = register_user(SPI_USER_NAME, SPI_USER_ID);
@@ -904,9 +1079,13 @@ static int wmt_battery_resume(struct platform_device *dev)
 	}
 	/*schedule_work(&bat_work);*/
 	/*schedule_work(&ac_work);*/
+	batt_suspended = 0;
+	batt_adc_valid = 0;
 	setup_timer(&polling_timer, polling_timer_func, 0);
 	mod_timer(&polling_timer,
 		  jiffies + msecs_to_jiffies(polling_interval));
+	/* the charger may have come or gone while we slept */
+	schedule_work(&ac_work);
     first_update = 0;
     charing_first_update = 0;
     discharing_first_update = 0;
@@ -949,7 +1128,7 @@ static void wmt_ac_update(struct power_supply *ac_ps)
 	if(batt_operation){
 		ac_dcin= wmt_read_dcin_DT(ac_ps);
 
-		if((bat_low) || (ac_dcin != ac_dcin_old)){
+		if(ac_dcin != ac_dcin_old){
 			power_supply_changed(ac_ps);
 
 		}
@@ -1010,6 +1189,8 @@ static int __devinit wmt_battery_probe(struct platform_device *dev)
 
 	INIT_WORK(&bat_work, wmt_battery_work);
 	INIT_WORK(&ac_work, wmt_ac_work);
+	/* the battery work arms the poll timer */
+	setup_timer(&polling_timer, polling_timer_func, 0);
 	if (!pdata->batt_name) {
 		dev_info(&dev->dev, "Please consider setting proper battery "
 				"name in platform definition file, falling "
@@ -1034,7 +1215,6 @@ static int __devinit wmt_battery_probe(struct platform_device *dev)
 	else
 		goto err;
 
-	setup_timer(&polling_timer, polling_timer_func, 0);
 	mod_timer(&polling_timer,
 			  jiffies + msecs_to_jiffies(polling_interval));
 
@@ -1044,6 +1224,7 @@ static int __devinit wmt_battery_probe(struct platform_device *dev)
 	
 	if(batt_operation){
 		gpio_ini();
+		wmt_batt_irq_init(&dev->dev);
         if(ADC_USED){
 			spi_ini();
 			if(spi_mode){
@@ -1067,6 +1248,14 @@ err:
 static int __devexit wmt_battery_remove(struct platform_device *dev)
 {
 
+	batt_suspended = 1;
+	if (batt_irq_requested) {
+		wmt_batt_gpio_int_enable(dcin_irq_gpio, 0);
+		wmt_batt_gpio_int_enable(batlow_irq_gpio, 0);
+		free_irq(IRQ_GPIO, &bat_ps);
+		batt_irq_requested = 0;
+	}
+	del_timer_sync(&polling_timer);
 	flush_scheduled_work();
 	del_timer_sync(&polling_timer);
 	
@@ -38,6 +38,8 @@
 #include <linux/serial_core.h>
 
 #include <linux/dma-mapping.h>
+#include <linux/hrtimer.h>
+#include <linux/proc_fs.h>
 //#include <mach/dma.h>
 
 #define PORT_WMT 54
@@ -135,13 +137,55 @@ unsigned int uart_debug = 0;
 		#define CALLOUT_WMT_MAJOR    5       /* for callout device */
 #endif
 
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+#define NR_PORTS             2       /* UART0, UART1 with DMA*/
+#else
 #define NR_PORTS             1       /* UART0*/
+#endif
 #define WMT_ISR_PASS_LIMIT   256
 
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+/*
+ * RX DMA statistics, shown in /proc/wmt-uart.
+ * Flush latency is the time between two flushes which found data,
+ * the longest a byte could have been waiting in the ring.
+ */
+struct wmt_dma_stats {
+	unsigned int rx_bytes;
+	unsigned int rx_flushes;
+	unsigned int rx_overrun;	/* bytes overwritten in the ring */
+	unsigned int rx_tty_drop;	/* bytes the tty layer had no room for */
+	unsigned int flush_lat_last;	/* us */
+	unsigned int flush_lat_max;
+	unsigned int tx_bytes;
+	unsigned int tx_dma;		/* TX DMA transfers */
+};
+#endif
+
 struct wmt_port {
 	struct uart_port	port;
 	struct timer_list	timer;
 	unsigned int		old_status;
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+	int			use_dma;
+	/*
+	 * RX ring, two UART_BUFFER_SIZE halves which are queued to the DMA
+	 * channel back to back, a finished half is queued again at once.
+	 * All counters below are free running byte counts.
+	 */
+	char			*rx_ring;
+	dma_addr_t		rx_ring_phy;
+	unsigned int		rx_dma_done;	/* bytes in finished halves */
+	unsigned int		rx_dma_off;	/* bytes in the half being filled */
+	unsigned int		rx_read;	/* bytes passed to the tty */
+	struct hrtimer		rx_timer;
+	ktime_t			rx_flush_period;
+	unsigned int		rx_flush_time;	/* OSCR of the last flush with data */
+	/* TX runs straight from the circ_buf page */
+	dma_addr_t		tx_buf_phy;
+	unsigned int		tx_count;	/* bytes in flight, 0 when idle */
+	struct wmt_dma_stats	stats;
+#endif
 };
 
 
@@ -195,6 +239,10 @@ static struct baud_info_s baud_table[] =
 
 #ifdef CONFIG_SERIAL_WMT_DUAL_DMA
 #define UART_BUFFER_SIZE        4096
+#define UART_RX_RING_SIZE       (2 * UART_BUFFER_SIZE)
+/* RX flush period while data is coming in, the time of this many chars */
+#define UART_RX_FLUSH_CHARS     64
+#define UART_RX_FLUSH_MIN_NS    1000000
 #endif
 /*
  * Macros to put URISR and URUSR into a 32-bit status variable
@@ -468,7 +516,7 @@ static void wmt_stop_tx(struct uart_port *port)
 	uart->urier &= ~(URIER_ETXFAE | URIER_ETXFE);
 	sport->port.read_status_mask &= ~URISR_TO_SM(URISR_TXFAE | URISR_TXFE);
 	#else
-	if ((unsigned int)(sport->port.membase) == UART1_BASE_ADDR) {
+	if (!sport->use_dma) {
 		uart->urier &= ~(URIER_ETXFAE | URIER_ETXFE);
 		sport->port.read_status_mask &= ~URISR_TO_SM(URISR_TXFAE | URISR_TXFE);
 	}
@@ -489,22 +537,17 @@ static void wmt_start_tx(struct uart_port *port)
 	 *                for the FIFO mode should be modified as well.
 	 */
 	#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
-	if ((unsigned int)(sport->port.membase)!= UART1_BASE_ADDR) {
-    	uart->urlcr |= URLCR_DMAEN;
-		uart->urier &= ~(URIER_ETXFAE | URIER_ETXFE);
-	}
-	else
-		uart->urier &= ~(URIER_ETXFAE | URIER_ETXFE);	
-    #else 
-	uart->urier &= ~(URIER_ETXFAE | URIER_ETXFE);
+	if (sport->use_dma)
+		uart->urlcr |= URLCR_DMAEN;
 	#endif
+	uart->urier &= ~(URIER_ETXFAE | URIER_ETXFE);
 	wmt_tx_chars(sport);
 	/*}2007/11/10-JHT*/
 	#ifndef CONFIG_SERIAL_WMT_DUAL_DMA
 	sport->port.read_status_mask |= URISR_TO_SM(URISR_TXFAE | URISR_TXFE);
 	uart->urier |= URIER_ETXFAE | URIER_ETXFE;
-	#else 
-	if ((unsigned int)(sport->port.membase) == UART1_BASE_ADDR) {
+	#else
+	if (!sport->use_dma) {
 		sport->port.read_status_mask |= URISR_TO_SM(URISR_TXFAE | URISR_TXFE);
 		uart->urier |= URIER_ETXFAE | URIER_ETXFE;
 	}
@@ -535,56 +578,121 @@ static void wmt_enable_ms(struct uart_port *port)
 }
 
 #ifdef CONFIG_SERIAL_WMT_DUAL_DMA
-static unsigned int wmt_rx_count(struct uart_port *port)
+/*
+ * Bytes written by the RX DMA so far. The position register is only
+ * trusted inside the half being filled, it reads out of range around a
+ * half switch and then the finished half is accounted by the callback.
+ */
+static unsigned int wmt_rx_dma_produced(struct wmt_port *sport)
 {
-    unsigned int rx_count = 0;
-	unsigned int pos;
+	struct uart_port *uartport = &sport->port;
+	unsigned int base, pos;
+
+	base = sport->rx_ring_phy + (sport->rx_dma_done & (UART_RX_RING_SIZE - 1));
+	pos = DMA_RX_POS(uartport);
+	if (pos > base && pos < base + UART_BUFFER_SIZE && pos - base > sport->rx_dma_off)
+		sport->rx_dma_off = pos - base;
+
+	return sport->rx_dma_done + sport->rx_dma_off;
+}
+
+/*
+ * Pass everything the RX DMA has written since the last flush to the
+ * tty layer. Called with the port lock held.
+ * Returns the number of bytes flushed.
+ */
+static unsigned int wmt_rx_dma_flush(struct wmt_port *sport)
+{
+	struct tty_struct *tty = sport->port.state->port.tty;
+	unsigned int produced, count, off, chunk, done, now;
+
+	produced = wmt_rx_dma_produced(sport);
+	count = produced - sport->rx_read;
+	if (count == 0)
+		return 0;
 
-	pos = DMA_RX_POS(port);
-	if (pos == port->last_pos) {
-		rx_count = 0;
-		return rx_count;
+	if (count > UART_RX_RING_SIZE) {
+		/*
+		 * The DMA has lapped us, what is left of the lost bytes is
+		 * mixed with new ones. Drop everything up to the producer.
+		 */
+		sport->stats.rx_overrun += count;
+		sport->port.icount.overrun++;
+		sport->rx_read = produced;
+		return 0;
 	}
-	else
-		port->last_pos = pos;
 
+	now = wmt_read_oscr();
+	if (sport->stats.rx_flushes) {
+		sport->stats.flush_lat_last = (now - sport->rx_flush_time) / (CLOCK_TICK_RATE / 1000000);
+		if (sport->stats.flush_lat_last > sport->stats.flush_lat_max)
+			sport->stats.flush_lat_max = sport->stats.flush_lat_last;
+	}
+	sport->rx_flush_time = now;
+	sport->stats.rx_flushes++;
+
+	done = 0;
+	while (done < count) {
+		off = (sport->rx_read + done) & (UART_RX_RING_SIZE - 1);
+		chunk = min(count - done, UART_RX_RING_SIZE - off);
+		chunk = tty_insert_flip_string(tty, sport->rx_ring + off, chunk);
+		if (chunk == 0)
+			break;
+		done += chunk;
+	}
+	if (done < count)
+		sport->stats.rx_tty_drop += count - done;
 
-	if(((port->uart_dma_tmp_phy1 == port->uart_rx_dma_phy1) ||(port->uart_dma_tmp_phy1 == port->uart_rx_dma_phy1 + UART_BUFFER_SIZE))
-        && (port->uart_dma_tmp_phy0 < port->uart_rx_dma_phy0 + UART_BUFFER_SIZE )) {
+	sport->rx_read = produced;
+	sport->port.icount.rx += done;
+	sport->stats.rx_bytes += done;
+	tty_flip_buffer_push(tty);
 
-		port->buffer_selected = 0;
-        port->uart_dma_tmp_phy1 = port->uart_rx_dma_phy1;
-		
-		if ((pos >= port->uart_rx_dma_phy0) && (pos < (port->uart_rx_dma_phy0 + UART_BUFFER_SIZE)))
-			rx_count =  pos - (unsigned int)port->uart_dma_tmp_phy0;
-		else if (pos == 0) {
-			if (port->uart_dma_tmp_phy0 == port->uart_rx_dma_phy0)
-				rx_count = 0;
-			else
-				rx_count = (port->uart_rx_dma_phy0 + UART_BUFFER_SIZE) - (unsigned int)port->uart_dma_tmp_phy0 ;
-		}else
-			rx_count = (port->uart_rx_dma_phy0 + UART_BUFFER_SIZE) - (unsigned int)port->uart_dma_tmp_phy0 ;
+	return count;
+}
 
-		port->uart_dma_tmp_phy0  += rx_count;
-		
-    } else {
-        port->buffer_selected = 1;
-        port->uart_dma_tmp_phy0 = port->uart_rx_dma_phy0;
-
-		if ((pos >= port->uart_rx_dma_phy1) && (pos < (port->uart_rx_dma_phy1 + UART_BUFFER_SIZE)))
-			rx_count =  pos - (unsigned int)port->uart_dma_tmp_phy1;
-		else if (pos == 0) {
-			if (port->uart_dma_tmp_phy1 == port->uart_rx_dma_phy1)
-				rx_count = 0;
-			else
-				rx_count = (port->uart_rx_dma_phy1 + UART_BUFFER_SIZE) - (unsigned int)port->uart_dma_tmp_phy1 ;
-		}else
-			rx_count = (port->uart_rx_dma_phy1 + UART_BUFFER_SIZE) - (unsigned int)port->uart_dma_tmp_phy1 ;
-		
-		port->uart_dma_tmp_phy1  += rx_count;
-		
-    }
-    return rx_count; 
+/*
+ * Keep flushing at rx_flush_period while data comes in, the timer stops
+ * itself after a period without data. RX time-out, RX errors and the
+ * DMA half interrupt start it again.
+ */
+static enum hrtimer_restart wmt_rx_dma_timer(struct hrtimer *timer)
+{
+	struct wmt_port *sport = container_of(timer, struct wmt_port, rx_timer);
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sport->port.lock, flags);
+	if (sport->port.state && sport->rx_ring && wmt_rx_dma_flush(sport)) {
+		hrtimer_forward_now(timer, sport->rx_flush_period);
+		ret = HRTIMER_RESTART;
+	}
+	spin_unlock_irqrestore(&sport->port.lock, flags);
+
+	return ret;
+}
+
+static inline void wmt_rx_dma_kick(struct wmt_port *sport)
+{
+	if (!hrtimer_active(&sport->rx_timer))
+		hrtimer_start(&sport->rx_timer, sport->rx_flush_period, HRTIMER_MODE_REL);
+}
+
+/*
+ * RX events of a DMA port. Characters are in the ring already, the
+ * interrupt status only tells about errors and the line going idle.
+ */
+static void wmt_rx_dma_irq(struct wmt_port *sport, unsigned int status)
+{
+	if (status & URISR_TO_SM(URISR_PER))
+		sport->port.icount.parity++;
+	if (status & URISR_TO_SM(URISR_FER))
+		sport->port.icount.frame++;
+	if (status & URISR_TO_SM(URISR_RXDOVR))
+		sport->port.icount.overrun++;
+
+	wmt_rx_dma_flush(sport);
+	wmt_rx_dma_kick(sport);
 }
 #endif
 /*
@@ -596,7 +704,6 @@ static unsigned int wmt_rx_count(struct uart_port *port)
  * URISR_RXTOUT: RX timeout
  */
 
-#ifndef CONFIG_SERIAL_WMT_DUAL_DMA
 static void
 wmt_rx_chars(struct wmt_port *sport,  unsigned int status)
 {
@@ -760,355 +867,47 @@ handle_error:
 	#endif
 	goto error_return;
 }
-#else
-
-static void
-wmt_rx_chars(struct wmt_port *sport, unsigned int status)
+/*
+ * Inside the UART interrupt service routine dut to following
+ * reason:
+ *
+ * URISR_TXFAE: TX FIFO almost empty (FIFO mode)
+ * URISR_TXFE:  TX FIFO empty(FIFO mode)
+ */
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+/*
+ * Send the contiguous part of the circ_buf behind tail by DMA, tail
+ * moves on when the transfer is done. Called with the port lock held.
+ */
+static void wmt_tx_dma(struct wmt_port *sport)
 {
-	struct tty_struct *tty = sport->port.info->port.tty;
-	struct wmt_uart *uart = (struct wmt_uart *)PORT_TO_BASE(sport);
-    unsigned int receive_rx_count = 0;
-
-	
-	unsigned int  flg, urfidx, ignored = 0;
-	int ch;
-	
-	urfidx = URFIDX_RXFIDX(uart->urfidx);
-
-	/*
-	 * Check if there is data ready to be read.
-	 *
-	 * Note: We only receive characters.
-	 */
-	
-if ((unsigned int)(sport->port.membase) != UART1_BASE_ADDR) {
-
-	receive_rx_count = wmt_rx_count(&sport->port);
-		
-	while (receive_rx_count > 0) {
-    	if(!sport->port.buffer_selected) {
-			
-			ch = (int)*(sport->port.uart_dma_tmp_buf0);
-            sport->port.uart_dma_tmp_buf0++;
-			receive_rx_count--;
-
-			if(sport->port.uart_dma_tmp_buf0 == (sport->port.uart_rx_dma_buf0_org +UART_BUFFER_SIZE))
-				sport->port.uart_dma_tmp_buf0 = sport->port.uart_rx_dma_buf0_org;
-        } else {
-        
-			ch = (int)*(sport->port.uart_dma_tmp_buf1);
-			sport->port.uart_dma_tmp_buf1++;
-			receive_rx_count--;
-			
-			 if(sport->port.uart_dma_tmp_buf1 == (sport->port.uart_rx_dma_buf1_org +UART_BUFFER_SIZE))
-				sport->port.uart_dma_tmp_buf1 = sport->port.uart_rx_dma_buf1_org;
-		}
-
-        if (receive_rx_count == 0)
-			receive_rx_count = wmt_rx_count(&sport->port);
-		
-            sport->port.icount.rx++;
-
-            flg = TTY_NORMAL;
-            /*
-             * Check interrupt status information using status[URISR_bits].
-             *
-             * Notice that the error handling code is out of
-             * the main execution path and the URISR has already
-             * been read by ISR.
-             */
-			if ( status & URISR_TO_SM(URISR_PER | URISR_FER | URISR_RXDOVR) ) {
-				if ( receive_rx_count > 1 ) {
-					if ( uart_handle_sysrq_char(&sport->port, ch) )
-    					goto ignore_char;
-						/*
-						 * Pop all TTY_NORMAL data.
-						 */
-					goto error_return;
-				} else {
-					/*
-					 * Now we have poped up to the data with
-					 * parity error or frame error.
-					 */
-					goto handle_error;
-				}
-			}	
-	if (uart_handle_sysrq_char(&sport->port, ch))
-		goto ignore_char;
-error_return:
-
-	uart_insert_char(&sport->port, (status & 0xFFFF), URISR_TO_SM(URISR_RXDOVR) , ch, flg);
-	
-ignore_char:
-		status &= 0xffff;       /* Keep URISR field*/
-		status |= URUSR_TO_SM(uart->urusr);
-	}
-out:
-
-	tty_flip_buffer_push(tty);
-	return;
-
-handle_error:
-
-	/*
-	 * Update error counters.
-	 */
-	if (status & URISR_TO_SM(URISR_PER))
-		sport->port.icount.parity++;
-	else
-		if (status & URISR_TO_SM(URISR_FER)) {
-
-	#ifdef CONFIG_SERIAL_WMT_BKSIG
-			/*
-			 * Experimental software patch for break signal detection.
-			 *
-			 * When I got there is a frame error in next frame data,
-			 * I check the next data to judge if it is a break signal.
-			 *
-			 * FIXME: Open these if Bluetooth or IrDA need this patch.
-			 *        Dec.29.2004 by Harry.
-			 */
-			if ((ch & RX_PERMASK) == 0) {
-				sport->port.icount.brk++;
-				uart_handle_break(&sport->port);
-			} else
-				sport->port.icount.frame++;
-
-	#else   /* Don't support break sinal detection */
-
-			sport->port.icount.frame++;
-
-	#endif
-
-		}
-
-	/*
-	 * RX Over Run event
-	 */
-	if (status & URISR_TO_SM(URISR_RXDOVR))
-		sport->port.icount.overrun++;
-
-	if (status & sport->port.ignore_status_mask) {
-		if (++ignored > 100)
-			goto out;
-		goto ignore_char;
-	}
-
-	/*
-	 * Second, handle the events which we're interesting to listen.
-	 */
-	status &= sport->port.read_status_mask;
-
-	if (status & URISR_TO_SM(URISR_PER))
-		flg = TTY_PARITY;
-	else
-		if (status & URISR_TO_SM(URISR_FER)) {
-
-	#ifdef CONFIG_SERIAL_WMT_BKSIG
-			/* Software patch for break signal detection.
-			 *
-			 * When I got there is a frame error in next frame data,
-			 * I check the next data to judge if it is a break signal.
-			 *
-			 * FIXME: Open these if Bluetooth or IrDA need this patch.
-			 *        Dec.29.2004 by Harry.
-			 */
-			if (sport->port.read_status_mask & SW_BKSIG) {
-				if ((ch & RX_PERMASK) == 0) {
-					DEBUG_INTR("handling break....");
-					flg = TTY_BREAK;
-					/*goto error_return;*/
-				} else {
-					flg = TTY_FRAME;
-					/*goto error_return;*/
-				}
-			} else {
-				flg = TTY_FRAME;
-				/*goto error_return;*/
-			}
-
-	#else   /* Don't support break sinal detection */
-
-			flg = TTY_FRAME;
-
-	#endif
-		}
-
-	if (status & URISR_TO_SM(URISR_RXDOVR)) {
-		/*
-		 * Overrun is special, since it's reported
-		 * immediately, and doesn't affect the current
-		 * character.
-		 */
-
-		ch = 0;
-		flg	= TTY_OVERRUN;
-	}
-	#ifdef SUPPORT_SYSRQ
-	sport->port.sysrq = 0;
-	#endif
-	goto error_return;
-}
-else {
-	while ((status & URUSR_TO_SM(URUSR_RXDRDY)) && (URFIDX_RXFIDX(uart->urfidx))) {
-		ch = (unsigned int)(uart->urrxf[0] & 0x3FF);
-		
-		/*urfidx--;*/
-
-		sport->port.icount.rx++;
-
-		flg = TTY_NORMAL;
-
-		/*
-		 * Check interrupt status information using status[URISR_bits].
-		 *
-		 * Notice that the error handling code is out of
-		 * the main execution path and the URISR has already
-		 * been read by ISR.
-		 */
-		if (status & URISR_TO_SM(URISR_PER | URISR_FER | URISR_RXDOVR)) {
-			if (urfidx > 1) {
-				if (uart_handle_sysrq_char(&sport->port, ch))
-					goto ignore_char2;
-				/*
-				 * Pop all TTY_NORMAL data.
-				 */
-				goto error_return2;
-			} else {
-				/*
-				 * Now we have poped up to the data with
-				 * parity error or frame error.
-				 */
-				goto handle_error2;
-			}
-		}
- 
-		if (uart_handle_sysrq_char(&sport->port, ch))
-			goto ignore_char2;
-
-error_return2:
-
-			uart_insert_char(&sport->port, (status & 0xFFFF), URISR_TO_SM(URISR_RXDOVR) , ch, flg);
-
-ignore_char2:
-			status &= 0xffff;       /* Keep URISR field*/
-			status |= URUSR_TO_SM(uart->urusr);
-	}
-out2:
-	tty_flip_buffer_push(tty);
-	return;
-
-handle_error2:
-	/*
-	 * Update error counters.
-	 */
-	if (status & URISR_TO_SM(URISR_PER))
-		sport->port.icount.parity++;
-	else
-		if (status & URISR_TO_SM(URISR_FER)) {
-
-	#ifdef CONFIG_SERIAL_WMT_BKSIG
-			/*
-			 * Experimental software patch for break signal detection.
-			 *
-			 * When I got there is a frame error in next frame data,
-			 * I check the next data to judge if it is a break signal.
-			 *
-			 * FIXME: Open these if Bluetooth or IrDA need this patch.
-			 *        Dec.29.2004 by Harry.
-			 */
-			if ((ch & RX_PERMASK) == 0) {
-				sport->port.icount.brk++;
-				uart_handle_break(&sport->port);
-			} else
-				sport->port.icount.frame++;
-
-	#else   /* Don't support break sinal detection */
-
-			sport->port.icount.frame++;
-
-	#endif
-
-		}
+	struct uart_port *uartport = &sport->port;
+	struct circ_buf *xmit = &sport->port.state->xmit;
+	unsigned int count;
 
-	/*
-	 * RX Over Run event
-	 */
-	if (status & URISR_TO_SM(URISR_RXDOVR))
-		sport->port.icount.overrun++;
+	if (sport->tx_count)
+		return;
 
-	if (status & sport->port.ignore_status_mask) {
-		if (++ignored > 100)
-			goto out2;
-		goto ignore_char2;
+	if (uart_circ_empty(xmit) || uart_tx_stopped(&sport->port)) {
+		if (uart_circ_chars_pending(xmit) < WAKEUP_CHARS)
+			uart_write_wakeup(&sport->port);
+		return;
 	}
 
-	/*
-	 * Second, handle the events which we're interesting to listen.
-	 */
-	status &= sport->port.read_status_mask;
-
-	if (status & URISR_TO_SM(URISR_PER))
-		flg = TTY_PARITY;
-	else
-		if (status & URISR_TO_SM(URISR_FER)) {
-
-	#ifdef CONFIG_SERIAL_WMT_BKSIG
-			/* Software patch for break signal detection.
-			 *
-			 * When I got there is a frame error in next frame data,
-			 * I check the next data to judge if it is a break signal.
-			 *
-			 * FIXME: Open these if Bluetooth or IrDA need this patch.
-			 *        Dec.29.2004 by Harry.
-			 */
-			if (sport->port.read_status_mask & SW_BKSIG) {
-				if ((ch & RX_PERMASK) == 0) {
-					DEBUG_INTR("handling break....");
-					flg = TTY_BREAK;
-					/*goto error_return;*/
-				} else {
-					flg = TTY_FRAME;
-					/*goto error_return;*/
-				}
-			} else {
-				flg = TTY_FRAME;
-				/*goto error_return;*/
-			}
-
-	#else   /* Don't support break sinal detection */
-
-			flg = TTY_FRAME;
-
-	#endif
-		}
-
-	if (status & URISR_TO_SM(URISR_RXDOVR)) {
-		/*
-		 * Overrun is special, since it's reported
-		 * immediately, and doesn't affect the current
-		 * character.
-		 */
-
-		ch = 0;
-		flg	= TTY_OVERRUN;
+	count = CIRC_CNT_TO_END(xmit->head, xmit->tail, UART_XMIT_SIZE);
+	dma_sync_single_for_device(sport->port.dev, sport->tx_buf_phy + xmit->tail,
+		count, DMA_TO_DEVICE);
+	sport->tx_count = count;
+	sport->port.uart_tx_dma_phy0_end = DMA_TX_GOING;
+	if (DMA_TX_START(uartport, sport->tx_buf_phy + xmit->tail, count)) {
+		sport->tx_count = 0;
+		sport->port.uart_tx_dma_phy0_end = DMA_TX_END;
+		return;
 	}
-	#ifdef SUPPORT_SYSRQ
-	sport->port.sysrq = 0;
-	#endif
-	goto error_return2;
- }
-
+	sport->stats.tx_dma++;
 }
 #endif
-/*
- * Inside the UART interrupt service routine dut to following
- * reason:
- *
- * URISR_TXFAE: TX FIFO almost empty (FIFO mode)
- * URISR_TXFE:  TX FIFO empty(FIFO mode)
- */
-#ifndef CONFIG_SERIAL_WMT_DUAL_DMA
+
 static void wmt_tx_chars(struct wmt_port *sport)
 {
 	struct circ_buf *xmit = &sport->port.state->xmit;
@@ -1127,6 +926,12 @@ static void wmt_tx_chars(struct wmt_port *sport)
 	/*Check the modem control lines before transmitting anything.*/
 	wmt_mctrl_check(sport);
 
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+	if (sport->use_dma) {
+		wmt_tx_dma(sport);
+		return;
+	}
+#endif
 	if (uart_circ_empty(xmit) || uart_tx_stopped(&sport->port)) {
 		wmt_stop_tx(&sport->port);
 		return;
@@ -1156,83 +961,6 @@ static void wmt_tx_chars(struct wmt_port *sport)
 	if (uart_circ_empty(xmit))
 		wmt_stop_tx(&sport->port);
 }
-#else
-static void wmt_tx_chars(struct wmt_port *sport)
-{
-	struct circ_buf *xmit = &sport->port.info->xmit;
-	struct wmt_uart *uart = (struct wmt_uart *)PORT_TO_BASE(sport);
-    struct uart_port	*uartport = &sport->port;
-    char *dma_buf = sport->port.uart_tx_dma_buf0;
-    unsigned int tx_count;
-	
-	if (sport->port.x_char) {
-		/*
-		 * Fill character to the TX FIFO entry.
-		 */
-		if ((unsigned int)(sport->port.membase) != UART1_BASE_ADDR) {
-			*dma_buf = sport->port.x_char;
-			sport->port.uart_tx_dma_phy0_end = DMA_TX_GOING;
-        	DMA_TX_START(uartport, sport->port.uart_tx_dma_phy0, 1);
-		}
-		else {
-			uart->urtxf[0] = sport->port.x_char;
-		}
-
-		sport->port.icount.tx++;
-		sport->port.x_char = 0;
-		return;
-	}
-	/*Check the modem control lines before transmitting anything.*/
-	wmt_mctrl_check(sport);
-
-	if (uart_circ_empty(xmit) || uart_tx_stopped(&sport->port)) {
-		wmt_stop_tx(&sport->port);
-		return;
-	}
-
-	/*{2007/11/10 JHT Support the WMT Serial Port Driver Because the
-	 *                definition of URSIRT Bit[0] & Bit[3] are different.
-	 *                Before WMT these bit are defined as RO, in WMT
-	 *                they are changed into the W1C. Therefore the xmit function
-	 *                for the FIFO mode should be modified as well.
-	 */
-
-
-	if ((unsigned int)(sport->port.membase) != UART1_BASE_ADDR ) {
-		if (sport->port.uart_tx_dma_phy0_end == DMA_TX_END) {	
-            tx_count = 0;
-            while (!uart_circ_empty(xmit)) {	
-  
-                *dma_buf = xmit->buf[xmit->tail];
-                xmit->tail = (xmit->tail + 1) & (UART_XMIT_SIZE - 1);
-                sport->port.icount.tx++;
-                dma_buf ++;
-                tx_count++;
-                if (tx_count == UART_BUFFER_SIZE)
-                    break;
-            }
-			sport->port.uart_tx_dma_phy0_end = DMA_TX_GOING;
-            DMA_TX_START(uartport, sport->port.uart_tx_dma_phy0, tx_count);
-     	}
-	}
-	else {
-		while ((uart->urfidx & 0x1F) < 16) {
-			if (uart_circ_empty(xmit))
-				break;
-
-			if (uart->urusr & URUSR_TXDBSY)
-				continue;
-			uart->urtxf[0] = xmit->buf[xmit->tail];
-			xmit->tail = (xmit->tail + 1) & (UART_XMIT_SIZE - 1);
-			sport->port.icount.tx++;
-		}
-	}
-	if (uart_circ_chars_pending(xmit) < WAKEUP_CHARS)
-		uart_write_wakeup(&sport->port);
-	if (uart_circ_empty(xmit))
-		wmt_stop_tx(&sport->port);
-}
-#endif
 
 static irqreturn_t wmt_int(int irq, void *dev_id)
 {
@@ -1261,7 +989,12 @@ static irqreturn_t wmt_int(int irq, void *dev_id)
 
 		if (status & URISR_TO_SM(URISR_RXFAF | URISR_RXFF | URISR_RXTOUT |\
 								 URISR_PER | URISR_FER)) {
-			wmt_rx_chars(sport,  status);
+		#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+			if (sport->use_dma)
+				wmt_rx_dma_irq(sport, status);
+			else
+		#endif
+				wmt_rx_chars(sport,  status);
 		}
 		/*
 		 * Second, we handle TX events.
@@ -1272,9 +1005,8 @@ static irqreturn_t wmt_int(int irq, void *dev_id)
 	#ifndef CONFIG_SERIAL_WMT_DUAL_DMA
 		wmt_tx_chars(sport);
 	#else
-		if ((unsigned int)(sport->port.membase) == UART1_BASE_ADDR) {
-					wmt_tx_chars(sport);	
-			}			
+		if (!sport->use_dma)
+			wmt_tx_chars(sport);
 	#endif
 	
 		if (pass_counter++ > WMT_ISR_PASS_LIMIT)
@@ -1314,6 +1046,10 @@ static unsigned int wmt_tx_empty(struct uart_port *port)
 	struct wmt_port *sport = (struct wmt_port *)port;
 	struct wmt_uart *uart = (struct wmt_uart *)PORT_TO_BASE(sport);
 
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+	if (sport->tx_count)
+		return 0;
+#endif
 	return (uart->urusr & URUSR_TXDBSY) ? 0 : TIOCSER_TEMT;
 }
 
@@ -1397,25 +1133,76 @@ static char *wmt_uartname[] = {
 };
 
 #ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+/*
+ * A ring half is full. Account it, queue it again behind the other half
+ * and flush.
+ */
 static void uart_dma_callback_rx(void *data)
 {
 	struct uart_port	*uartport = data;
-	
-	if (uartport->buffer_used == 1) {
-		uartport->buffer_used = 0;
-		DMA_RX_START(uartport, uartport->uart_rx_dma_phy1, UART_BUFFER_SIZE);
-	} else {
-		uartport->buffer_used = 1;
-		DMA_RX_START(uartport, uartport->uart_rx_dma_phy0, UART_BUFFER_SIZE);
-	}       
+	struct wmt_port *sport = (struct wmt_port *)uartport;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sport->port.lock, flags);
+	DMA_RX_START(uartport, sport->rx_ring_phy +
+		(sport->rx_dma_done & (UART_RX_RING_SIZE - 1)), UART_BUFFER_SIZE);
+	sport->rx_dma_done += UART_BUFFER_SIZE;
+	sport->rx_dma_off = 0;
+	if (sport->port.state) {
+		wmt_rx_dma_flush(sport);
+		wmt_rx_dma_kick(sport);
+	}
+	spin_unlock_irqrestore(&sport->port.lock, flags);
 }
+
 static void uart_dma_callback_tx(void *data)
 {
 	struct uart_port	*uartport = data;
 	struct wmt_port *sport = (struct wmt_port *)uartport;
+	struct circ_buf *xmit;
+	unsigned long flags;
 
+	spin_lock_irqsave(&sport->port.lock, flags);
+	if (sport->port.state) {
+		xmit = &sport->port.state->xmit;
+		xmit->tail = (xmit->tail + sport->tx_count) & (UART_XMIT_SIZE - 1);
+		sport->port.icount.tx += sport->tx_count;
+		sport->stats.tx_bytes += sport->tx_count;
+	}
+	sport->tx_count = 0;
 	sport->port.uart_tx_dma_phy0_end = DMA_TX_END;
-	wmt_tx_chars(sport);
+	if (sport->port.state)
+		wmt_tx_chars(sport);
+	spin_unlock_irqrestore(&sport->port.lock, flags);
+}
+#endif
+
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+/*
+ * Undo the DMA setup of wmt_startup().  RX DMA is stopped first, so that
+ * its completion callback can no longer restart rx_timer.
+ */
+static void wmt_release_dma(struct wmt_port *sport)
+{
+	struct uart_port *uartport = &sport->port;
+	unsigned long timeout;
+
+	DMA_RX_STOP(uartport);
+	hrtimer_cancel(&sport->rx_timer);
+	DMA_RX_CLEAR(uartport);
+	DMA_RX_FREE(uartport);
+	/* Let a transfer in flight drain, but don't hang on a stuck channel */
+	timeout = jiffies + HZ / 2;
+	while (sport->port.uart_tx_dma_phy0_end != DMA_TX_END &&
+	       time_before(jiffies, timeout))
+		msleep(1);
+	DMA_TX_STOP(uartport);
+	DMA_TX_CLEAR(uartport);
+	DMA_TX_FREE(uartport);
+	sport->port.uart_tx_dma_phy0_end = DMA_TX_END;
+	dma_unmap_single(sport->port.dev, sport->tx_buf_phy, UART_XMIT_SIZE, DMA_TO_DEVICE);
+	dma_free_coherent(sport->port.dev, UART_RX_RING_SIZE, sport->rx_ring, sport->rx_ring_phy);
+	sport->rx_ring = NULL;
 }
 #endif
 
@@ -1461,18 +1248,17 @@ static int wmt_startup(struct uart_port *port)
 		sport->port.dma_tx_cfg 	= dma_device_cfg_table[UART_0_TX_DMA_REQ];
 #endif*/
 		break;
-#if 0
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
 	case IRQ_UART1:
 		uartname = wmt_uartname[1];
-#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
 		sport->port.dma_rx_dev	= UART_1_RX_DMA_REQ;
 		sport->port.dma_tx_dev	= UART_1_TX_DMA_REQ;
 		sport->port.id			= "uart1";
 		sport->port.dma_rx_cfg 	= dma_device_cfg_table[UART_1_RX_DMA_REQ];
 		sport->port.dma_tx_cfg 	= dma_device_cfg_table[UART_1_TX_DMA_REQ];
-#endif
 		break;
-
+#endif
+#if 0
 	case IRQ_UART2:
 		uartname = wmt_uartname[2];
 #ifdef CONFIG_SERIAL_WMT_DUAL_DMA
@@ -1496,36 +1282,31 @@ static int wmt_startup(struct uart_port *port)
 #endif
 	}
 #ifdef CONFIG_SERIAL_WMT_DUAL_DMA
-	if ((unsigned int)(sport->port.membase) != UART1_BASE_ADDR) {
-		sport->port.uart_rx_dma_buf0_org = dma_alloc_coherent(NULL, UART_BUFFER_SIZE, &sport->port.uart_rx_dma_phy0_org, GFP_KERNEL );
-		sport->port.uart_rx_dma_buf1_org = dma_alloc_coherent(NULL, UART_BUFFER_SIZE, &sport->port.uart_rx_dma_phy1_org, GFP_KERNEL );
-		sport->port.uart_tx_dma_buf0_org = dma_alloc_coherent(NULL, UART_BUFFER_SIZE, &sport->port.uart_tx_dma_phy0_org, GFP_KERNEL );
-		memset(sport->port.uart_rx_dma_buf0_org, 0x00, UART_BUFFER_SIZE);
-		memset(sport->port.uart_rx_dma_buf1_org, 0x00, UART_BUFFER_SIZE);
-		memset(sport->port.uart_tx_dma_buf0_org, 0x00, UART_BUFFER_SIZE);
-		sport->port.uart_rx_dma_buf0 = sport->port.uart_rx_dma_buf0_org;
-		sport->port.uart_rx_dma_buf1 = sport->port.uart_rx_dma_buf1_org;
-		sport->port.uart_rx_dma_phy0 = sport->port.uart_rx_dma_phy0_org;
-		sport->port.uart_rx_dma_phy1 = sport->port.uart_rx_dma_phy1_org;
-		sport->port.uart_dma_tmp_buf0 = sport->port.uart_rx_dma_buf0_org;
-		sport->port.uart_dma_tmp_phy0 = sport->port.uart_rx_dma_phy0_org;
-		sport->port.uart_dma_tmp_buf1 = sport->port.uart_rx_dma_buf1_org;
-		sport->port.uart_dma_tmp_phy1 = sport->port.uart_rx_dma_phy1_org;
-		sport->port.uart_tx_dma_buf0 = sport->port.uart_tx_dma_buf0_org;
-		sport->port.uart_tx_dma_phy0 = sport->port.uart_tx_dma_phy0_org;
-		sport->port.buffer_used = 0;   /*to record which buf DMA hardware used*/
-		sport->port.buffer_selected = 0; /* to record which buf software is used to put data to kernel*/
+	if (sport->use_dma) {
+		sport->rx_ring = dma_alloc_coherent(sport->port.dev, UART_RX_RING_SIZE,
+			&sport->rx_ring_phy, GFP_KERNEL);
+		if (!sport->rx_ring)
+			return -ENOMEM;
+		sport->tx_buf_phy = dma_map_single(sport->port.dev, sport->port.state->xmit.buf,
+			UART_XMIT_SIZE, DMA_TO_DEVICE);
+		sport->rx_dma_done = 0;
+		sport->rx_dma_off = 0;
+		sport->rx_read = 0;
+		sport->tx_count = 0;
 		sport->port.dma_reg = (struct dma_regs_s *)0xd8001800;  /*points to appropriate DMA registers*/
 		sport->port.rx_dmach = NULL_DMA;
 		sport->port.tx_dmach = NULL_DMA;
-		sport->port.last_pos = 0;
 		sport->port.uart_tx_dma_phy0_end = DMA_TX_END;
 		DMA_RX_REQUEST(uartport, uart_dma_callback_rx);
 		DMA_TX_REQUEST(uartport, uart_dma_callback_tx);
 		wmt_setup_dma(uartport->rx_dmach, uartport->dma_rx_cfg);
 		wmt_setup_dma(uartport->tx_dmach, uartport->dma_tx_cfg);
-		DMA_RX_START(uartport, sport->port.uart_rx_dma_phy0, UART_BUFFER_SIZE);
-		DMA_RX_START(uartport, sport->port.uart_rx_dma_phy1, UART_BUFFER_SIZE);
+		/*
+		 * The channel has no cyclic mode, keep both ring halves queued
+		 * and queue a half again from its completion callback.
+		 */
+		DMA_RX_START(uartport, sport->rx_ring_phy, UART_BUFFER_SIZE);
+		DMA_RX_START(uartport, sport->rx_ring_phy + UART_BUFFER_SIZE, UART_BUFFER_SIZE);
 	}
 #endif
 	/*
@@ -1533,8 +1314,13 @@ static int wmt_startup(struct uart_port *port)
 	 */
 	
 	retval = request_irq(sport->port.irq, wmt_int, 0, uartname, sport);
-	if (retval)
+	if (retval) {
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+		if (sport->use_dma)
+			wmt_release_dma(sport);
+#endif
 		return retval;
+	}
 	
 	/*
 	 * Setup the UART clock divisor
@@ -1560,7 +1346,7 @@ static int wmt_startup(struct uart_port *port)
 
 	uart->urlcr |=  (URLCR_DLEN & ~URLCR_STBLEN & ~URLCR_PTYEN);
 #ifdef CONFIG_SERIAL_WMT_DUAL_DMA
-	if ((unsigned int)(sport->port.membase) != UART1_BASE_ADDR) {
+	if (sport->use_dma) {
 		uart->urfcr = URFCR_FIFOEN | URFCR_TXFLV(8) | URFCR_RXFLV(1) | URFCR_TRAIL;
 		uart->urtod = 0x05;
 	}
@@ -1573,7 +1359,7 @@ static int wmt_startup(struct uart_port *port)
 	/* Enable Fifo, Tx 8 , Rx 8*/
 #ifdef CONFIG_SERIAL_WMT_DUAL_DMA
 		
-	if ((unsigned int)(sport->port.membase) != UART1_BASE_ADDR)
+	if (sport->use_dma)
 		uart->urlcr |= URLCR_RXEN | URLCR_TXEN | URLCR_DMAEN;
 	else
 		uart->urlcr |= URLCR_RXEN | URLCR_TXEN;
@@ -1583,6 +1369,12 @@ static int wmt_startup(struct uart_port *port)
 	/*
 	 * Enable RX FIFO almost full, timeout, and overrun interrupts.
 	 */
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+	/* DMA drains the RX FIFO, only the line going idle and errors are of interest */
+	if (sport->use_dma)
+		uart->urier = URIER_ERXTOUT | URIER_EPER | URIER_EFER | URIER_ERXDOVR;
+	else
+#endif
 	uart->urier = URIER_ERXFAF | URIER_ERXFF | URIER_ERXTOUT | URIER_EPER | URIER_EFER | URIER_ERXDOVR;
 
 	/*
@@ -1600,10 +1392,6 @@ static void wmt_shutdown(struct uart_port *port)
 	struct wmt_port *sport = (struct wmt_port *)port;
 	struct wmt_uart *uart = (struct wmt_uart *)PORT_TO_BASE(sport);
 	
-#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
-	struct uart_port	*uartport = &sport->port;
-#endif
-	
 	/*
 	 * Stop our timer.
 	 */
@@ -1628,21 +1416,8 @@ static void wmt_shutdown(struct uart_port *port)
 #endif
 #endif
 #ifdef CONFIG_SERIAL_WMT_DUAL_DMA
-	if ((unsigned int)(sport->port.membase) != UART1_BASE_ADDR) {
-		dma_free_coherent(sport->port.dev, UART_BUFFER_SIZE, sport->port.uart_rx_dma_buf0, sport->port.uart_rx_dma_phy0);
-		dma_free_coherent(sport->port.dev, UART_BUFFER_SIZE, sport->port.uart_rx_dma_buf1, sport->port.uart_rx_dma_phy1);
-		DMA_RX_STOP(uartport);
-		DMA_RX_CLEAR(uartport);
-		DMA_RX_FREE(uartport);
-	while (sport->port.uart_tx_dma_phy0_end != DMA_TX_END) {
-			msleep(1);
-	}
-	
-	dma_free_coherent(sport->port.dev, UART_BUFFER_SIZE, sport->port.uart_tx_dma_buf0, sport->port.uart_tx_dma_phy0);
-    DMA_TX_STOP(uartport);
-	DMA_TX_CLEAR(uartport);
-	DMA_TX_FREE(uartport);
-	}
+	if (sport->use_dma)
+		wmt_release_dma(sport);
 #endif
 }
 
@@ -1728,6 +1503,12 @@ wmt_set_termios(struct uart_port *port, struct ktermios *termios, struct ktermio
 	 */
 	baud = uart_get_baud_rate(port, termios, old, 9600, 921600);
 
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+	/* 10 bits per char, do not go below the hrtimer's useful resolution */
+	sport->rx_flush_period = ns_to_ktime(max(UART_RX_FLUSH_MIN_NS,
+		(int)(UART_RX_FLUSH_CHARS * 10 * (1000000000 / baud))));
+#endif
+
 	/*
 	 * We need to calculate quot by ourself.
 	 *
@@ -1980,6 +1761,11 @@ static void wmt_init_ports(void)
 		init_timer(&wmt_ports[i].timer);
 		wmt_ports[i].timer.function  = wmt_timeout;
 		wmt_ports[i].timer.data      = (unsigned long)&wmt_ports[i];
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
+		hrtimer_init(&wmt_ports[i].rx_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		wmt_ports[i].rx_timer.function = wmt_rx_dma_timer;
+		wmt_ports[i].rx_flush_period = ns_to_ktime(UART_RX_FLUSH_MIN_NS);
+#endif
 	}
 
 	/*
@@ -2022,13 +1808,16 @@ void __init wmt_register_uart(int idx, int port)
 		wmt_ports[idx].port.irq     = IRQ_UART0;
 		wmt_ports[idx].port.flags   = ASYNC_BOOT_AUTOCONF;
 		break;
-#if 0
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
 	case 2:
 		wmt_ports[idx].port.membase = (void *)(REG32_PTR(UART2_BASE_ADDR));
 		wmt_ports[idx].port.mapbase = UART2_BASE_ADDR;
 		wmt_ports[idx].port.irq     = IRQ_UART1;
 		wmt_ports[idx].port.flags   = ASYNC_BOOT_AUTOCONF;
+		wmt_ports[idx].use_dma      = 1;
 		break;
+#endif
+#if 0
 
 	case 3:
 		wmt_ports[idx].port.membase = (void *)(REG32_PTR(UART3_BASE_ADDR));
@@ -2290,11 +2079,12 @@ static int wmt_serial_suspend(struct platform_device *pdev, pm_message_t state)
         case IRQ_UART0:
 		REG32_VAL(PMCEL_ADDR) &= ~( BIT1 );
                 break;
-#if 0
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
         case IRQ_UART1:
 		REG32_VAL(PMCEL_ADDR) &= ~( BIT2 );
                 break;
-
+#endif
+#if 0
         case IRQ_UART2:
 		REG32_VAL(PMCEL_ADDR) &= ~( BIT3 );
                 break;
@@ -2321,11 +2111,12 @@ static int wmt_serial_resume(struct platform_device *pdev)
         case IRQ_UART0:
               REG32_VAL(PMCEL_ADDR) |= (BIT1);
                 break;
-#if 0				
+#ifdef CONFIG_SERIAL_WMT_DUAL_DMA
         case IRQ_UART1:
               REG32_VAL(PMCEL_ADDR) |= ( BIT2 );
                 break;
-
+#endif
+#if 0
         case IRQ_UART2:
               REG32_VAL(PMCEL_ADDR) |= ( BIT3 );
                 break;
@@ -2382,6 +2173,34 @@ static int wmt_serial_remove(struct platform_device *pdev)
 	return 0;
 }
 
+#if defined(CONFIG_SERIAL_WMT_DUAL_DMA) && defined(CONFIG_PROC_FS)
+/* DMA port statistics in /proc/wmt-uart */
+static int wmt_uart_read_proc(char *page, char **start, off_t off, int count, int *eof, void *data)
+{
+	struct wmt_port *sport;
+	char *p = page;
+	int i;
+
+	for (i = 0; i < NR_PORTS; i++) {
+		sport = &wmt_ports[i];
+		if (!sport->use_dma)
+			continue;
+		p += sprintf(p, "ttyS%d: flush period %lld us\n", i,
+			ktime_to_ns(sport->rx_flush_period) / 1000);
+		p += sprintf(p, "rx bytes      : %u\n", sport->stats.rx_bytes);
+		p += sprintf(p, "rx flushes    : %u\n", sport->stats.rx_flushes);
+		p += sprintf(p, "rx ring ovr   : %u\n", sport->stats.rx_overrun);
+		p += sprintf(p, "rx tty drop   : %u\n", sport->stats.rx_tty_drop);
+		p += sprintf(p, "flush lat last: %u us\n", sport->stats.flush_lat_last);
+		p += sprintf(p, "flush lat max : %u us\n", sport->stats.flush_lat_max);
+		p += sprintf(p, "tx bytes      : %u\n", sport->stats.tx_bytes);
+		p += sprintf(p, "tx dma        : %u\n", sport->stats.tx_dma);
+	}
+	*eof = 1;
+	return p - page;
+}
+#endif
+
 static struct platform_driver wmt_serial_driver = {
 	.driver.name    = "uart",
 	.probe          = wmt_serial_probe,
@@ -2402,6 +2221,10 @@ static int __init wmt_serial_init(void)
 		if (ret)
 			uart_unregister_driver(&wmt_reg);
 	}
+#if defined(CONFIG_SERIAL_WMT_DUAL_DMA) && defined(CONFIG_PROC_FS)
+	if (ret == 0)
+		create_proc_read_entry("wmt-uart", 0, NULL, wmt_uart_read_proc, NULL);
+#endif
 #ifdef DEBUG_MESSAGE_TO_MEM
 	if (buf_start == NULL) {
 		buf_start = ioremap(debug_buf_addr,debug_buf_size);
@@ -2421,6 +2244,9 @@ static int __init wmt_serial_init(void)
 
 static void __exit wmt_serial_exit(void)
 {
+#if defined(CONFIG_SERIAL_WMT_DUAL_DMA) && defined(CONFIG_PROC_FS)
+	remove_proc_entry("wmt-uart", NULL);
+#endif
 	platform_driver_unregister(&wmt_serial_driver);
 	uart_unregister_driver(&wmt_reg);
 }
@@ -29,6 +29,7 @@
 #include <linux/proc_fs.h>
 #include <linux/rbtree.h>
 #include <linux/sched.h>
+#include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/vmalloc.h>
 
@@ -128,11 +129,16 @@ enum binder_stat_types {
 	BINDER_STAT_COUNT
 };
 
+/* log2 histogram buckets of latencies in us, the last one is open */
+#define BINDER_LAT_BUCKETS 16
+
 struct binder_stats {
 	int br[_IOC_NR(BR_FAILED_REPLY) + 1];
 	int bc[_IOC_NR(BC_DEAD_BINDER_DONE) + 1];
 	int obj_created[BINDER_STAT_COUNT];
 	int obj_deleted[BINDER_STAT_COUNT];
+	int deliver_lat[BINDER_LAT_BUCKETS];	/* queued to read by target */
+	int reply_lat[BINDER_LAT_BUCKETS];	/* call to reply read by caller */
 };
 
 static struct binder_stats binder_stats;
@@ -337,8 +343,13 @@ struct binder_transaction {
 	long	priority;
 	long	saved_priority;
 	uid_t	sender_euid;
+	ktime_t	start;		/* queued */
+	ktime_t	call_start;	/* reply only: start of the call */
 };
 
+static struct kmem_cache *binder_transaction_cachep;
+static struct kmem_cache *binder_work_cachep;	/* transaction complete */
+
 static void
 binder_defer_work(struct binder_proc *proc, enum binder_deferred_state defer);
 
@@ -1223,7 +1234,7 @@ static void binder_pop_transaction(struct binder_thread *target_thread,
 	t->need_reply = 0;
 	if (t->buffer)
 		t->buffer->transaction = NULL;
-	kfree(t);
+	kmem_cache_free(binder_transaction_cachep, t);
 	binder_stats_deleted(BINDER_STAT_TRANSACTION);
 }
 
@@ -1481,14 +1492,14 @@ static void binder_transaction(struct binder_proc *proc,
 	e->to_proc = target_proc->pid;
 
 	/* TODO: reuse incoming transaction for reply */
-	t = kzalloc(sizeof(*t), GFP_KERNEL);
+	t = kmem_cache_zalloc(binder_transaction_cachep, GFP_KERNEL);
 	if (t == NULL) {
 		return_error = BR_FAILED_REPLY;
 		goto err_alloc_t_failed;
 	}
 	binder_stats_created(BINDER_STAT_TRANSACTION);
 
-	tcomplete = kzalloc(sizeof(*tcomplete), GFP_KERNEL);
+	tcomplete = kmem_cache_zalloc(binder_work_cachep, GFP_KERNEL);
 	if (tcomplete == NULL) {
 		return_error = BR_FAILED_REPLY;
 		goto err_alloc_tcomplete_failed;
@@ -1497,6 +1508,9 @@ static void binder_transaction(struct binder_proc *proc,
 
 	t->debug_id = ++binder_last_id;
 	e->debug_id = t->debug_id;
+	t->start = ktime_get();
+	if (reply)
+		t->call_start = in_reply_to->start;
 
 	if (reply)
 		binder_debug(BINDER_DEBUG_TRANSACTION,
@@ -1718,8 +1732,17 @@ static void binder_transaction(struct binder_proc *proc,
 	list_add_tail(&t->work.entry, target_list);
 	tcomplete->type = BINDER_WORK_TRANSACTION_COMPLETE;
 	list_add_tail(&tcomplete->entry, &thread->todo);
-	if (target_wait)
-		wake_up_interruptible(target_wait);
+	if (target_wait) {
+		/*
+		 * The caller of a synchronous transaction or of a reply
+		 * goes to sleep right away, let the target run on this
+		 * CPU instead of preempting the caller for it.
+		 */
+		if (reply || !(t->flags & TF_ONE_WAY))
+			wake_up_interruptible_sync(target_wait);
+		else
+			wake_up_interruptible(target_wait);
+	}
 	return;
 
 err_get_unused_fd_failed:
@@ -1735,10 +1758,10 @@ err_copy_data_failed:
 	t->buffer->transaction = NULL;
 	binder_free_buf(target_proc, t->buffer);
 err_binder_alloc_buf_failed:
-	kfree(tcomplete);
+	kmem_cache_free(binder_work_cachep, tcomplete);
 	binder_stats_deleted(BINDER_STAT_TRANSACTION_COMPLETE);
 err_alloc_tcomplete_failed:
-	kfree(t);
+	kmem_cache_free(binder_transaction_cachep, t);
 	binder_stats_deleted(BINDER_STAT_TRANSACTION);
 err_alloc_t_failed:
 err_bad_call_stack:
@@ -2160,6 +2183,34 @@ void binder_stat_br(struct binder_proc *proc, struct binder_thread *thread,
 	}
 }
 
+static int binder_lat_bucket(ktime_t start, ktime_t now)
+{
+	s64 us = ktime_to_us(ktime_sub(now, start));
+
+	if (us >= 1 << (BINDER_LAT_BUCKETS - 2))
+		return BINDER_LAT_BUCKETS - 1;
+	return fls(us);
+}
+
+static void binder_stat_latency(struct binder_proc *proc,
+				struct binder_thread *thread,
+				struct binder_transaction *t, ktime_t now)
+{
+	int i;
+
+	i = binder_lat_bucket(t->start, now);
+	binder_stats.deliver_lat[i]++;
+	proc->stats.deliver_lat[i]++;
+	thread->stats.deliver_lat[i]++;
+
+	if (t->buffer->target_node)
+		return;
+	i = binder_lat_bucket(t->call_start, now);
+	binder_stats.reply_lat[i]++;
+	proc->stats.reply_lat[i]++;
+	thread->stats.reply_lat[i]++;
+}
+
 static int binder_has_proc_work(struct binder_proc *proc,
 				struct binder_thread *thread)
 {
@@ -2281,7 +2332,7 @@ retry:
 				     proc->pid, thread->pid);
 
 			list_del(&w->entry);
-			kfree(w);
+			kmem_cache_free(binder_work_cachep, w);
 			binder_stats_deleted(BINDER_STAT_TRANSACTION_COMPLETE);
 		} break;
 		case BINDER_WORK_NODE: {
@@ -2429,6 +2480,7 @@ retry:
 		ptr += sizeof(tr);
 
 		binder_stat_br(proc, thread, cmd);
+		binder_stat_latency(proc, thread, t, ktime_get());
 		binder_debug(BINDER_DEBUG_TRANSACTION,
 			     "binder: %d:%d %s %d %d:%d, cmd %d"
 			     "size %zd-%zd ptr %p-%p\n",
@@ -2448,7 +2500,7 @@ retry:
 			thread->transaction_stack = t;
 		} else {
 			t->buffer->transaction = NULL;
-			kfree(t);
+			kmem_cache_free(binder_transaction_cachep, t);
 			binder_stats_deleted(BINDER_STAT_TRANSACTION);
 		}
 		break;
@@ -2487,7 +2539,7 @@ static void binder_release_work(struct list_head *list)
 				binder_send_failed_reply(t, BR_DEAD_REPLY);
 		} break;
 		case BINDER_WORK_TRANSACTION_COMPLETE: {
-			kfree(w);
+			kmem_cache_free(binder_work_cachep, w);
 			binder_stats_deleted(BINDER_STAT_TRANSACTION_COMPLETE);
 		} break;
 		default:
@@ -3384,6 +3436,32 @@ static const char *binder_objstat_strings[] = {
 	"transaction_complete"
 };
 
+static char *print_binder_latency(char *buf, char *end, const char *prefix,
+				  const char *name, int *lat)
+{
+	int i, total = 0;
+
+	for (i = 0; i < BINDER_LAT_BUCKETS; i++)
+		total += lat[i];
+	if (!total)
+		return buf;
+
+	buf += snprintf(buf, end - buf, "%s%s latency:", prefix, name);
+	for (i = 0; i < BINDER_LAT_BUCKETS && buf < end; i++) {
+		if (!lat[i])
+			continue;
+		if (i == BINDER_LAT_BUCKETS - 1)
+			buf += snprintf(buf, end - buf, " >=%uus %d",
+					1U << (i - 1), lat[i]);
+		else
+			buf += snprintf(buf, end - buf, " <%uus %d",
+					1U << i, lat[i]);
+	}
+	if (buf < end)
+		buf += snprintf(buf, end - buf, "\n");
+	return buf;
+}
+
 static char *print_binder_stats(char *buf, char *end, const char *prefix,
 				struct binder_stats *stats)
 {
@@ -3425,6 +3503,13 @@ static char *print_binder_stats(char *buf, char *end, const char *prefix,
 		if (buf >= end)
 			return buf;
 	}
+
+	buf = print_binder_latency(buf, end, prefix, "deliver",
+				   stats->deliver_lat);
+	if (buf >= end)
+		return buf;
+	buf = print_binder_latency(buf, end, prefix, "reply",
+				   stats->reply_lat);
 	return buf;
 }
 
@@ -3727,6 +3812,20 @@ static int __init binder_init(void)
 {
 	int ret;
 
+	binder_transaction_cachep = kmem_cache_create("binder_transaction",
+				sizeof(struct binder_transaction), 0,
+				SLAB_HWCACHE_ALIGN, NULL);
+	binder_work_cachep = kmem_cache_create("binder_work",
+				sizeof(struct binder_work), 0,
+				SLAB_HWCACHE_ALIGN, NULL);
+	if (!binder_transaction_cachep || !binder_work_cachep) {
+		if (binder_transaction_cachep)
+			kmem_cache_destroy(binder_transaction_cachep);
+		if (binder_work_cachep)
+			kmem_cache_destroy(binder_work_cachep);
+		return -ENOMEM;
+	}
+
 	binder_proc_dir_entry_root = proc_mkdir("binder", NULL);
 	if (binder_proc_dir_entry_root)
 		binder_proc_dir_entry_proc = proc_mkdir("proc",
@@ -15,6 +15,16 @@
  * The driver considers memory used for caches to be free, but if a large
  * percentage of the cached memory is locked this can be very inaccurate
  * and processes may not get killed until the normal oom killer is triggered.
+ * To catch this, it watches how many of the pages scanned by vmscan are
+ * actually reclaimed. When less than 100 - reclaim_level percent come
+ * back, the cache is not counted as free for the levels with an oom_adj
+ * of reclaim_min_adj or higher, so those are killed before direct reclaim
+ * starts thrashing the page cache.
+ *
+ * The largest tasks per oom_adj are kept in a small candidate list, which
+ * is rebuilt when an oom_adj changes or after a second, instead of walking
+ * the task list on every shrinker call. Kills are reported by the
+ * lowmemorykiller/lowmem_kill trace event.
  *
  * Copyright (C) 2007-2008 Google, Inc.
  *
@@ -34,6 +44,15 @@
 #include <linux/mm.h>
 #include <linux/oom.h>
 #include <linux/sched.h>
+#include <linux/mutex.h>
+#include <linux/notifier.h>
+#include <linux/profile.h>
+#include <linux/swap.h>
+#include <linux/vmstat.h>
+#include <linux/ktime.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/lowmemorykiller.h>
 
 static uint32_t lowmem_debug_level = 2;
 static int lowmem_adj[6] = {
@@ -50,6 +69,32 @@ static size_t lowmem_minfree[6] = {
 	16 * 1024,	/* 64MB */
 };
 static int lowmem_minfree_size = 4;
+static uint32_t lowmem_reclaim_level = 90;	/* % of scanned not reclaimed */
+static int lowmem_reclaim_min_adj = 6;
+
+#define LOWMEM_CANDIDATES	8
+#define LOWMEM_REBUILD_INTERVAL	HZ
+#define LOWMEM_SAMPLE_INTERVAL	(HZ / 4)
+#define LOWMEM_SAMPLE_MIN	256	/* pages scanned for a valid sample */
+
+struct lowmem_candidate {
+	struct task_struct *task;
+	int oom_adj;
+	int tasksize;
+};
+
+/* best candidate first, the tasks are referenced */
+static struct lowmem_candidate lowmem_candidates[LOWMEM_CANDIDATES];
+static int lowmem_ncandidates;
+static int lowmem_candidates_gen;
+static unsigned long lowmem_candidates_expires;
+
+static struct task_struct *lowmem_deathpending;
+static unsigned long lowmem_deathpending_timeout;
+static int lowmem_efficiency = 100;
+
+/* serializes decisions, concurrent reclaimers leave it to the first one */
+static DEFINE_MUTEX(lowmem_lock);
 
 #define lowmem_print(level, x...)			\
 	do {						\
@@ -57,50 +102,84 @@ static int lowmem_minfree_size = 4;
 			printk(x);			\
 	} while (0)
 
-static int lowmem_shrink(int nr_to_scan, gfp_t gfp_mask)
+static int
+task_notify_func(struct notifier_block *self, unsigned long val, void *data);
+
+static struct notifier_block task_nb = {
+	.notifier_call	= task_notify_func,
+};
+
+static int
+task_notify_func(struct notifier_block *self, unsigned long val, void *data)
 {
-	struct task_struct *p;
-	struct task_struct *selected = NULL;
-	int rem = 0;
-	int tasksize;
+	struct task_struct *task = data;
+
+	if (task == lowmem_deathpending)
+		lowmem_deathpending = NULL;
+	return NOTIFY_OK;
+}
+
+#ifdef CONFIG_VM_EVENT_COUNTERS
+static unsigned long lowmem_events[NR_VM_EVENT_ITEMS];
+static unsigned long lowmem_last_scanned;
+static unsigned long lowmem_last_reclaimed;
+static unsigned long lowmem_sample_expires;
+
+/*
+ * Percentage of the pages scanned by kswapd and direct reclaim in all
+ * zones that were reclaimed since the last sample. Without enough
+ * scanning there is no pressure and the result is 100.
+ */
+static void lowmem_update_efficiency(void)
+{
+	unsigned long scanned = 0, reclaimed = 0;
 	int i;
-	int min_adj = OOM_ADJUST_MAX + 1;
-	int selected_tasksize = 0;
-	int selected_oom_adj;
-	int array_size = ARRAY_SIZE(lowmem_adj);
-	int other_free = global_page_state(NR_FREE_PAGES);
-	int other_file = global_page_state(NR_FILE_PAGES);
 
-	if (lowmem_adj_size < array_size)
-		array_size = lowmem_adj_size;
-	if (lowmem_minfree_size < array_size)
-		array_size = lowmem_minfree_size;
-	for (i = 0; i < array_size; i++) {
-		if (other_free < lowmem_minfree[i] &&
-		    other_file < lowmem_minfree[i]) {
-			min_adj = lowmem_adj[i];
-			break;
-		}
-	}
-	if (nr_to_scan > 0)
-		lowmem_print(3, "lowmem_shrink %d, %x, ofree %d %d, ma %d\n",
-			     nr_to_scan, gfp_mask, other_free, other_file,
-			     min_adj);
-	rem = global_page_state(NR_ACTIVE_ANON) +
-		global_page_state(NR_ACTIVE_FILE) +
-		global_page_state(NR_INACTIVE_ANON) +
-		global_page_state(NR_INACTIVE_FILE);
-	if (nr_to_scan <= 0 || min_adj == OOM_ADJUST_MAX + 1) {
-		lowmem_print(5, "lowmem_shrink %d, %x, return %d\n",
-			     nr_to_scan, gfp_mask, rem);
-		return rem;
+	if (time_before(jiffies, lowmem_sample_expires))
+		return;
+	lowmem_sample_expires = jiffies + LOWMEM_SAMPLE_INTERVAL;
+
+	all_vm_events(lowmem_events);
+	for (i = 0; i < MAX_NR_ZONES; i++) {
+		scanned += lowmem_events[PGSCAN_KSWAPD_NORMAL - ZONE_NORMAL + i] +
+			lowmem_events[PGSCAN_DIRECT_NORMAL - ZONE_NORMAL + i];
+		reclaimed += lowmem_events[PGSTEAL_NORMAL - ZONE_NORMAL + i];
 	}
-	selected_oom_adj = min_adj;
 
-	read_lock(&tasklist_lock);
+	if (scanned - lowmem_last_scanned >= LOWMEM_SAMPLE_MIN)
+		lowmem_efficiency = (reclaimed - lowmem_last_reclaimed) * 100 /
+				    (scanned - lowmem_last_scanned);
+	else
+		lowmem_efficiency = 100;
+	lowmem_last_scanned = scanned;
+	lowmem_last_reclaimed = reclaimed;
+}
+#else
+static inline void lowmem_update_efficiency(void)
+{
+}
+#endif
+
+static int lowmem_better(int oom_adj, int tasksize,
+			 struct lowmem_candidate *c)
+{
+	if (oom_adj != c->oom_adj)
+		return oom_adj > c->oom_adj;
+	return tasksize > c->tasksize;
+}
+
+/* Called with tasklist_lock held for reading */
+static void lowmem_rebuild_candidates(void)
+{
+	struct task_struct *p;
+	int i, n = 0;
+
+	for (i = 0; i < lowmem_ncandidates; i++)
+		put_task_struct(lowmem_candidates[i].task);
+
 	for_each_process(p) {
 		struct mm_struct *mm;
-		int oom_adj;
+		int oom_adj, tasksize;
 
 		task_lock(p);
 		mm = p->mm;
@@ -108,8 +187,8 @@ static int lowmem_shrink(int nr_to_scan, gfp_t gfp_mask)
 			task_unlock(p);
 			continue;
 		}
-		oom_adj = mm->oom_adj;
-		if (oom_adj < min_adj) {
+		oom_adj = p->signal->oom_adj;
+		if (oom_adj < lowmem_adj[0]) {
 			task_unlock(p);
 			continue;
 		}
@@ -117,29 +196,167 @@ static int lowmem_shrink(int nr_to_scan, gfp_t gfp_mask)
 		task_unlock(p);
 		if (tasksize <= 0)
 			continue;
-		if (selected) {
-			if (oom_adj < selected_oom_adj)
+
+		/* insertion into the sorted list, the worst one falls off */
+		for (i = n; i > 0; i--) {
+			if (!lowmem_better(oom_adj, tasksize,
+					   &lowmem_candidates[i - 1]))
+				break;
+			if (i < LOWMEM_CANDIDATES)
+				lowmem_candidates[i] = lowmem_candidates[i - 1];
+		}
+		if (i == LOWMEM_CANDIDATES)
+			continue;
+		lowmem_candidates[i].task = p;
+		lowmem_candidates[i].oom_adj = oom_adj;
+		lowmem_candidates[i].tasksize = tasksize;
+		if (n < LOWMEM_CANDIDATES)
+			n++;
+	}
+
+	for (i = 0; i < n; i++)
+		get_task_struct(lowmem_candidates[i].task);
+	lowmem_ncandidates = n;
+	lowmem_candidates_gen = atomic_read(&oom_adj_generation);
+	lowmem_candidates_expires = jiffies + LOWMEM_REBUILD_INTERVAL;
+	lowmem_print(4, "lowmem rebuilt %d candidates\n", n);
+}
+
+/*
+ * Pick the task to kill among the candidates, with the oom_adj and size
+ * they have now. The list is rebuilt if it is stale, or if none of its
+ * tasks can be killed any more. Called with tasklist_lock held for
+ * reading, so a task with a sighand has not been released yet.
+ */
+static struct task_struct *lowmem_select(int min_adj, int *selected_oom_adj,
+					 int *selected_tasksize)
+{
+	struct task_struct *selected = NULL;
+	int i, rebuilt = 0;
+
+	if (lowmem_candidates_gen != atomic_read(&oom_adj_generation) ||
+	    time_after(jiffies, lowmem_candidates_expires)) {
+		lowmem_rebuild_candidates();
+		rebuilt = 1;
+	}
+
+	for (;;) {
+		for (i = 0; i < lowmem_ncandidates; i++) {
+			struct task_struct *p = lowmem_candidates[i].task;
+			int oom_adj, tasksize;
+
+			if (!p->sighand || (p->flags & PF_EXITING))
 				continue;
-			if (oom_adj == selected_oom_adj &&
-			    tasksize <= selected_tasksize)
+			task_lock(p);
+			if (!p->mm) {
+				task_unlock(p);
 				continue;
+			}
+			oom_adj = p->signal->oom_adj;
+			tasksize = get_mm_rss(p->mm);
+			task_unlock(p);
+			if (oom_adj < min_adj || tasksize <= 0)
+				continue;
+			if (selected) {
+				if (oom_adj < *selected_oom_adj)
+					continue;
+				if (oom_adj == *selected_oom_adj &&
+				    tasksize <= *selected_tasksize)
+					continue;
+			}
+			selected = p;
+			*selected_tasksize = tasksize;
+			*selected_oom_adj = oom_adj;
+			lowmem_print(2, "select %d (%s), adj %d, size %d, to kill\n",
+				     p->pid, p->comm, oom_adj, tasksize);
 		}
-		selected = p;
-		selected_tasksize = tasksize;
-		selected_oom_adj = oom_adj;
-		lowmem_print(2, "select %d (%s), adj %d, size %d, to kill\n",
-			     p->pid, p->comm, oom_adj, tasksize);
+		if (selected || rebuilt)
+			return selected;
+		lowmem_rebuild_candidates();
+		rebuilt = 1;
 	}
+}
+
+static int lowmem_shrink(int nr_to_scan, gfp_t gfp_mask)
+{
+	struct task_struct *selected;
+	ktime_t start = ktime_get();
+	int rem = 0;
+	int i;
+	int reason = 0;
+	int min_adj = OOM_ADJUST_MAX + 1;
+	int selected_tasksize = 0;
+	int selected_oom_adj = 0;
+	int array_size = ARRAY_SIZE(lowmem_adj);
+	int other_free = global_page_state(NR_FREE_PAGES) - totalreserve_pages;
+	int other_file = global_page_state(NR_FILE_PAGES);
+
+	rem = global_page_state(NR_ACTIVE_ANON) +
+		global_page_state(NR_ACTIVE_FILE) +
+		global_page_state(NR_INACTIVE_ANON) +
+		global_page_state(NR_INACTIVE_FILE);
+	if (nr_to_scan <= 0) {
+		lowmem_print(5, "lowmem_shrink %d, %x, return %d\n",
+			     nr_to_scan, gfp_mask, rem);
+		return rem;
+	}
+
+	/*
+	 * The last task we killed is still exiting, give its memory the
+	 * time to come back before killing the next one.
+	 */
+	if (lowmem_deathpending &&
+	    time_before_eq(jiffies, lowmem_deathpending_timeout))
+		return rem;
+	if (!mutex_trylock(&lowmem_lock))
+		return rem;
+
+	lowmem_update_efficiency();
+	if (lowmem_adj_size < array_size)
+		array_size = lowmem_adj_size;
+	if (lowmem_minfree_size < array_size)
+		array_size = lowmem_minfree_size;
+	for (i = 0; i < array_size; i++) {
+		if (other_free >= (int)lowmem_minfree[i])
+			continue;
+		if (other_file < lowmem_minfree[i]) {
+			min_adj = lowmem_adj[i];
+			break;
+		}
+		if (100 - lowmem_efficiency >= lowmem_reclaim_level &&
+		    lowmem_adj[i] >= lowmem_reclaim_min_adj) {
+			min_adj = lowmem_adj[i];
+			reason = 1;
+			break;
+		}
+	}
+	lowmem_print(3, "lowmem_shrink %d, %x, ofree %d %d, eff %d, ma %d\n",
+		     nr_to_scan, gfp_mask, other_free, other_file,
+		     lowmem_efficiency, min_adj);
+	if (min_adj == OOM_ADJUST_MAX + 1)
+		goto out;
+
+	read_lock(&tasklist_lock);
+	selected = lowmem_select(min_adj, &selected_oom_adj,
+				 &selected_tasksize);
 	if (selected) {
 		lowmem_print(1, "send sigkill to %d (%s), adj %d, size %d\n",
 			     selected->pid, selected->comm,
 			     selected_oom_adj, selected_tasksize);
+		lowmem_deathpending = selected;
+		lowmem_deathpending_timeout = jiffies + HZ;
 		force_sig(SIGKILL, selected);
+		trace_lowmem_kill(selected, selected_oom_adj,
+				  selected_tasksize, min_adj, reason,
+				  other_free, other_file, lowmem_efficiency,
+				  ktime_to_ns(ktime_sub(ktime_get(), start)));
 		rem -= selected_tasksize;
 	}
+	read_unlock(&tasklist_lock);
+out:
+	mutex_unlock(&lowmem_lock);
 	lowmem_print(4, "lowmem_shrink %d, %x, return %d\n",
 		     nr_to_scan, gfp_mask, rem);
-	read_unlock(&tasklist_lock);
 	return rem;
 }
 
@@ -150,13 +367,20 @@ static struct shrinker lowmem_shrinker = {
 
 static int __init lowmem_init(void)
 {
+	profile_event_register(PROFILE_TASK_EXIT, &task_nb);
 	register_shrinker(&lowmem_shrinker);
 	return 0;
 }
 
 static void __exit lowmem_exit(void)
 {
+	int i;
+
 	unregister_shrinker(&lowmem_shrinker);
+	profile_event_unregister(PROFILE_TASK_EXIT, &task_nb);
+	for (i = 0; i < lowmem_ncandidates; i++)
+		put_task_struct(lowmem_candidates[i].task);
+	lowmem_ncandidates = 0;
 }
 
 module_param_named(cost, lowmem_shrinker.seeks, int, S_IRUGO | S_IWUSR);
@@ -165,9 +389,12 @@ module_param_array_named(adj, lowmem_adj, int, &lowmem_adj_size,
 module_param_array_named(minfree, lowmem_minfree, uint, &lowmem_minfree_size,
 			 S_IRUGO | S_IWUSR);
 module_param_named(debug_level, lowmem_debug_level, uint, S_IRUGO | S_IWUSR);
+module_param_named(reclaim_level, lowmem_reclaim_level, uint,
+		   S_IRUGO | S_IWUSR);
+module_param_named(reclaim_min_adj, lowmem_reclaim_min_adj, int,
+		   S_IRUGO | S_IWUSR);
 
 module_init(lowmem_init);
 module_exit(lowmem_exit);
 
 MODULE_LICENSE("GPL");
-
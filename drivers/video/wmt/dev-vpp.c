@@ -52,6 +52,8 @@
 #include <linux/i2c.h>
 #include <linux/sysctl.h>
 #include <linux/delay.h>
+#include <linux/slab.h>
+#include <asm/cacheflush.h>
 
 #include "vpp.h"
 #include "govrh.h"
@@ -4202,3 +4204,113 @@ int vpp_pan_display(struct fb_var_screeninfo *var, struct fb_info *info,int enab
 	return 0;
 }
 
+#ifdef WMT_FTBLK_GOVRH_CURSOR
+#define VPP_CURSOR_MAX	64
+static unsigned int *vpp_cursor_buf;
+/*!*************************************************************************
+* vpp_set_cursor()
+* 
+* Private Function
+*/
+/*!
+* \brief	fb_cursor by GOVRH hardware cursor, so console and UI don't
+*		have to redraw the frame buffer when the cursor moves.
+*		
+* \retval  0 if success, else caller should draw soft cursor
+*/ 
+int vpp_set_cursor(struct fb_info *info, struct fb_cursor *cursor)
+{
+	struct fb_image *image = &cursor->image;
+	unsigned int set = cursor->set;
+	int x,y;
+
+	if( (image->width > VPP_CURSOR_MAX) || (image->height > VPP_CURSOR_MAX) )
+		return -ENXIO;
+
+	if( vpp_cursor_buf == 0 ){
+		/* may come from console printk, so no sleep */
+		vpp_cursor_buf = kzalloc(VPP_CURSOR_MAX*VPP_CURSOR_MAX*4*2,GFP_ATOMIC);
+		if( vpp_cursor_buf == 0 )
+			return -ENOMEM;
+		p_cursor->cursor_addr2 = virt_to_phys(vpp_cursor_buf + VPP_CURSOR_MAX*VPP_CURSOR_MAX);
+		set |= FB_CUR_SETALL;
+	}
+
+	if( set & (FB_CUR_SETIMAGE | FB_CUR_SETSHAPE | FB_CUR_SETCMAP | FB_CUR_SETSIZE) ){
+		vdo_framebuf_t *fb = &p_cursor->fb_p->fb;
+		unsigned int fg,bg,pixel;
+		const u8 *data = (const u8 *) image->data;
+		const u8 *mask = (const u8 *) cursor->mask;
+		int pitch = (image->width + 7) >> 3;
+		int i,bit,on;
+
+		fg = (info->cmap.red[image->fg_color] & 0xFF00) << 8;
+		fg |= (info->cmap.green[image->fg_color] & 0xFF00);
+		fg |= (info->cmap.blue[image->fg_color] >> 8);
+		bg = (info->cmap.red[image->bg_color] & 0xFF00) << 8;
+		bg |= (info->cmap.green[image->bg_color] & 0xFF00);
+		bg |= (info->cmap.blue[image->bg_color] >> 8);
+
+		memset(vpp_cursor_buf,0,VPP_CURSOR_MAX*VPP_CURSOR_MAX*4);
+		for(y=0;y<image->height;y++){
+			for(x=0;x<image->width;x++){
+				i = y * pitch + (x >> 3);
+				bit = 0x80 >> (x & 0x7);
+				if( !(mask[i] & bit) )
+					continue;	/* transparent, matches color key 0 */
+				on = (cursor->rop == ROP_XOR)? ((data[i] ^ mask[i]) & bit):(data[i] & bit);
+				pixel = 0xFF000000 | ((on)? fg:bg);
+				vpp_cursor_buf[y * VPP_CURSOR_MAX + x] = pixel;
+			}
+		}
+
+		fb->y_addr = virt_to_phys(vpp_cursor_buf);
+		fb->c_addr = 0;
+		fb->col_fmt = VDO_COL_FMT_ARGB;
+		fb->img_w = image->width;
+		fb->img_h = image->height;
+		fb->fb_w = VPP_CURSOR_MAX;
+		fb->fb_h = VPP_CURSOR_MAX;
+		fb->h_crop = 0;
+		fb->v_crop = 0;
+		fb->flag = 0;
+		x = p_cursor->posx;
+		y = p_cursor->posy;
+		govrh_CUR_set_framebuffer_nosync(fb);
+		govrh_CUR_set_color_key(VPP_FLAG_ENABLE,0,0x0);
+		/* color key writes the converted copy at cursor_addr2, clean after it.
+		   Only the two cursor buffers need cleaning, not the whole cache */
+		dmac_clean_range(vpp_cursor_buf,vpp_cursor_buf + VPP_CURSOR_MAX*VPP_CURSOR_MAX*2);
+		p_cursor->posx = x;
+		p_cursor->posy = y;
+		p_cursor->hotspot_x = cursor->hot.x;
+		p_cursor->hotspot_y = cursor->hot.y;
+		set |= FB_CUR_SETPOS;
+	}
+
+	if( set & FB_CUR_SETHOT ){
+		p_cursor->hotspot_x = cursor->hot.x;
+		p_cursor->hotspot_y = cursor->hot.y;
+	}
+
+	if( set & (FB_CUR_SETPOS | FB_CUR_SETHOT) ){
+		x = image->dx - info->var.xoffset;
+		y = image->dy - info->var.yoffset;
+		p_cursor->posx = (x < 0)? 0:x;
+		p_cursor->posy = (y < 0)? 0:y;
+		if( vppm_get_int_enable(VPP_INT_GOVRH_PVBI) )
+			p_cursor->chg_flag = 1;		/* update in next pvbi */
+		else
+			govrh_irqproc_set_position(0);
+	}
+
+	govrh_CUR_set_enable((cursor->enable)? VPP_FLAG_ENABLE:VPP_FLAG_DISABLE);
+	return 0;
+} /* End of vpp_set_cursor */
+#else
+int vpp_set_cursor(struct fb_info *info, struct fb_cursor *cursor)
+{
+	return -ENXIO;
+}
+#endif
+
@@ -40,6 +40,11 @@
 
 #define EDID_LENGTH                             0x80
 
+/* Monitor identity for EDID cache: 0x08-0x11 and 0x7E-0x7F of block 0 */
+#define EDID_ID_OFFSET		0x08
+#define EDID_ID_LEN		10
+#define EDID_ID_SIZE		(EDID_ID_LEN+2)
+
 /*------------------------------------------------------------------------------
   Offset 00-19: HEADER INFORMATION
 ------------------------------------------------------------------------------*/
@@ -130,6 +135,7 @@ extern int edid_find_support(unsigned int resx,unsigned int resy,int freq);
 extern int edid_find_support_vic(char vic);
 extern void edid_dump(unsigned char *edid);
 extern int edid_parse_option(unsigned char *edid);
+extern int edid_cache_get(unsigned char *id,unsigned char *edid);
 
 #endif
 
@@ -107,6 +107,20 @@ unsigned int fb_egl_swap = 0;
 
 static int allow_pan_display;
 
+/*
+ * Damage (dirty rectangle) tracking
+ *
+ * Userspace reports what it has redrawn with GEIO_DAMAGE. Reports are
+ * merged into one bounding box until the next GEIO_ROTATE consumes it,
+ * so a mostly static UI only pays GE bandwidth for what changed.
+ * No damage pending means the whole frame is rotated, as before.
+ */
+static DEFINE_SPINLOCK(ge_damage_lock);
+static struct {
+	unsigned int x1, y1, x2, y2;	/* x2, y2 are exclusive */
+	int valid;
+} ge_damage;
+
 /**************************
  *    Export functions    *
  **************************/
@@ -357,6 +371,67 @@ static int get_args(unsigned int *to, void *from, int num)
 	return 0;
 }
 
+/**
+ * ge_add_damage - Merge a dirty rectangle into the pending damage.
+ *
+ * Returns -EINVAL if the rectangle wraps around.
+ */
+static int ge_add_damage(unsigned int x, unsigned int y,
+	unsigned int w, unsigned int h)
+{
+	unsigned long flags;
+
+	if (w > UINT_MAX - x || h > UINT_MAX - y)
+		return -EINVAL;
+	if (!w || !h)
+		return 0;
+
+	spin_lock_irqsave(&ge_damage_lock, flags);
+	if (!ge_damage.valid) {
+		ge_damage.x1 = x;
+		ge_damage.y1 = y;
+		ge_damage.x2 = x + w;
+		ge_damage.y2 = y + h;
+		ge_damage.valid = 1;
+	} else {
+		ge_damage.x1 = min(ge_damage.x1, x);
+		ge_damage.y1 = min(ge_damage.y1, y);
+		ge_damage.x2 = max(ge_damage.x2, x + w);
+		ge_damage.y2 = max(ge_damage.y2, y + h);
+	}
+	spin_unlock_irqrestore(&ge_damage_lock, flags);
+
+	return 0;
+}
+
+/**
+ * ge_take_damage - Fetch and clear the pending damage.
+ *
+ * The rectangle is clipped to width x height. If nothing is pending, or
+ * the damage is empty after clipping, the whole area is returned.
+ */
+static void ge_take_damage(unsigned int width, unsigned int height,
+	unsigned int *rect)
+{
+	unsigned long flags;
+
+	rect[0] = 0;
+	rect[1] = 0;
+	rect[2] = width;
+	rect[3] = height;
+
+	spin_lock_irqsave(&ge_damage_lock, flags);
+	if (ge_damage.valid && ge_damage.x1 < width && ge_damage.y1 < height &&
+	    ge_damage.x2 > ge_damage.x1 && ge_damage.y2 > ge_damage.y1) {
+		rect[0] = ge_damage.x1;
+		rect[1] = ge_damage.y1;
+		rect[2] = min_t(unsigned int, ge_damage.x2, width) - rect[0];
+		rect[3] = min_t(unsigned int, ge_damage.y2, height) - rect[1];
+	}
+	ge_damage.valid = 0;
+	spin_unlock_irqrestore(&ge_damage_lock, flags);
+}
+
 /**
  * ge_ioctl - Extension for fbdev ioctl.
  *
@@ -369,7 +444,7 @@ int ge_ioctl(struct fb_info *info, unsigned int cmd, unsigned long arg)
 	volatile struct ge_regs_8430 *regs;
 	int ret = 0;
 	unsigned int chip_id;
-	unsigned int args[8];
+	unsigned int args[10];
 
 	regs = geinfo->mmio;
 
@@ -420,10 +495,17 @@ int ge_ioctl(struct fb_info *info, unsigned int cmd, unsigned long arg)
 	case GEIO_ROTATE:
 		ret = get_args(args, (void *) arg, 6);
 		if (ret == 0) {
-			ge_simple_rotate(args[0], args[1], args[2], args[3],
-					 args[4], args[5]);
+			ge_take_damage(args[2], args[3], &args[6]);
+			ge_partial_rotate(args[0], args[1], args[2], args[3],
+					  args[4], args[5], &args[6]);
 		}
 		break;
+	case GEIO_DAMAGE:
+		/* args: x, y, width, height */
+		ret = get_args(args, (void *) arg, 4);
+		if (ret == 0)
+			ret = ge_add_damage(args[0], args[1], args[2], args[3]);
+		break;
 #ifdef CONFIG_LOGO_WMT_ANIMATION
 	case GEIO_STOP_LOGO:
 		printk("GEIO_STOP_LOGO\n");
@@ -734,6 +816,23 @@ void ge_set_amx_colorkey(unsigned int color, int erase)
 
 void ge_simple_rotate(unsigned int phy_src, unsigned int phy_dst,
 	int width, int height, int bpp, int arc)
+{
+	unsigned int rect[4] = { 0, 0, width, height };
+
+	ge_partial_rotate(phy_src, phy_dst, width, height, bpp, arc, rect);
+}
+
+/**
+ * ge_partial_rotate - Rotate only a rectangle of a width x height surface.
+ *
+ * @rect: x, y, width, height in source coordinates.
+ *
+ * The destination rectangle is where the source rectangle lands after
+ * a clockwise rotation of the whole surface, so the rest of the
+ * destination is left untouched.
+ */
+void ge_partial_rotate(unsigned int phy_src, unsigned int phy_dst,
+	int width, int height, int bpp, int arc, unsigned int *rect)
 {
 	volatile struct ge_regs_8430 *regs;
 	ge_surface_t s, d;
@@ -744,7 +843,7 @@ void ge_simple_rotate(unsigned int phy_src, unsigned int phy_dst,
 	regs = geinfo->mmio;
 
 	if (arc == 0) {
-		ge_simple_blit(phy_src, phy_dst, width, height, bpp);
+		ge_partial_blit(phy_src, phy_dst, width, height, bpp, rect);
 		return;
 	}
 
@@ -767,28 +866,45 @@ void ge_simple_rotate(unsigned int phy_src, unsigned int phy_dst,
 	}
 
 	s.addr = phy_src;
-	s.x = 0;
-	s.y = 0;
-	s.xres = width;
-	s.yres = height;
+	s.x = rect[0];
+	s.y = rect[1];
+	s.xres = rect[2];
+	s.yres = rect[3];
 	s.xres_virtual = width;
 	s.yres_virtual = height;
 
 	d.addr = phy_dst;
-	d.x = 0;
-	d.y = 0;
 
 	switch (arc) {
 	case 90:
+		d.x = height - rect[1] - rect[3];
+		d.y = rect[0];
+		d.xres = rect[3];
+		d.yres = rect[2];
+		d.xres_virtual = height;
+		d.yres_virtual = width;
+		break;
 	case 270:
-		d.xres = height;
-		d.yres = width;
+		d.x = rect[1];
+		d.y = width - rect[0] - rect[2];
+		d.xres = rect[3];
+		d.yres = rect[2];
 		d.xres_virtual = height;
 		d.yres_virtual = width;
 		break;
+	case 180:
+		d.x = width - rect[0] - rect[2];
+		d.y = height - rect[1] - rect[3];
+		d.xres = rect[2];
+		d.yres = rect[3];
+		d.xres_virtual = width;
+		d.yres_virtual = height;
+		break;
 	default:
-		d.xres = width;
-		d.yres = height;
+		d.x = rect[0];
+		d.y = rect[1];
+		d.xres = rect[2];
+		d.yres = rect[3];
 		d.xres_virtual = width;
 		d.yres_virtual = height;
 		break;
@@ -836,6 +952,14 @@ void ge_simple_rotate(unsigned int phy_src, unsigned int phy_dst,
 
 void ge_simple_blit(unsigned int phy_src, unsigned int phy_dst,
 	int width, int height, int bpp)
+{
+	unsigned int rect[4] = { 0, 0, width, height };
+
+	ge_partial_blit(phy_src, phy_dst, width, height, bpp, rect);
+}
+
+void ge_partial_blit(unsigned int phy_src, unsigned int phy_dst,
+	int width, int height, int bpp, unsigned int *rect)
 {
 	ge_surface_t s, d;
 
@@ -858,20 +982,15 @@ void ge_simple_blit(unsigned int phy_src, unsigned int phy_dst,
 	}
 
 	s.addr = phy_src;
-	s.x = 0;
-	s.y = 0;
-	s.xres = width;
-	s.yres = height;
+	s.x = rect[0];
+	s.y = rect[1];
+	s.xres = rect[2];
+	s.yres = rect[3];
 	s.xres_virtual = width;
 	s.yres_virtual = height;
 
+	d = s;
 	d.addr = phy_dst;
-	d.x = 0;
-	d.y = 0;
-	d.xres = width;
-	d.yres = height;
-	d.xres_virtual = width;
-	d.yres_virtual = height;
 
 	/* Blit */
 	ge_lock(geinfo);
@@ -58,10 +58,15 @@ void ge_simple_rotate(unsigned int phy_src, unsigned int phy_dst,
 	int width, int height, int bpp, int arc);
 void ge_simple_blit(unsigned int phy_src, unsigned int phy_dst,
 	int width, int height, int bpp);
+void ge_partial_rotate(unsigned int phy_src, unsigned int phy_dst,
+	int width, int height, int bpp, int arc, unsigned int *rect);
+void ge_partial_blit(unsigned int phy_src, unsigned int phy_dst,
+	int width, int height, int bpp, unsigned int *rect);
 int wait_vsync(void);
 extern void vpp_wait_vsync(void);
 extern void vpp_get_info(struct fb_var_screeninfo *var);
 extern int vpp_pan_display(struct fb_var_screeninfo *var, struct fb_info *info,int enable);
+extern int vpp_set_cursor(struct fb_info *info, struct fb_cursor *cursor);
 extern unsigned long msleep_interruptible(unsigned int msecs);
 #ifdef CONFIG_LOGO_WMT_ANIMATION
 extern int wmt_getsyspara(char *varname, unsigned char *varval, int *varlen);
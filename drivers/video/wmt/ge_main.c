@@ -275,7 +275,8 @@ static int gefb_ioctl(struct fb_info *info, unsigned int cmd,
 
 int gefb_hw_cursor(struct fb_info *info, struct fb_cursor *cursor)
 {
-	return 0;
+	/* Nonzero lets fbcon fall back to the soft cursor */
+	return vpp_set_cursor(info, cursor);
 }
 
 int gefb_sync(struct fb_info *info)
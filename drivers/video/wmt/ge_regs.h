@@ -117,6 +117,7 @@
 #define GEIO_LOCK		_IO(GEIO_MAGIC, 15)
 #define GEIO_STOP_LOGO		_IO(GEIO_MAGIC, 18)
 #define GEIO_ALLOW_PAN_DISPLAY	_IO(GEIO_MAGIC, 19)
+#define GEIO_DAMAGE		_IOW(GEIO_MAGIC, 20, void *)
 #endif
 
 #if defined(__KERNEL__) || defined(__POST__)
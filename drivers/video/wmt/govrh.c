@@ -128,11 +128,23 @@ vpp_flag_t govrh_set_tg_enable(vpp_flag_t enable)
 
 unsigned int govrh_set_clock(unsigned int pixel_clock)
 {
+	static unsigned int pre_pixel_clock;
+	static int pre_pmc_clk;
 	int pmc_clk;
 
+	/* PLL search is slow, skip if PLL still gives the clock set last time */
+	if( (pixel_clock == pre_pixel_clock) && (pre_pmc_clk > 0) ){
+		if( auto_pll_divisor(DEV_DVO,CLK_ENABLE,0,0) == pre_pmc_clk ){
+			DBGMSG("[GOVRH] keep clock %d\n",pre_pmc_clk);
+			return 0;
+		}
+	}
+
 	DPRINT("[GOVRH] set clock %d\n",pixel_clock);
 	pmc_clk = auto_pll_divisor(DEV_DVO,SET_PLLDIV,0,pixel_clock);
 	DPRINT("[GOVRH] set clock %d --> %d\n",pixel_clock,pmc_clk);
+	pre_pixel_clock = pixel_clock;
+	pre_pmc_clk = pmc_clk;
 	return 0;
 }
 
@@ -1008,7 +1020,7 @@ void govrh_CUR_proc_view(int read,vdo_view_t *view)
 	}
 }
 
-void govrh_CUR_set_framebuffer(vdo_framebuf_t *fb)
+static void govrh_CUR_load_framebuffer(vdo_framebuf_t *fb,int sync)
 {
 //	DPRINT("[CUR] govrh_CUR_set_framebuffer\n");
 
@@ -1028,11 +1040,23 @@ void govrh_CUR_set_framebuffer(vdo_framebuf_t *fb)
 	if( p_cursor->cursor_addr2 == 0 ){
 		p_cursor->cursor_addr2 = (unsigned int) virt_to_phys((void *)mb_allocate(64*64*4));
 	}
-	vpp_cache_sync();
+	if( sync )
+		vpp_cache_sync();
 	govrh_CUR_set_color_key(0,0,0x0);
 	govrh_CUR_set_colfmt(p_govrh->fb_p->fb.col_fmt);
 }
 
+void govrh_CUR_set_framebuffer(vdo_framebuf_t *fb)
+{
+	govrh_CUR_load_framebuffer(fb,1);
+}
+
+/* Caller has cleaned the cursor buffer from the D-cache already */
+void govrh_CUR_set_framebuffer_nosync(vdo_framebuf_t *fb)
+{
+	govrh_CUR_load_framebuffer(fb,0);
+}
+
 void govrh_CUR_init(void *base)
 {
 
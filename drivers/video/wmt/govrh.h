@@ -120,6 +120,7 @@ EXTERN int govrh_mod_init(void);
 #ifdef WMT_FTBLK_GOVRH_CURSOR
 EXTERN void govrh_CUR_set_enable(vpp_flag_t enable);
 EXTERN void govrh_CUR_set_framebuffer(vdo_framebuf_t *fb);
+EXTERN void govrh_CUR_set_framebuffer_nosync(vdo_framebuf_t *fb);
 EXTERN void govrh_CUR_set_coordinate(unsigned int x1,unsigned int y1,unsigned int x2,unsigned int y2);
 EXTERN void govrh_CUR_set_position(unsigned int x,unsigned int y);
 EXTERN void govrh_CUR_set_color_key(int enable,int alpha,unsigned int colkey);
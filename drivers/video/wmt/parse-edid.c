@@ -63,6 +63,23 @@ edid_timing_t edid_establish_timing[] = {
 };
 edid_info_t edid_info;
 
+/*------------------------------------------------------------------------------
+    EDID cache. A monitor is identified by vendor, product, serial and date 
+    (0x08-0x11) plus extension count and checksum of block 0 (0x7E-0x7F), so
+    a known monitor needs neither full DDC read nor parse when plug again.
+------------------------------------------------------------------------------*/
+#define EDID_CACHE_NUM		4
+
+typedef struct {
+	unsigned char id[EDID_ID_SIZE];
+	unsigned char edid[EDID_LENGTH*EDID_BLOCK_MAX];
+	edid_info_t info;
+	unsigned int age;
+} edid_cache_t;
+
+static edid_cache_t edid_cache[EDID_CACHE_NUM];
+static unsigned int edid_cache_age;
+
 static int block_type( unsigned char * block )
 {
     if ( !memcmp( edid_v1_descriptor_flag, block, 2 ) ) {
@@ -540,27 +557,111 @@ int edid_parse_CEA(unsigned char *edid)
 	return 0;
 }
 
+static void edid_get_id(unsigned char *edid,unsigned char *id)
+{
+	memcpy(id,&edid[EDID_ID_OFFSET],EDID_ID_LEN);
+	id[EDID_ID_LEN] = edid[0x7E];
+	id[EDID_ID_LEN+1] = edid[0x7F];
+}
+
+static edid_cache_t *edid_cache_find(unsigned char *id)
+{
+	int i;
+
+	for(i=0;i<EDID_CACHE_NUM;i++){
+		if( edid_cache[i].age == 0 )
+			continue;
+		if( memcmp(edid_cache[i].id,id,EDID_ID_SIZE) == 0 ){
+			edid_cache[i].age = ++edid_cache_age;
+			return &edid_cache[i];
+		}
+	}
+	return 0;
+}
+
+static int edid_cache_size(unsigned char *edid)
+{
+	int ext_cnt = edid[0x7E];
+
+	if( ext_cnt > (EDID_BLOCK_MAX-1) )
+		ext_cnt = EDID_BLOCK_MAX-1;
+	return (ext_cnt + 1) * EDID_LENGTH;
+}
+
+static void edid_cache_add(unsigned char *edid)
+{
+	edid_cache_t *entry;
+	int i;
+
+	entry = &edid_cache[0];
+	for(i=1;i<EDID_CACHE_NUM;i++){	/* replace least recently used */
+		if( edid_cache[i].age < entry->age )
+			entry = &edid_cache[i];
+	}
+	edid_get_id(edid,entry->id);
+	memcpy(entry->edid,edid,edid_cache_size(edid));
+	entry->info = edid_info;
+	entry->age = ++edid_cache_age;
+}
+
+/*!*************************************************************************
+* edid_cache_get()
+* 
+* Private Function
+*/
+/*!
+* \brief	Get raw EDID of a known monitor
+*		
+* \retval  0 - found and copy to edid, -1 - not found
+*/ 
+int edid_cache_get(unsigned char *id,unsigned char *edid)
+{
+	edid_cache_t *entry;
+
+	if( (entry = edid_cache_find(id)) == 0 )
+		return -1;
+
+	memcpy(edid,entry->edid,edid_cache_size(entry->edid));
+	DBGMSG("[EDID] cache hit\n");
+	return 0;
+}
+
 int edid_parse(unsigned char *edid)
 {
+	edid_cache_t *entry;
+	unsigned char id[EDID_ID_SIZE];
+	unsigned char *block;
 	int ext_cnt = 0;
 
 	if( edid == 0 )
 		return 0;
 
-	if( edid_parse_v1(edid) == 0 ){
-		ext_cnt = edid[0x7E];
+	edid_get_id(edid,id);
+	if( (entry = edid_cache_find(id)) ){
+		if( memcmp(entry->edid,edid,edid_cache_size(edid)) == 0 ){
+			edid_info = entry->info;
+			return 0;
+		}
+		entry->age = 0;		/* same id but content changed */
 	}
 
+	if( edid_parse_v1(edid) != 0 ){
+		return 0;			/* don't cache broken EDID */
+	}
+	ext_cnt = (edid_cache_size(edid) / EDID_LENGTH) - 1;
+
+	block = edid;
 	while( ext_cnt ){
-		edid += 128;
+		block += 128;
 		ext_cnt--;
-		if( edid_parse_CEA(edid) == 0 ){
+		if( edid_parse_CEA(block) == 0 ){
 			continue;
 		}
 		
 		DPRINT("*W* not support EDID\n");
-		edid_dump(edid);
+		edid_dump(block);
 	}
+	edid_cache_add(edid);
 	return 0;
 }
 
@@ -102,6 +102,70 @@ swi2c_handle_t vo_swi2c_dvi = {
 extern int wmt_getsyspara(char *varname, unsigned char *varval, int *varlen);
 extern void hdmi_config_audio(vout_audio_t *info);
 
+#ifdef CONFIG_WMT_EDID
+int vo_ddc_hw;		/* VGA DDC on I2C0 pads, read by I2C0 controller */
+
+static int vo_ddc_read(swi2c_handle_t *handle,int index,char *buf,int len)
+{
+#ifdef CONFIG_I2C_WMT
+	if( vo_ddc_hw && (handle == &vo_swi2c_vga) ){
+		/* give pads back to I2C0, one transfer per block instead of bit bang */
+		REG16_VAL(handle->scl_reg->gpio_en) &= ~handle->scl_reg->bit_mask;
+		REG16_VAL(handle->sda_reg->gpio_en) &= ~handle->sda_reg->bit_mask;
+		return vpp_i2c_read(0xA0,index,buf,len);
+	}
+#endif
+	return wmt_swi2c_read(handle,0xA0,index,buf,len);
+}
+
+static int vo_ddc_read_block(swi2c_handle_t *handle,int block,char *buf)
+{
+	if( block < 2 )
+		return vo_ddc_read(handle,block*128,buf,128);
+#ifdef CONFIG_I2C_WMT
+	/* blocks 2,3 are in E-DDC segment 1, only I2C0 can set the segment */
+	if( vo_ddc_hw && (handle == &vo_swi2c_vga) )
+		return vpp_i2c_enhanced_ddc_read(0xA0,(block & 0x1)*128,buf,128);
+#endif
+	/* not reachable by bit bang, an empty block is skipped by the parser */
+	memset(buf,0,128);
+	return 0;
+}
+
+/*!*************************************************************************
+* vo_ddc_get_edid()
+* 
+* Private Function
+*/
+/*!
+* \brief	Read EDID by DDC. Identify monitor first, a known monitor 
+*		takes 12 bytes from DDC instead of 256.
+*		
+* \retval  0 if success
+*/ 
+static int vo_ddc_get_edid(swi2c_handle_t *handle,char *buf)
+{
+	unsigned char id[EDID_ID_SIZE];
+	int i, ext_cnt;
+
+	if( vo_ddc_read(handle,EDID_ID_OFFSET,(char *)&id[0],EDID_ID_LEN) == 0 ){
+		if( vo_ddc_read(handle,0x7E,(char *)&id[EDID_ID_LEN],2) == 0 ){
+			if( edid_cache_get(id,(unsigned char *)buf) == 0 )
+				return 0;
+		}
+	}
+
+	if( vo_ddc_read_block(handle,0,&buf[0]) )
+		return -1;
+	ext_cnt = min((int)(unsigned char)buf[0x7E],EDID_BLOCK_MAX-1);
+	for(i=1;i<=ext_cnt;i++){
+		if( vo_ddc_read_block(handle,i,&buf[128*i]) )
+			return -1;
+	}
+	return 0;
+}
+#endif
+
 /*--------------------------------------- API ---------------------------------------*/
 int vo_i2c_proc(int id,unsigned int addr,unsigned int index,char *pdata,int len)
 {
@@ -459,17 +523,11 @@ int vo_vga_plug_detect(void)
 
 static int vo_vga_get_edid(int arg)
 {
-	char *buf;
-
-	buf = (char *) arg;
 #ifdef CONFIG_WMT_EDID
-	if( wmt_swi2c_read(&vo_swi2c_vga,0xA0,0,&buf[0],128) == 0 ){
-		if( buf[0x7E] ){
-			wmt_swi2c_read(&vo_swi2c_vga,0xA0,0,&buf[128],128)
-		}
-	}
-#endif
+	return vo_ddc_get_edid(&vo_swi2c_vga,(char *) arg);
+#else
 	return 0;
+#endif
 }
 
 vout_ops_t vo_vga_ops = 
@@ -621,17 +679,11 @@ static int vo_dvi_chkplug(int arg)
 
 static int vo_dvi_get_edid(int arg)
 {
-	char *buf;
-
-	buf = (char *) arg;
 #ifdef CONFIG_WMT_EDID
-	if( wmt_swi2c_read(&vo_swi2c_dvi,0xA0,0,&buf[0],128) == 0 ){
-		if( buf[0x7E] ){
-			wmt_swi2c_read(&vo_swi2c_dvi,0xA0,128,&buf[128],128)
-		}
-	}
-#endif
+	return vo_ddc_get_edid(&vo_swi2c_dvi,(char *) arg);
+#else
 	return 0;
+#endif
 }
 
 vout_ops_t vo_dvi_ops = 
@@ -2230,6 +2282,14 @@ int vout_init(struct fb_var_screeninfo *var)
 			DPRINT("user res %dx%d@%d\n",user_resx,user_resy,user_freq);
 		}
 
+#ifdef CONFIG_WMT_EDID
+		varlen = 40;
+		if( wmt_getsyspara("wmt.display.ddc_hw",buf,&varlen) == 0 ){
+			vo_ddc_hw = simple_strtoul(buf,0,10);
+			DPRINT("ddc by hw i2c %d\n",vo_ddc_hw);
+		}
+#endif
+
 		// detect plugin
 		sense_enable = vpp_dac_sense_enable;
 		vpp_dac_sense_enable = 0;
@@ -53,7 +53,12 @@
 #include <asm/io.h>
 #include <linux/proc_fs.h>
 
+/* report the register access of the vppif_xxx caller */
+#define VPPIF_TRACE(offset,val,flags)	wmt_mmio_trace(WMT_MMIO_VPP,offset,val,flags,_RET_IP_)
+
 #else
+#define VPPIF_TRACE(offset,val,flags)
+
 __inline__ U32 inl(U32 offset)
 {
 	return REG32_VAL(offset);
@@ -110,33 +115,45 @@ void mdelay(int ms)
 //Internal functions
 U8 vppif_reg8_in(U32 offset)
 {
-	return (inb(offset));
+	U8 val = inb(offset);
+
+	VPPIF_TRACE(offset,val,1);
+	return (val);
 }
 
 U8 vppif_reg8_out(U32 offset, U8 val)
 {
+	VPPIF_TRACE(offset,val,WMT_MMIO_WRITE | 1);
 	outb(val, offset);
 	return (val);
 }
 
 U16 vppif_reg16_in(U32 offset)
 {
-	return (inw(offset));
+	U16 val = inw(offset);
+
+	VPPIF_TRACE(offset,val,2);
+	return (val);
 }
 
 U16 vppif_reg16_out(U32 offset, U16 val)
 {
+	VPPIF_TRACE(offset,val,WMT_MMIO_WRITE | 2);
 	outw(val, offset);
 	return (val);
 }
 
 U32 vppif_reg32_in(U32 offset)
 {
-	return (inl(offset));
+	U32 val = inl(offset);
+
+	VPPIF_TRACE(offset,val,4);
+	return (val);
 }
 
 U32 vppif_reg32_out(U32 offset, U32 val)
 {
+	VPPIF_TRACE(offset,val,WMT_MMIO_WRITE | 4);
 	outl(val, offset);
 	return (val);
 }
@@ -152,13 +169,17 @@ U32 vppif_reg32_write(U32 offset, U32 mask, U32 shift, U32 val)
 #endif	
 
 	new_val = (inl(offset) & ~(mask)) | (((val) << (shift)) & mask);
+	VPPIF_TRACE(offset,new_val,WMT_MMIO_WRITE | 4);
 	outl(new_val, offset);
 	return (new_val);
 }
 
 U32 vppif_reg32_read(U32 offset, U32 mask, U32 shift)
 {
-	return ((inl(offset) & mask) >> shift);
+	U32 val = inl(offset);
+
+	VPPIF_TRACE(offset,val,4);
+	return ((val & mask) >> shift);
 }
 
 U32 vppif_reg32_mask(U32 offset, U32 mask, U32 shift)
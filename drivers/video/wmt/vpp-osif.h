@@ -60,12 +60,15 @@
 #include <linux/kernel.h>
 #include <linux/string.h>
 #include <linux/delay.h>
+#include <mach/wmt_mmio.h>
 #define DPRINT printk
 #else
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #define DPRINT printf
+#define wmt_mmio_seq_begin(name)	0
+#define wmt_mmio_seq_end(name,begin)
 #endif
 
 /*	following is the C++ header	*/
@@ -421,6 +421,17 @@ void vpp_trans_timing(vpp_mod_t mod,vpp_timing_t *tmr,vpp_clock_t *hw_tmr,int to
 	}
 }
 
+/* Results of vpp_calculate_timing(), the search is too slow for every mode set */
+#define VPP_TIMING_CACHE_NUM	4
+static struct {
+	vpp_mod_t mod;
+	unsigned int base_clock;
+	int porch[4];
+	vpp_clock_t in;
+	vpp_clock_t out;
+} vpp_timing_cache[VPP_TIMING_CACHE_NUM];
+static int vpp_timing_cache_cnt;
+
 void vpp_calculate_timing(vpp_mod_t mod,unsigned int fps,vpp_clock_t *tmr)
 {
 	unsigned int base_clock;
@@ -438,6 +449,26 @@ void vpp_calculate_timing(vpp_mod_t mod,unsigned int fps,vpp_clock_t *tmr)
 	vpixel = tmr->end_line_of_active - tmr->begin_line_of_active;
 
 	base_clock = vpp_get_base_clock(mod) / fps;
+	for(i=0;(i<vpp_timing_cache_cnt) && (i<VPP_TIMING_CACHE_NUM);i++){
+		if( (vpp_timing_cache[i].mod != mod) || (vpp_timing_cache[i].base_clock != base_clock) )
+			continue;
+		if( (vpp_timing_cache[i].porch[0] != g_vpp.govw_hfp) || (vpp_timing_cache[i].porch[1] != g_vpp.govw_hbp)
+			|| (vpp_timing_cache[i].porch[2] != g_vpp.govw_vfp) || (vpp_timing_cache[i].porch[3] != g_vpp.govw_vbp) )
+			continue;
+		if( memcmp(&vpp_timing_cache[i].in,tmr,sizeof(vpp_clock_t)) == 0 ){
+			*tmr = vpp_timing_cache[i].out;
+			goto timing_end;
+		}
+	}
+
+	i = vpp_timing_cache_cnt % VPP_TIMING_CACHE_NUM;
+	vpp_timing_cache[i].mod = mod;
+	vpp_timing_cache[i].base_clock = base_clock;
+	vpp_timing_cache[i].porch[0] = g_vpp.govw_hfp;
+	vpp_timing_cache[i].porch[1] = g_vpp.govw_hbp;
+	vpp_timing_cache[i].porch[2] = g_vpp.govw_vfp;
+	vpp_timing_cache[i].porch[3] = g_vpp.govw_vbp;
+	vpp_timing_cache[i].in = *tmr;
 	hbp_min = tmr->begin_pixel_of_active;
 	hfp_min = tmr->total_pixel_of_line - tmr->end_pixel_of_active;
 	hporch_min = hbp_min + hfp_min;
@@ -529,6 +560,11 @@ void vpp_calculate_timing(vpp_mod_t mod,unsigned int fps,vpp_clock_t *tmr)
 
 	tmr->line_number_between_VBIS_VBIE = tmr->begin_line_of_active - 3;
 
+	vpp_timing_cache[vpp_timing_cache_cnt % VPP_TIMING_CACHE_NUM].out = *tmr;
+	vpp_timing_cache_cnt++;
+
+timing_end:
+	DBGMSG("[VPP] timing rcyc %d,H %d,V %d\n",tmr->read_cycle,tmr->total_pixel_of_line,tmr->total_line_of_frame);
 #ifdef CONFIG_GOVW_FPS_AUTO_ADJUST
 	g_vpp.govw_tg_rcyc = tmr->read_cycle;
 	g_vpp.govw_tg_rtn_cnt = 0;
@@ -946,9 +982,12 @@ get_mode_end:
 void vpp_set_video_mode(unsigned int resx,unsigned int resy,unsigned int pixel_clock)
 {
 	vpp_timing_t *timing;
+	unsigned int ost;
 
+	ost = wmt_mmio_seq_begin("vpp_set_video_mode");
 	timing = vpp_get_video_mode(resx,resy,pixel_clock);
 	govrh_set_timing(timing);
+	wmt_mmio_seq_end("vpp_set_video_mode",ost);
 }
 
 void vpp_set_video_quality(int mode)
@@ -843,6 +843,7 @@ EXTERN int vpp_resume(void);
 EXTERN unsigned int *vpp_backup_reg(unsigned int addr,unsigned int size);
 EXTERN int vpp_restore_reg(unsigned int addr,unsigned int size,unsigned int *reg_ptr);
 EXTERN int vpp_pan_display(struct fb_var_screeninfo *var, struct fb_info *info,int enable);
+EXTERN int vpp_set_cursor(struct fb_info *info, struct fb_cursor *cursor);
 #endif
 
 EXTERN void vpp_show_fb(vdo_framebuf_t *fb);
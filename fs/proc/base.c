@@ -1054,6 +1054,7 @@ static ssize_t oom_adjust_write(struct file *file, const char __user *buf,
 	}
 
 	task->signal->oom_adj = oom_adjust;
+	atomic_inc(&oom_adj_generation);
 
 	unlock_task_sighand(task, &flags);
 	put_task_struct(task);
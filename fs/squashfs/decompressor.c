@@ -0,0 +1,212 @@
+/*
+ * Squashfs - a compressed read only filesystem for Linux
+ *
+ * Copyright (c) 2002, 2003, 2004, 2005, 2006, 2007, 2008
+ * Phillip Lougher <phillip@lougher.demon.co.uk>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * decompressor.c
+ */
+
+#include <linux/types.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/sched.h>
+#include <linux/buffer_head.h>
+
+#include "squashfs_fs.h"
+#include "squashfs_fs_sb.h"
+#include "squashfs_fs_i.h"
+#include "decompressor.h"
+#include "squashfs.h"
+
+/*
+ * This file (and decompressor.h) implements a decompressor framework for
+ * Squashfs, allowing multiple decompressors to be easily supported, and
+ * the pool of decompressor streams shared by the readers of a filesystem.
+ */
+
+static const struct squashfs_decompressor squashfs_lzma_unsupported_comp_ops = {
+	NULL, NULL, NULL, LZMA_COMPRESSION, "lzma", 0
+};
+
+static const struct squashfs_decompressor squashfs_lzo_unsupported_comp_ops = {
+	NULL, NULL, NULL, LZO_COMPRESSION, "lzo", 0
+};
+
+static const struct squashfs_decompressor squashfs_xz_unsupported_comp_ops = {
+	NULL, NULL, NULL, XZ_COMPRESSION, "xz", 0
+};
+
+static const struct squashfs_decompressor squashfs_unknown_comp_ops = {
+	NULL, NULL, NULL, 0, "unknown", 0
+};
+
+static const struct squashfs_decompressor *decompressor[] = {
+	&squashfs_zlib_comp_ops,
+#ifdef CONFIG_SQUASHFS_LZMA
+	&squashfs_lzma_comp_ops,
+#else
+	&squashfs_lzma_unsupported_comp_ops,
+#endif
+#ifdef CONFIG_SQUASHFS_LZO
+	&squashfs_lzo_comp_ops,
+#else
+	&squashfs_lzo_unsupported_comp_ops,
+#endif
+	&squashfs_xz_unsupported_comp_ops,
+	&squashfs_unknown_comp_ops
+};
+
+
+const struct squashfs_decompressor *squashfs_lookup_decompressor(int id)
+{
+	int i;
+
+	for (i = 0; decompressor[i]->id; i++)
+		if (id == decompressor[i]->id)
+			break;
+
+	return decompressor[i];
+}
+
+
+static struct squashfs_stream *squashfs_alloc_stream(
+	struct squashfs_sb_info *msblk)
+{
+	struct squashfs_stream *strm;
+
+	strm = kmalloc(sizeof(*strm), GFP_KERNEL);
+	if (strm == NULL)
+		return NULL;
+
+	strm->stream = msblk->decompressor->init(msblk);
+	if (strm->stream == NULL) {
+		kfree(strm);
+		return NULL;
+	}
+
+	return strm;
+}
+
+
+/*
+ * Set up the stream pool and allocate the first stream, so a filesystem
+ * which cannot be decompressed at all fails at mount time.
+ */
+int squashfs_decompressor_init(struct squashfs_sb_info *msblk)
+{
+	struct squashfs_stream *strm;
+
+	msblk->strm_max = SQUASHFS_DECOMP_STREAMS;
+
+	strm = squashfs_alloc_stream(msblk);
+	if (strm == NULL) {
+		ERROR("Failed to allocate %s decompressor\n",
+			msblk->decompressor->name);
+		return -ENOMEM;
+	}
+
+	list_add(&strm->list, &msblk->strm_list);
+	msblk->strm_count = 1;
+	return 0;
+}
+
+
+void squashfs_decompressor_free(struct squashfs_sb_info *msblk)
+{
+	struct squashfs_stream *strm, *next;
+
+	list_for_each_entry_safe(strm, next, &msblk->strm_list, list) {
+		list_del(&strm->list);
+		msblk->decompressor->free(strm->stream);
+		kfree(strm);
+	}
+	msblk->strm_count = 0;
+}
+
+
+/*
+ * Get an idle stream, allocating a new one if the filesystem has fewer
+ * than strm_max.  If all are busy (or allocation fails) wait for one to
+ * be released.
+ */
+static struct squashfs_stream *get_stream(struct squashfs_sb_info *msblk)
+{
+	struct squashfs_stream *strm;
+
+	spin_lock(&msblk->strm_lock);
+	while (list_empty(&msblk->strm_list)) {
+		if (msblk->strm_count < msblk->strm_max) {
+			msblk->strm_count++;
+			spin_unlock(&msblk->strm_lock);
+
+			strm = squashfs_alloc_stream(msblk);
+			if (strm)
+				return strm;
+
+			spin_lock(&msblk->strm_lock);
+			msblk->strm_count--;
+		}
+		spin_unlock(&msblk->strm_lock);
+
+		wait_event(msblk->strm_wait, !list_empty(&msblk->strm_list));
+
+		spin_lock(&msblk->strm_lock);
+	}
+
+	strm = list_entry(msblk->strm_list.next, struct squashfs_stream, list);
+	list_del(&strm->list);
+	spin_unlock(&msblk->strm_lock);
+
+	return strm;
+}
+
+
+static void put_stream(struct squashfs_sb_info *msblk,
+	struct squashfs_stream *strm)
+{
+	spin_lock(&msblk->strm_lock);
+	list_add(&strm->list, &msblk->strm_list);
+	spin_unlock(&msblk->strm_lock);
+
+	wake_up(&msblk->strm_wait);
+}
+
+
+/*
+ * Decompress length bytes, starting at offset in bh[0] and spread over
+ * the b buffer_heads (which must be up to date), into the pages of
+ * buffer.  Returns the decompressed length or -EIO.
+ */
+int squashfs_decompress(struct squashfs_sb_info *msblk, void **buffer,
+	struct buffer_head **bh, int b, int offset, int length, int srclength,
+	int pages)
+{
+	struct squashfs_stream *strm = get_stream(msblk);
+	int res;
+
+	res = msblk->decompressor->decompress(msblk, strm->stream, buffer, bh,
+		b, offset, length, srclength, pages);
+
+	put_stream(msblk, strm);
+
+	if (res < 0)
+		ERROR("%s decompression failed, data probably corrupt\n",
+			msblk->decompressor->name);
+
+	return res;
+}
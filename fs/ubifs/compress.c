@@ -28,6 +28,7 @@
  */
 
 #include <linux/crypto.h>
+#include <linux/lzo.h>
 #include "ubifs.h"
 
 /* Fake description object for the "none" compressor */
@@ -74,6 +75,34 @@ static struct ubifs_compressor zlib_compr = {
 /* All UBIFS compressors */
 struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
 
+/**
+ * lzo_decompress - decompress LZO data.
+ * @in_buf: data to decompress
+ * @in_len: length of the data to decompress
+ * @out_buf: output buffer
+ * @out_len: output buffer length on enter, decompressed length on exit
+ *
+ * This is what the "lzo" crypto API compressor does, without the indirection.
+ * Returns zero in case of success and %-EINVAL if the data is corrupted.
+ */
+static int lzo_decompress(const void *in_buf, int in_len, void *out_buf,
+			  int *out_len)
+{
+#ifdef CONFIG_UBIFS_FS_LZO
+	size_t len = *out_len;
+	int err;
+
+	err = lzo1x_decompress_safe(in_buf, in_len, out_buf, &len);
+	if (err != LZO_E_OK)
+		return -EINVAL;
+
+	*out_len = len;
+	return 0;
+#else
+	return -EINVAL;
+#endif
+}
+
 /**
  * ubifs_compress - compress data.
  * @in_buf: data to compress
@@ -122,7 +151,8 @@ void ubifs_compress(const void *in_buf, int in_len, void *out_buf, int *out_len,
 	 * If the data compressed only slightly, it is better to leave it
 	 * uncompressed to improve read speed.
 	 */
-	if (in_len - *out_len < UBIFS_MIN_COMPRESS_DIFF)
+	if (in_len - *out_len < UBIFS_MIN_COMPRESS_DIFF ||
+	    in_len - *out_len < in_len >> UBIFS_MIN_COMPR_GAIN_SHIFT)
 		goto no_compr;
 
 	return;
@@ -135,6 +165,7 @@ no_compr:
 
 /**
  * ubifs_decompress - decompress data.
+ * @c: UBIFS file-system description object
  * @in_buf: data to decompress
  * @in_len: length of the data to decompress
  * @out_buf: output buffer where decompressed data should
@@ -144,12 +175,25 @@ no_compr:
  * This function decompresses data from buffer @in_buf into buffer @out_buf.
  * The length of the uncompressed data is returned in @out_len. This functions
  * returns %0 on success or a negative error code on failure.
+ *
+ * Uncompressed data nodes are just copied, and LZO data is decompressed by
+ * calling the LZO library directly rather than through the crypto API, which
+ * are the common cases on the read path.
  */
-int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
-		     int *out_len, int compr_type)
+int ubifs_decompress(const struct ubifs_info *c, const void *in_buf,
+		     int in_len, void *out_buf, int *out_len, int compr_type)
 {
 	int err;
 	struct ubifs_compressor *compr;
+	ktime_t start;
+
+	if (compr_type == UBIFS_COMPR_NONE) {
+		if (unlikely(in_len > *out_len))
+			return -EINVAL;
+		memcpy(out_buf, in_buf, in_len);
+		*out_len = in_len;
+		return 0;
+	}
 
 	if (unlikely(compr_type < 0 || compr_type >= UBIFS_COMPR_TYPES_CNT)) {
 		ubifs_err("invalid compression type %d", compr_type);
@@ -163,21 +207,22 @@ int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
 		return -EINVAL;
 	}
 
-	if (compr_type == UBIFS_COMPR_NONE) {
-		memcpy(out_buf, in_buf, in_len);
-		*out_len = in_len;
-		return 0;
+	start = dbg_ktime_get();
+	if (compr_type == UBIFS_COMPR_LZO)
+		err = lzo_decompress(in_buf, in_len, out_buf, out_len);
+	else {
+		if (compr->decomp_mutex)
+			mutex_lock(compr->decomp_mutex);
+		err = crypto_comp_decompress(compr->cc, in_buf, in_len, out_buf,
+					     (unsigned int *)out_len);
+		if (compr->decomp_mutex)
+			mutex_unlock(compr->decomp_mutex);
 	}
-
-	if (compr->decomp_mutex)
-		mutex_lock(compr->decomp_mutex);
-	err = crypto_comp_decompress(compr->cc, in_buf, in_len, out_buf,
-				     (unsigned int *)out_len);
-	if (compr->decomp_mutex)
-		mutex_unlock(compr->decomp_mutex);
 	if (err)
 		ubifs_err("cannot decompress %d bytes, compressor %s, "
 			  "error %d", in_len, compr->name, err);
+	else
+		dbg_decompr_time(c, compr_type, start);
 
 	return err;
 }
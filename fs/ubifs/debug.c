@@ -2542,6 +2542,7 @@ int ubifs_debugging_init(struct ubifs_info *c)
 	if (!c->dbg->buf)
 		goto out;
 
+	spin_lock_init(&c->dbg->stat_lock);
 	failure_mode_init(c);
 	return 0;
 
@@ -2631,6 +2632,109 @@ static const struct file_operations dfs_fops = {
 	.owner = THIS_MODULE,
 };
 
+/**
+ * dbg_decompr_time - account a data node decompression.
+ * @c: UBIFS file-system description object
+ * @compr_type: compressor used
+ * @start: time the decompression started
+ */
+void dbg_decompr_time(const struct ubifs_info *c, int compr_type,
+		      ktime_t start)
+{
+	struct ubifs_debug_info *d = c->dbg;
+	unsigned long ns;
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	spin_lock(&d->stat_lock);
+	d->decompr_cnt[compr_type] += 1;
+	d->decompr_ns[compr_type] += ns;
+	if (ns > d->decompr_max_ns[compr_type])
+		d->decompr_max_ns[compr_type] = ns;
+	spin_unlock(&d->stat_lock);
+}
+
+/**
+ * dbg_compr_fallback - account a data node written uncompressed.
+ * @c: UBIFS file-system description object
+ * @skipped: non-zero if compression was not even tried
+ */
+void dbg_compr_fallback(const struct ubifs_info *c, int skipped)
+{
+	struct ubifs_debug_info *d = c->dbg;
+
+	spin_lock(&d->stat_lock);
+	if (skipped)
+		d->compr_skipped += 1;
+	else
+		d->compr_poor += 1;
+	spin_unlock(&d->stat_lock);
+}
+
+static ssize_t read_compr_stats(struct file *file, char __user *u,
+				size_t count, loff_t *ppos)
+{
+	struct ubifs_info *c = file->private_data;
+	struct ubifs_debug_info *d = c->dbg;
+	char buf[320];
+	int i, len;
+
+	len = snprintf(buf, sizeof(buf), "compr  nodes      avg ns     max ns\n");
+	spin_lock(&d->stat_lock);
+	for (i = 0; i < UBIFS_COMPR_TYPES_CNT; i++) {
+		unsigned long long avg = d->decompr_ns[i];
+
+		if (d->decompr_cnt[i])
+			do_div(avg, d->decompr_cnt[i]);
+		len += snprintf(buf + len, sizeof(buf) - len,
+				"%-6s %-10lu %-10llu %lu\n",
+				ubifs_compr_name(i), d->decompr_cnt[i], avg,
+				d->decompr_max_ns[i]);
+	}
+	len += snprintf(buf + len, sizeof(buf) - len,
+			"written uncompressed: %lu poorly compressing, "
+			"%lu not tried\n", d->compr_poor, d->compr_skipped);
+	spin_unlock(&d->stat_lock);
+
+	return simple_read_from_buffer(u, count, ppos, buf, len);
+}
+
+static const struct file_operations dfs_stats_fops = {
+	.open = open_debugfs_file,
+	.read = read_compr_stats,
+	.owner = THIS_MODULE,
+};
+
+static ssize_t read_cache_stats(struct file *file, char __user *u,
+				size_t count, loff_t *ppos)
+{
+	struct ubifs_info *c = file->private_data;
+	char buf[320];
+	int len;
+
+	mutex_lock(&c->lp_mutex);
+	len = snprintf(buf, sizeof(buf),
+		       "pnodes:         %d of %d in memory, %lu read, "
+		       "%lu evicted\n", c->pnodes_have, c->pnode_cnt,
+		       c->pnode_reads, c->pnode_evicts);
+	mutex_unlock(&c->lp_mutex);
+	len += snprintf(buf + len, sizeof(buf) - len,
+			"znodes:         %ld clean, %ld dirty, %ld prefetched\n",
+			atomic_long_read(&c->clean_zn_cnt),
+			atomic_long_read(&c->dirty_zn_cnt),
+			atomic_long_read(&c->znode_prefetch));
+	len += snprintf(buf + len, sizeof(buf) - len,
+			"bulk-read:      %ld pages of next inodes\n",
+			atomic_long_read(&c->bu_next_pages));
+
+	return simple_read_from_buffer(u, count, ppos, buf, len);
+}
+
+static const struct file_operations dfs_cache_fops = {
+	.open = open_debugfs_file,
+	.read = read_cache_stats,
+	.owner = THIS_MODULE,
+};
+
 /**
  * dbg_debugfs_init_fs - initialize debugfs for UBIFS instance.
  * @c: UBIFS file-system description object
@@ -2677,6 +2781,20 @@ int dbg_debugfs_init_fs(struct ubifs_info *c)
 		goto out_remove;
 	d->dfs_dump_tnc = dent;
 
+	fname = "compr_stats";
+	dent = debugfs_create_file(fname, S_IRUGO, d->dfs_dir, c,
+				   &dfs_stats_fops);
+	if (IS_ERR(dent))
+		goto out_remove;
+	d->dfs_compr_stats = dent;
+
+	fname = "cache_stats";
+	dent = debugfs_create_file(fname, S_IRUGO, d->dfs_dir, c,
+				   &dfs_cache_fops);
+	if (IS_ERR(dent))
+		goto out_remove;
+	d->dfs_cache_stats = dent;
+
 	return 0;
 
 out_remove:
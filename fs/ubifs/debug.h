@@ -47,11 +47,20 @@
  * @saved_lst: saved lprops statistics (used by 'dbg_save_space_info()')
  * @saved_free: saved free space (used by 'dbg_save_space_info()')
  *
+ * @stat_lock: protects the compression statistics below
+ * @decompr_cnt: data nodes decompressed, per compressor type
+ * @decompr_ns: total time spent decompressing them, nanoseconds
+ * @decompr_max_ns: longest decompression of a data node
+ * @compr_poor: data nodes stored uncompressed because they did not compress
+ * @compr_skipped: data nodes not even tried (see %UBIFS_COMPR_SKIP)
+ *
  * dfs_dir_name: name of debugfs directory containing this file-system's files
  * dfs_dir: direntry object of the file-system debugfs directory
  * dfs_dump_lprops: "dump lprops" debugfs knob
  * dfs_dump_budg: "dump budgeting information" debugfs knob
  * dfs_dump_tnc: "dump TNC" debugfs knob
+ * dfs_compr_stats: compression statistics debugfs file
+ * dfs_cache_stats: LPT and TNC cache statistics debugfs file
  */
 struct ubifs_debug_info {
 	void *buf;
@@ -79,6 +88,15 @@ struct ubifs_debug_info {
 	struct dentry *dfs_dump_lprops;
 	struct dentry *dfs_dump_budg;
 	struct dentry *dfs_dump_tnc;
+	struct dentry *dfs_compr_stats;
+	struct dentry *dfs_cache_stats;
+
+	spinlock_t stat_lock;
+	unsigned long decompr_cnt[UBIFS_COMPR_TYPES_CNT];
+	unsigned long long decompr_ns[UBIFS_COMPR_TYPES_CNT];
+	unsigned long decompr_max_ns[UBIFS_COMPR_TYPES_CNT];
+	unsigned long compr_poor;
+	unsigned long compr_skipped;
 };
 
 #define ubifs_assert(expr) do {                                                \
@@ -377,6 +395,12 @@ static inline int dbg_change(struct ubi_volume_desc *desc, int lnum,
 	return dbg_leb_change(desc, lnum, buf, len, UBI_UNKNOWN);
 }
 
+/* Compression statistics */
+#define dbg_ktime_get() ktime_get()
+void dbg_decompr_time(const struct ubifs_info *c, int compr_type,
+		      ktime_t start);
+void dbg_compr_fallback(const struct ubifs_info *c, int skipped);
+
 /* Debugfs-related stuff */
 int dbg_debugfs_init(void);
 void dbg_debugfs_exit(void);
@@ -469,6 +493,10 @@ void dbg_debugfs_exit_fs(struct ubifs_info *c);
 #define dbg_force_in_the_gaps()                    0
 #define dbg_failure_mode                           0
 
+#define dbg_ktime_get()                            ktime_set(0, 0)
+#define dbg_decompr_time(c, compr_type, start)     ((void)(start))
+#define dbg_compr_fallback(c, skipped)             ({})
+
 #define dbg_debugfs_init()                         0
 #define dbg_debugfs_exit()
 #define dbg_debugfs_init_fs(c)                     0
@@ -75,6 +75,36 @@ static int inherit_flags(const struct inode *dir, int mode)
 	return flags;
 }
 
+/**
+ * inherit_compr - inherit compressor of the parent directory.
+ * @c: UBIFS file-system description object
+ * @dir: parent inode
+ * @mode: new inode mode flags
+ *
+ * This is a helper function for 'ubifs_new_inode()'. Directories do not
+ * compress anything themselves, so their compressor type is a policy for the
+ * new inodes created in them (see %UBIFS_IOC_SETCOMPR): regular files and
+ * directories inherit it, unless it is %UBIFS_COMPR_NONE or not compiled in,
+ * in which case files get the default compressor. Returns the compressor type
+ * for the new inode.
+ */
+static int inherit_compr(const struct ubifs_info *c, const struct inode *dir,
+			 int mode)
+{
+	int compr_type = UBIFS_COMPR_NONE;
+
+	if (S_ISDIR(dir->i_mode))
+		compr_type = ubifs_inode(dir)->compr_type;
+	if (compr_type != UBIFS_COMPR_NONE && !ubifs_compr_present(compr_type))
+		compr_type = UBIFS_COMPR_NONE;
+
+	if (S_ISREG(mode) && compr_type == UBIFS_COMPR_NONE)
+		return c->default_compr;
+	if (S_ISREG(mode) || S_ISDIR(mode))
+		return compr_type;
+	return UBIFS_COMPR_NONE;
+}
+
 /**
  * ubifs_new_inode - allocate new UBIFS inode object.
  * @c: UBIFS file-system description object
@@ -144,10 +174,7 @@ struct inode *ubifs_new_inode(struct ubifs_info *c, const struct inode *dir,
 
 	ui->flags = inherit_flags(dir, mode);
 	ubifs_set_inode_flags(inode);
-	if (S_ISREG(mode))
-		ui->compr_type = c->default_compr;
-	else
-		ui->compr_type = UBIFS_COMPR_NONE;
+	ui->compr_type = inherit_compr(c, dir, mode);
 	ui->synced_i_size = 0;
 
 	spin_lock(&c->cnt_lock);
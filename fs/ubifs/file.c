@@ -78,7 +78,7 @@ static int read_block(struct inode *inode, void *addr, unsigned int block,
 
 	dlen = le32_to_cpu(dn->ch.len) - UBIFS_DATA_NODE_SZ;
 	out_len = UBIFS_BLOCK_SIZE;
-	err = ubifs_decompress(&dn->data, dlen, addr, &out_len,
+	err = ubifs_decompress(c, &dn->data, dlen, addr, &out_len,
 			       le16_to_cpu(dn->compr_type));
 	if (err || len != out_len)
 		goto dump;
@@ -643,7 +643,8 @@ static int populate_page(struct ubifs_info *c, struct page *page,
 
 			dlen = le32_to_cpu(dn->ch.len) - UBIFS_DATA_NODE_SZ;
 			out_len = UBIFS_BLOCK_SIZE;
-			err = ubifs_decompress(&dn->data, dlen, addr, &out_len,
+			err = ubifs_decompress(c, &dn->data, dlen, addr,
+					       &out_len,
 					       le16_to_cpu(dn->compr_type));
 			if (err || len != out_len)
 				goto out_err;
@@ -696,22 +697,87 @@ out_err:
 	return -EINVAL;
 }
 
+/**
+ * bulk_read_next_inode - populate pages of the next inode from bulk-read.
+ * @c: UBIFS file-system description object
+ * @bu: bulk-read information
+ *
+ * If 'ubifs_tnc_get_bu_keys()' took the data nodes of the next inode as well,
+ * and that inode is in the inode cache, this function populates its pages
+ * which are not in the page cache yet. Locked pages are skipped. The inode is
+ * returned and the caller has to 'iput()' it after releasing the UBIFS locks
+ * it holds, because that may be the last reference. %NULL is returned if the
+ * inode is not in the inode cache.
+ */
+static struct inode *bulk_read_next_inode(struct ubifs_info *c,
+					  struct bu_info *bu)
+{
+	struct ubifs_data_node *dn;
+	struct inode *inode;
+	pgoff_t index, end_index;
+	int err, n = bu->next_n;
+	loff_t isize;
+
+	inode = ilookup(c->vfs_sb, bu->next_inum);
+	if (!inode)
+		return NULL;
+
+	/* The inode number may have been re-used meanwhile */
+	dn = bu->buf + (bu->zbranch[n].offs - bu->zbranch[0].offs);
+	if (!S_ISREG(inode->i_mode) ||
+	    le64_to_cpu(dn->ch.sqnum) <= ubifs_inode(inode)->creat_sqnum)
+		return inode;
+
+	isize = i_size_read(inode);
+	if (isize == 0)
+		return inode;
+	end_index = (isize - 1) >> PAGE_CACHE_SHIFT;
+
+	while (n < bu->cnt) {
+		struct page *page;
+
+		index = key_block(c, &bu->zbranch[n].key);
+		index >>= UBIFS_BLOCKS_PER_PAGE_SHIFT;
+		if (index > end_index)
+			break;
+		page = grab_cache_page_nowait(inode->i_mapping, index);
+		if (!page)
+			break;
+		err = 0;
+		if (!PageUptodate(page)) {
+			err = populate_page(c, page, bu, &n);
+			if (!err)
+				atomic_long_inc(&c->bu_next_pages);
+		}
+		unlock_page(page);
+		page_cache_release(page);
+		if (err)
+			break;
+		/* Skip the data nodes of an up-to-date page */
+		while (n < bu->cnt && (key_block(c, &bu->zbranch[n].key) >>
+				       UBIFS_BLOCKS_PER_PAGE_SHIFT) <= index)
+			n += 1;
+	}
+	return inode;
+}
+
 /**
  * ubifs_do_bulk_read - do bulk-read.
  * @c: UBIFS file-system description object
  * @bu: bulk-read information
  * @page1: first page to read
+ * @next: the next inode, if its pages were populated too, is returned here
  *
  * This function returns %1 if the bulk-read is done, otherwise %0 is returned.
  */
 static int ubifs_do_bulk_read(struct ubifs_info *c, struct bu_info *bu,
-			      struct page *page1)
+			      struct page *page1, struct inode **next)
 {
 	pgoff_t offset = page1->index, end_index;
 	struct address_space *mapping = page1->mapping;
 	struct inode *inode = mapping->host;
 	struct ubifs_inode *ui = ubifs_inode(inode);
-	int err, page_idx, page_cnt, ret = 0, n = 0;
+	int err, page_idx, page_cnt, ret = 0, n = 0, cnt;
 	int allocate = bu->buf ? 0 : 1;
 	loff_t isize;
 
@@ -757,6 +823,11 @@ static int ubifs_do_bulk_read(struct ubifs_info *c, struct bu_info *bu,
 			goto out_warn;
 	}
 
+	/* Leave the data nodes of the next inode out for now */
+	cnt = bu->cnt;
+	if (bu->next_inum)
+		bu->cnt = bu->next_n;
+
 	err = populate_page(c, page1, bu, &n);
 	if (err)
 		goto out_warn;
@@ -789,6 +860,11 @@ static int ubifs_do_bulk_read(struct ubifs_info *c, struct bu_info *bu,
 
 	ui->last_page_read = offset + page_idx - 1;
 
+	if (bu->next_inum) {
+		bu->cnt = cnt;
+		*next = bulk_read_next_inode(c, bu);
+	}
+
 out_free:
 	if (allocate)
 		kfree(bu->buf);
@@ -818,6 +894,7 @@ static int ubifs_bulk_read(struct page *page)
 	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	struct ubifs_inode *ui = ubifs_inode(inode);
 	pgoff_t index = page->index, last_page_read = ui->last_page_read;
+	struct inode *next = NULL;
 	struct bu_info *bu;
 	int err = 0, allocated = 0;
 
@@ -866,7 +943,7 @@ static int ubifs_bulk_read(struct page *page)
 	bu->buf_len = c->max_bu_buf_len;
 	data_key_init(c, &bu->key, inode->i_ino,
 		      page->index << UBIFS_BLOCKS_PER_PAGE_SHIFT);
-	err = ubifs_do_bulk_read(c, bu, page);
+	err = ubifs_do_bulk_read(c, bu, page, &next);
 
 	if (!allocated)
 		mutex_unlock(&c->bu_mutex);
@@ -875,6 +952,8 @@ static int ubifs_bulk_read(struct page *page)
 
 out_unlock:
 	mutex_unlock(&ui->ui_mutex);
+	if (next)
+		iput(next);
 	return err;
 }
 
@@ -1536,6 +1615,7 @@ out_unlock:
 
 static const struct vm_operations_struct ubifs_file_vm_ops = {
 	.fault        = filemap_fault,
+	.map_pages    = filemap_map_pages,
 	.page_mkwrite = ubifs_vm_page_mkwrite,
 };
 
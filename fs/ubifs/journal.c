@@ -688,7 +688,7 @@ int ubifs_jnl_write_data(struct ubifs_info *c, const struct inode *inode,
 			 const union ubifs_key *key, const void *buf, int len)
 {
 	struct ubifs_data_node *data;
-	int err, lnum, offs, compr_type, out_len;
+	int err, lnum, offs, compr_type, out_len, tried;
 	int dlen = UBIFS_DATA_NODE_SZ + UBIFS_BLOCK_SIZE * WORST_COMPR_FACTOR;
 	struct ubifs_inode *ui = ubifs_inode(inode);
 
@@ -709,13 +709,28 @@ int ubifs_jnl_write_data(struct ubifs_info *c, const struct inode *inode,
 	if (!(ui->flags & UBIFS_COMPR_FL))
 		/* Compression is disabled for this inode */
 		compr_type = UBIFS_COMPR_NONE;
-	else
+	else if (ui->compr_skip) {
+		/* Recent data of this inode did not compress */
+		ui->compr_skip -= 1;
+		compr_type = UBIFS_COMPR_NONE;
+		dbg_compr_fallback(c, 1);
+	} else
 		compr_type = ui->compr_type;
 
+	tried = compr_type != UBIFS_COMPR_NONE && len >= UBIFS_MIN_COMPR_LEN;
 	out_len = dlen - UBIFS_DATA_NODE_SZ;
 	ubifs_compress(buf, len, &data->data, &out_len, &compr_type);
 	ubifs_assert(out_len <= UBIFS_BLOCK_SIZE);
 
+	if (tried && compr_type == UBIFS_COMPR_NONE) {
+		dbg_compr_fallback(c, 0);
+		if (++ui->compr_poor >= UBIFS_COMPR_POOR_MAX) {
+			ui->compr_poor = 0;
+			ui->compr_skip = UBIFS_COMPR_SKIP;
+		}
+	} else if (tried)
+		ui->compr_poor = 0;
+
 	dlen = UBIFS_DATA_NODE_SZ + out_len;
 	data->compr_type = cpu_to_le16(compr_type);
 
@@ -1072,13 +1087,15 @@ out_free:
 
 /**
  * recomp_data_node - re-compress a truncated data node.
+ * @c: UBIFS file-system description object
  * @dn: data node to re-compress
  * @new_len: new length
  *
  * This function is used when an inode is truncated and the last data node of
  * the inode has to be re-compressed and re-written.
  */
-static int recomp_data_node(struct ubifs_data_node *dn, int *new_len)
+static int recomp_data_node(const struct ubifs_info *c,
+			    struct ubifs_data_node *dn, int *new_len)
 {
 	void *buf;
 	int err, len, compr_type, out_len;
@@ -1090,7 +1107,7 @@ static int recomp_data_node(struct ubifs_data_node *dn, int *new_len)
 
 	len = le32_to_cpu(dn->ch.len) - UBIFS_DATA_NODE_SZ;
 	compr_type = le16_to_cpu(dn->compr_type);
-	err = ubifs_decompress(&dn->data, len, buf, &out_len, compr_type);
+	err = ubifs_decompress(c, &dn->data, len, buf, &out_len, compr_type);
 	if (err)
 		goto out;
 
@@ -1169,7 +1186,7 @@ int ubifs_jnl_truncate(struct ubifs_info *c, const struct inode *inode,
 				int compr_type = le16_to_cpu(dn->compr_type);
 
 				if (compr_type != UBIFS_COMPR_NONE) {
-					err = recomp_data_node(dn, &dlen);
+					err = recomp_data_node(c, dn, &dlen);
 					if (err)
 						goto out_free;
 				} else {
@@ -1306,7 +1306,9 @@ static int read_pnode(struct ubifs_info *c, struct ubifs_nnode *parent, int iip)
 	pnode->parent = parent;
 	pnode->iip = iip;
 	set_pnode_lnum(c, pnode);
+	list_add_tail(&pnode->lru, &c->pnode_lru);
 	c->pnodes_have += 1;
+	c->pnode_reads += 1;
 	return 0;
 
 out:
@@ -1420,8 +1422,10 @@ struct ubifs_pnode *ubifs_get_pnode(struct ubifs_info *c,
 
 	branch = &parent->nbranch[iip];
 	pnode = branch->pnode;
-	if (pnode)
+	if (pnode) {
+		list_move_tail(&pnode->lru, &c->pnode_lru);
 		return pnode;
+	}
 	err = read_pnode(c, parent, iip);
 	if (err)
 		return ERR_PTR(err);
@@ -1429,6 +1433,70 @@ struct ubifs_pnode *ubifs_get_pnode(struct ubifs_info *c,
 	return branch->pnode;
 }
 
+/**
+ * pnode_evictable - determine if a pnode may be freed.
+ * @pnode: pnode to check
+ *
+ * A pnode may be dropped and read again later if it is clean, is not being
+ * committed, and none of its LEB properties is taken or kept on a heap or a
+ * category list other than the un-categorized one. This function returns %1
+ * if that is the case and %0 otherwise.
+ */
+static int pnode_evictable(const struct ubifs_pnode *pnode)
+{
+	int i;
+
+	if (pnode->flags || pnode->cnext)
+		return 0;
+	for (i = 0; i < UBIFS_LPT_FANOUT; i++) {
+		int flags = pnode->lprops[i].flags;
+
+		if ((flags & LPROPS_CAT_MASK) != LPROPS_UNCAT ||
+		    (flags & LPROPS_TAKEN))
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * ubifs_lpt_evict - free least recently used clean pnodes.
+ * @c: UBIFS file-system description object
+ *
+ * The LPT is read lazily, but pnodes used to stay in memory until unmount,
+ * which on a big volume ends up being the whole LPT. This function frees least
+ * recently used pnodes until there are at most %UBIFS_LPT_CACHE_PNODES of them.
+ * Pnodes which cannot be freed (see 'pnode_evictable()') are moved to the end
+ * of the list, and at most %UBIFS_LPT_EVICT_SCAN pnodes are looked at per call.
+ * The caller has to hold @c->lp_mutex.
+ */
+void ubifs_lpt_evict(struct ubifs_info *c)
+{
+	struct ubifs_pnode *pnode, *tmp;
+	int i, scanned = 0;
+
+	ubifs_assert(mutex_is_locked(&c->lp_mutex));
+	list_for_each_entry_safe(pnode, tmp, &c->pnode_lru, lru) {
+		if (c->pnodes_have <= UBIFS_LPT_CACHE_PNODES ||
+		    scanned++ >= UBIFS_LPT_EVICT_SCAN)
+			break;
+		if (!pnode_evictable(pnode)) {
+			list_move_tail(&pnode->lru, &c->pnode_lru);
+			continue;
+		}
+		/* Un-categorized LEB properties are on @c->uncat_list */
+		for (i = 0; i < UBIFS_LPT_FANOUT; i++) {
+			if (!pnode->lprops[i].lnum)
+				break;
+			list_del(&pnode->lprops[i].list);
+		}
+		pnode->parent->nbranch[pnode->iip].pnode = NULL;
+		list_del(&pnode->lru);
+		kfree(pnode);
+		c->pnodes_have -= 1;
+		c->pnode_evicts += 1;
+	}
+}
+
 /**
  * ubifs_lpt_lookup - lookup LEB properties in the LPT.
  * @c: UBIFS file-system description object
@@ -1549,6 +1617,7 @@ static struct ubifs_pnode *dirty_cow_pnode(struct ubifs_info *c,
 		return ERR_PTR(-ENOMEM);
 
 	memcpy(p, pnode, sizeof(struct ubifs_pnode));
+	list_replace(&pnode->lru, &p->lru);
 	p->cnext = NULL;
 	__set_bit(DIRTY_CNODE, &p->flags);
 	__clear_bit(COW_CNODE, &p->flags);
@@ -2007,7 +2076,9 @@ again:
 				path[h].ptr.pnode = pnode;
 				path[h].in_tree = 1;
 				update_cats(c, pnode);
+				list_add_tail(&pnode->lru, &c->pnode_lru);
 				c->pnodes_have += 1;
+				c->pnode_reads += 1;
 			}
 			err = dbg_check_lpt_nodes(c, (struct ubifs_cnode *)
 						  c->nroot, 0, 0);
@@ -327,13 +327,16 @@ static inline void ubifs_get_lprops(struct ubifs_info *c)
  * @c: the UBIFS file-system description object
  *
  * This function has to be called after each 'ubifs_get_lprops()' call to
- * unlock lprops.
+ * unlock lprops. If there are too many pnodes in memory, some clean ones are
+ * freed first.
  */
 static inline void ubifs_release_lprops(struct ubifs_info *c)
 {
 	ubifs_assert(mutex_is_locked(&c->lp_mutex));
 	ubifs_assert(c->lst.empty_lebs >= 0 &&
 		     c->lst.empty_lebs <= c->main_lebs);
+	if (c->pnodes_have > UBIFS_LPT_CACHE_PNODES)
+		ubifs_lpt_evict(c);
 	mutex_unlock(&c->lp_mutex);
 }
 
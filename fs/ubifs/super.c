@@ -1922,6 +1922,7 @@ static int ubifs_fill_super(struct super_block *sb, void *data, int silent)
 	INIT_LIST_HEAD(&c->replay_list);
 	INIT_LIST_HEAD(&c->replay_buds);
 	INIT_LIST_HEAD(&c->uncat_list);
+	INIT_LIST_HEAD(&c->pnode_lru);
 	INIT_LIST_HEAD(&c->empty_list);
 	INIT_LIST_HEAD(&c->freeable_list);
 	INIT_LIST_HEAD(&c->frdi_idx_list);
@@ -594,6 +594,23 @@ static struct ubifs_znode *get_znode(struct ubifs_info *c,
 	return znode;
 }
 
+/**
+ * get_znode_ahead - get a TNC znode, reading its right siblings as well.
+ * @c: UBIFS file-system description object
+ * @znode: parent znode
+ * @n: znode branch slot number
+ *
+ * This is 'get_znode()' for sequential scans, which will soon need the
+ * siblings too. This function returns the znode or a negative error code.
+ */
+static struct ubifs_znode *get_znode_ahead(struct ubifs_info *c,
+					   struct ubifs_znode *znode, int n)
+{
+	if (!znode->zbranch[n].znode)
+		ubifs_prefetch_znodes(c, znode, n);
+	return get_znode(c, znode, n);
+}
+
 /**
  * tnc_next - find next TNC entry.
  * @c: UBIFS file-system description object
@@ -622,11 +639,11 @@ static int tnc_next(struct ubifs_info *c, struct ubifs_znode **zn, int *n)
 		nn = znode->iip + 1;
 		znode = zp;
 		if (nn < znode->child_cnt) {
-			znode = get_znode(c, znode, nn);
+			znode = get_znode_ahead(c, znode, nn);
 			if (IS_ERR(znode))
 				return PTR_ERR(znode);
 			while (znode->level != 0) {
-				znode = get_znode(c, znode, 0);
+				znode = get_znode_ahead(c, znode, 0);
 				if (IS_ERR(znode))
 					return PTR_ERR(znode);
 			}
@@ -1499,6 +1516,67 @@ out:
 	return err;
 }
 
+/**
+ * bu_add_next_inode - add the data nodes of the next inode to bulk-read.
+ * @c: UBIFS file-system description object
+ * @bu: bulk-read information
+ * @znode: znode of the first key after the data of the inode being read
+ * @n: its slot number
+ * @offs: end of the last data node in @bu
+ *
+ * Files written together, like the files of an installed package, end up next
+ * to each other on the media. When bulk-read reaches the end of a file, this
+ * function looks at the data nodes of the next inode. They are added to @bu
+ * only if all of them fit, are in the same LEB as the nodes already there, and
+ * each one is at most %UBIFS_BU_NEXT_INO_GAP bytes after the previous one. The
+ * caller has to hold @c->tnc_mutex.
+ */
+static void bu_add_next_inode(struct ubifs_info *c, struct bu_info *bu,
+			      struct ubifs_znode *znode, int n, int offs)
+{
+	int err, cnt = bu->cnt, lnum = bu->zbranch[0].lnum;
+	ino_t inum = key_inum(c, &bu->key), next_inum;
+	struct ubifs_zbranch *zbr;
+
+	/* Skip the extended attribute entries of this inode */
+	zbr = &znode->zbranch[n];
+	while (key_inum(c, &zbr->key) == inum) {
+		err = tnc_next(c, &znode, &n);
+		if (err)
+			return;
+		zbr = &znode->zbranch[n];
+	}
+	if (key_type(c, &zbr->key) != UBIFS_INO_KEY)
+		return;
+	next_inum = key_inum(c, &zbr->key);
+
+	while (1) {
+		err = tnc_next(c, &znode, &n);
+		if (err == -ENOENT)
+			break;
+		if (err)
+			return;
+		zbr = &znode->zbranch[n];
+		if (key_inum(c, &zbr->key) != next_inum ||
+		    key_type(c, &zbr->key) != UBIFS_DATA_KEY)
+			break;
+		if (cnt >= UBIFS_MAX_BULK_READ ||
+		    key_block(c, &zbr->key) >= UBIFS_MAX_BULK_READ)
+			return;
+		if (zbr->lnum != lnum || zbr->offs < offs ||
+		    zbr->offs - offs > UBIFS_BU_NEXT_INO_GAP ||
+		    zbr->offs + zbr->len - bu->zbranch[0].offs > bu->buf_len)
+			return;
+		bu->zbranch[cnt++] = *zbr;
+		offs = ALIGN(zbr->offs + zbr->len, 8);
+	}
+	if (cnt == bu->cnt)
+		return;
+	bu->next_inum = next_inum;
+	bu->next_n = bu->cnt;
+	bu->cnt = cnt;
+}
+
 /**
  * ubifs_tnc_get_bu_keys - lookup keys for bulk-read.
  * @c: UBIFS file-system description object
@@ -1522,6 +1600,7 @@ int ubifs_tnc_get_bu_keys(struct ubifs_info *c, struct bu_info *bu)
 	bu->cnt = 0;
 	bu->blk_cnt = 0;
 	bu->eof = 0;
+	bu->next_inum = 0;
 
 	mutex_lock(&c->tnc_mutex);
 	/* Find first key */
@@ -1556,6 +1635,8 @@ int ubifs_tnc_get_bu_keys(struct ubifs_info *c, struct bu_info *bu)
 		/* See if there is another data key for this file */
 		if (key_inum(c, key) != key_inum(c, &bu->key) ||
 		    key_type(c, key) != UBIFS_DATA_KEY) {
+			if (bu->cnt)
+				bu_add_next_inode(c, bu, znode, n, offs);
 			err = -ENOENT;
 			goto out;
 		}
@@ -1775,13 +1856,15 @@ int ubifs_tnc_bulk_read(struct ubifs_info *c, struct bu_info *bu)
 		return err;
 	}
 
-	/* Validate the nodes read */
-	buf = bu->buf;
+	/*
+	 * Validate the nodes read. Data nodes of the next inode may come after
+	 * a gap (see 'bu_add_next_inode()').
+	 */
 	for (i = 0; i < bu->cnt; i++) {
+		buf = bu->buf + bu->zbranch[i].offs - offs;
 		err = validate_data_node(c, buf, &bu->zbranch[i]);
 		if (err)
 			return err;
-		buf = buf + ALIGN(bu->zbranch[i].len, 8);
 	}
 
 	return 0;
@@ -257,34 +257,21 @@ long ubifs_destroy_tnc_subtree(struct ubifs_znode *znode)
 }
 
 /**
- * read_znode - read an indexing node from flash and fill znode.
+ * unpack_znode - fill znode from an indexing node.
  * @c: UBIFS file-system description object
- * @lnum: LEB of the indexing node to read
+ * @idx: indexing node, already read and checked by 'ubifs_check_node()'
+ * @lnum: LEB of the indexing node
  * @offs: node offset
- * @len: node length
- * @znode: znode to read to
+ * @znode: znode to fill
  *
- * This function reads an indexing node from the flash media and fills znode
- * with the read data. Returns zero in case of success and a negative error
- * code in case of failure. The read indexing node is validated and if anything
- * is wrong with it, this function prints complaint messages and returns
- * %-EINVAL.
+ * This function validates the indexing node and fills znode with its data.
+ * If anything is wrong with it, this function prints complaint messages and
+ * returns %-EINVAL, otherwise it returns zero.
  */
-static int read_znode(struct ubifs_info *c, int lnum, int offs, int len,
-		      struct ubifs_znode *znode)
+static int unpack_znode(struct ubifs_info *c, struct ubifs_idx_node *idx,
+			int lnum, int offs, struct ubifs_znode *znode)
 {
 	int i, err, type, cmp;
-	struct ubifs_idx_node *idx;
-
-	idx = kmalloc(c->max_idx_node_sz, GFP_NOFS);
-	if (!idx)
-		return -ENOMEM;
-
-	err = ubifs_read_node(c, idx, UBIFS_IDX_NODE, len, lnum, offs);
-	if (err < 0) {
-		kfree(idx);
-		return err;
-	}
 
 	znode->child_cnt = le16_to_cpu(idx->child_cnt);
 	znode->level = le16_to_cpu(idx->level);
@@ -382,16 +369,73 @@ static int read_znode(struct ubifs_info *c, int lnum, int offs, int len,
 		}
 	}
 
-	kfree(idx);
 	return 0;
 
 out_dump:
 	ubifs_err("bad indexing node at LEB %d:%d, error %d", lnum, offs, err);
 	dbg_dump_node(c, idx);
-	kfree(idx);
 	return -EINVAL;
 }
 
+/**
+ * read_znode - read an indexing node from flash and fill znode.
+ * @c: UBIFS file-system description object
+ * @lnum: LEB of the indexing node to read
+ * @offs: node offset
+ * @len: node length
+ * @znode: znode to read to
+ *
+ * This function reads an indexing node from the flash media and fills znode
+ * with the read data. Returns zero in case of success and a negative error
+ * code in case of failure. The read indexing node is validated and if anything
+ * is wrong with it, this function prints complaint messages and returns
+ * %-EINVAL.
+ */
+static int read_znode(struct ubifs_info *c, int lnum, int offs, int len,
+		      struct ubifs_znode *znode)
+{
+	int err;
+	struct ubifs_idx_node *idx;
+
+	idx = kmalloc(c->max_idx_node_sz, GFP_NOFS);
+	if (!idx)
+		return -ENOMEM;
+
+	err = ubifs_read_node(c, idx, UBIFS_IDX_NODE, len, lnum, offs);
+	if (!err)
+		err = unpack_znode(c, idx, lnum, offs, znode);
+	kfree(idx);
+	return err;
+}
+
+/**
+ * insert_znode - insert a freshly read znode to the TNC cache.
+ * @c: UBIFS file-system description object
+ * @zbr: znode branch
+ * @znode: znode to insert
+ * @parent: znode's parent
+ * @iip: index in parent
+ */
+static void insert_znode(struct ubifs_info *c, struct ubifs_zbranch *zbr,
+			 struct ubifs_znode *znode, struct ubifs_znode *parent,
+			 int iip)
+{
+	atomic_long_inc(&c->clean_zn_cnt);
+
+	/*
+	 * Increment the global clean znode counter as well. It is OK that
+	 * global and per-FS clean znode counters may be inconsistent for some
+	 * short time (because we might be preempted at this point), the global
+	 * one is only used in shrinker.
+	 */
+	atomic_long_inc(&ubifs_clean_zn_cnt);
+
+	zbr->znode = znode;
+	znode->parent = parent;
+	znode->time = get_seconds();
+	znode->iip = iip;
+}
+
 /**
  * ubifs_load_znode - load znode to TNC cache.
  * @c: UBIFS file-system description object
@@ -423,21 +467,7 @@ struct ubifs_znode *ubifs_load_znode(struct ubifs_info *c,
 	if (err)
 		goto out;
 
-	atomic_long_inc(&c->clean_zn_cnt);
-
-	/*
-	 * Increment the global clean znode counter as well. It is OK that
-	 * global and per-FS clean znode counters may be inconsistent for some
-	 * short time (because we might be preempted at this point), the global
-	 * one is only used in shrinker.
-	 */
-	atomic_long_inc(&ubifs_clean_zn_cnt);
-
-	zbr->znode = znode;
-	znode->parent = parent;
-	znode->time = get_seconds();
-	znode->iip = iip;
-
+	insert_znode(c, zbr, znode, parent, iip);
 	return znode;
 
 out:
@@ -445,6 +475,80 @@ out:
 	return ERR_PTR(err);
 }
 
+/**
+ * ubifs_prefetch_znodes - load several sibling znodes in one go.
+ * @c: UBIFS file-system description object
+ * @parent: parent znode
+ * @iip: index in parent of the first znode to load
+ *
+ * The commit writes the indexing nodes of a subtree next to each other, so the
+ * children of a znode often sit back to back in the same LEB. Scans of the TNC
+ * (readdir, bulk-read) would load them one by one, paying a flash read for
+ * each. This function loads the child at @iip and the following ones which
+ * are not in the TNC cache and directly follow it on the media, with a single
+ * read. It is only an optimization, so it does not report errors: it returns
+ * the number of znodes loaded, and the caller loads @iip in the usual way if
+ * that is zero.
+ */
+int ubifs_prefetch_znodes(struct ubifs_info *c, struct ubifs_znode *parent,
+			  int iip)
+{
+	struct ubifs_zbranch *zbr = &parent->zbranch[iip];
+	int i, err, cnt, lnum = zbr->lnum, offs = zbr->offs, end = zbr->offs;
+	int loaded = 0;
+	void *buf;
+
+	ubifs_assert(mutex_is_locked(&c->tnc_mutex));
+	ubifs_assert(parent->level > 0);
+	for (cnt = 0; cnt < UBIFS_TNC_PREFETCH; cnt++) {
+		if (iip + cnt >= parent->child_cnt)
+			break;
+		zbr = &parent->zbranch[iip + cnt];
+		if (zbr->znode || zbr->lnum != lnum || zbr->offs != end)
+			break;
+		end = ALIGN(zbr->offs + zbr->len, 8);
+	}
+	if (cnt < 2)
+		return 0;
+	zbr = &parent->zbranch[iip + cnt - 1];
+	end = zbr->offs + zbr->len;
+
+	buf = kmalloc(end - offs, GFP_NOFS | __GFP_NOWARN);
+	if (!buf)
+		return 0;
+	err = ubi_read(c->ubi, lnum, buf, offs, end - offs);
+	if (err)
+		goto out;
+
+	for (i = 0; i < cnt; i++) {
+		struct ubifs_idx_node *idx;
+		struct ubifs_znode *znode;
+
+		zbr = &parent->zbranch[iip + i];
+		idx = buf + zbr->offs - offs;
+		if (idx->ch.node_type != UBIFS_IDX_NODE ||
+		    le32_to_cpu(idx->ch.len) != zbr->len ||
+		    ubifs_check_node(c, idx, lnum, zbr->offs, 1, 0))
+			break;
+
+		znode = kzalloc(c->max_znode_sz, GFP_NOFS);
+		if (!znode)
+			break;
+		if (unpack_znode(c, idx, lnum, zbr->offs, znode)) {
+			kfree(znode);
+			break;
+		}
+		insert_znode(c, zbr, znode, parent, iip + i);
+		loaded += 1;
+	}
+	if (loaded > 1)
+		atomic_long_add(loaded - 1, &c->znode_prefetch);
+
+out:
+	kfree(buf);
+	return loaded;
+}
+
 /**
  * ubifs_tnc_read_node - read a leaf node from the flash media.
  * @c: UBIFS file-system description object
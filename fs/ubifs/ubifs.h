@@ -55,6 +55,32 @@
 /* UBIFS file system VFS magic number */
 #define UBIFS_SUPER_MAGIC 0x24051905
 
+/*
+ * UBIFS-specific ioctls. The argument is an 'int' compressor type
+ * (%UBIFS_COMPR_LZO, etc). Set on a regular file, it selects the compressor
+ * for data written from now on. Set on a directory, it becomes the compressor
+ * of new files and sub-directories created in it; %UBIFS_COMPR_NONE there means
+ * "use the mount default" (clear %FS_COMPR_FL to store a tree uncompressed).
+ */
+#define UBIFS_IOC_GETCOMPR _IOR('O', 0x20, int)
+#define UBIFS_IOC_SETCOMPR _IOW('O', 0x21, int)
+
+/*
+ * Data which compresses by less than 1/2^%UBIFS_MIN_COMPR_GAIN_SHIFT of its
+ * length (and at least %UBIFS_MIN_COMPRESS_DIFF bytes) is stored
+ * uncompressed, because reading it back would cost a decompression for
+ * nearly nothing.
+ */
+#define UBIFS_MIN_COMPR_GAIN_SHIFT 4
+
+/*
+ * After %UBIFS_COMPR_POOR_MAX data nodes of an inode in a row were stored
+ * uncompressed, UBIFS writes the next %UBIFS_COMPR_SKIP nodes of this inode
+ * without even trying to compress them (e.g., media files), then tries again.
+ */
+#define UBIFS_COMPR_POOR_MAX 8
+#define UBIFS_COMPR_SKIP 64
+
 /* Number of UBIFS blocks per VFS page */
 #define UBIFS_BLOCKS_PER_PAGE (PAGE_CACHE_SIZE / UBIFS_BLOCK_SIZE)
 #define UBIFS_BLOCKS_PER_PAGE_SHIFT (PAGE_CACHE_SHIFT - UBIFS_BLOCK_SHIFT)
@@ -152,6 +178,25 @@
 /* Maximum number of data nodes to bulk-read */
 #define UBIFS_MAX_BULK_READ 32
 
+/*
+ * How far the data nodes of the next inode may be from the end of the data
+ * nodes of the inode being bulk-read, for bulk-read to take them too. This
+ * allows for one inode node in between.
+ */
+#define UBIFS_BU_NEXT_INO_GAP ALIGN(UBIFS_MAX_INO_NODE_SZ, 8)
+
+/* Maximum number of sibling znodes to read in one go */
+#define UBIFS_TNC_PREFETCH 8
+
+/*
+ * Clean pnodes are freed when there are more than this many in memory (that is
+ * the LPT of 8192 LEBs). Pnodes with LEB properties on a heap or a list stay,
+ * so this is a soft limit. At most @UBIFS_LPT_EVICT_SCAN pnodes are looked at
+ * each time the lprops lock is released.
+ */
+#define UBIFS_LPT_CACHE_PNODES 2048
+#define UBIFS_LPT_EVICT_SCAN 8
+
 /*
  * Lockdep classes for UBIFS inode @ui_mutex.
  */
@@ -349,6 +394,9 @@ struct ubifs_gced_idx_leb {
  * @ui_size: inode size used by UBIFS when writing to flash
  * @flags: inode flags (@UBIFS_COMPR_FL, etc)
  * @compr_type: default compression type used for this inode
+ * @compr_poor: number of data nodes in a row which did not compress
+ * @compr_skip: number of data nodes still to be written without trying to
+ *              compress them
  * @last_page_read: page number of last page read (for bulk read)
  * @read_in_a_row: number of consecutive pages read in a row (for bulk read)
  * @data_len: length of the data attached to the inode
@@ -399,6 +447,8 @@ struct ubifs_inode {
 	loff_t synced_i_size;
 	loff_t ui_size;
 	int flags;
+	unsigned short compr_poor;
+	unsigned short compr_skip;
 	pgoff_t last_page_read;
 	pgoff_t read_in_a_row;
 	int data_len;
@@ -549,6 +599,7 @@ struct ubifs_cnode {
  * @iip: index in parent
  * @level: level in the tree (always zero for pnodes)
  * @num: node number
+ * @lru: link in the list of pnodes in memory (@c->pnode_lru)
  * @lprops: LEB properties array
  */
 struct ubifs_pnode {
@@ -558,6 +609,7 @@ struct ubifs_pnode {
 	int iip;
 	int level;
 	int num;
+	struct list_head lru;
 	struct ubifs_lprops lprops[UBIFS_LPT_FANOUT];
 };
 
@@ -776,6 +828,8 @@ struct ubifs_znode {
  * @cnt: number of data nodes for bulk read
  * @blk_cnt: number of data blocks including holes
  * @oef: end of file reached
+ * @next_inum: inode number of the next inode if its data nodes were read too
+ * @next_n: index of the first data node of that inode in @zbranch
  */
 struct bu_info {
 	union ubifs_key key;
@@ -786,6 +840,8 @@ struct bu_info {
 	int cnt;
 	int blk_cnt;
 	int eof;
+	ino_t next_inum;
+	int next_n;
 };
 
 /**
@@ -1031,6 +1087,8 @@ struct ubifs_debug_info;
  * @dirty_pg_cnt: number of dirty pages (not used)
  * @dirty_zn_cnt: number of dirty znodes
  * @clean_zn_cnt: number of clean znodes
+ * @znode_prefetch: number of znodes read ahead by 'ubifs_prefetch_znodes()'
+ * @bu_next_pages: number of pages of other inodes populated by bulk-read
  *
  * @budg_idx_growth: amount of bytes budgeted for index growth
  * @budg_data_growth: amount of bytes budgeted for cached data
@@ -1120,6 +1178,9 @@ struct ubifs_debug_info;
  * @nnode_cnt: number of nnodes
  * @lpt_hght: height of the LPT
  * @pnodes_have: number of pnodes in memory
+ * @pnode_lru: pnodes in memory, least recently used first
+ * @pnode_reads: number of pnodes read from the media
+ * @pnode_evicts: number of clean pnodes freed to bound @pnodes_have
  *
  * @lp_mutex: protects lprops table and all the other lprops-related fields
  * @lpt_lnum: LEB number of the root nnode of the LPT
@@ -1272,6 +1333,8 @@ struct ubifs_info {
 	atomic_long_t dirty_pg_cnt;
 	atomic_long_t dirty_zn_cnt;
 	atomic_long_t clean_zn_cnt;
+	atomic_long_t znode_prefetch;
+	atomic_long_t bu_next_pages;
 
 	long long budg_idx_growth;
 	long long budg_data_growth;
@@ -1351,6 +1414,9 @@ struct ubifs_info {
 	int nnode_cnt;
 	int lpt_hght;
 	int pnodes_have;
+	struct list_head pnode_lru;
+	unsigned long pnode_reads;
+	unsigned long pnode_evicts;
 
 	struct mutex lp_mutex;
 	int lpt_lnum;
@@ -1566,6 +1632,8 @@ long ubifs_destroy_tnc_subtree(struct ubifs_znode *zr);
 struct ubifs_znode *ubifs_load_znode(struct ubifs_info *c,
 				     struct ubifs_zbranch *zbr,
 				     struct ubifs_znode *parent, int iip);
+int ubifs_prefetch_znodes(struct ubifs_info *c, struct ubifs_znode *parent,
+			  int iip);
 int ubifs_tnc_read_node(struct ubifs_info *c, struct ubifs_zbranch *zbr,
 			void *node);
 
@@ -1640,6 +1708,7 @@ struct ubifs_nnode *ubifs_get_nnode(struct ubifs_info *c,
 int ubifs_read_nnode(struct ubifs_info *c, struct ubifs_nnode *parent, int iip);
 void ubifs_add_lpt_dirt(struct ubifs_info *c, int lnum, int dirty);
 void ubifs_add_nnode_dirt(struct ubifs_info *c, struct ubifs_nnode *nnode);
+void ubifs_lpt_evict(struct ubifs_info *c);
 uint32_t ubifs_unpack_bits(uint8_t **addr, int *pos, int nrbits);
 struct ubifs_nnode *ubifs_first_nnode(struct ubifs_info *c, int *hght);
 /* Needed only in debugging code in lpt_commit.c */
@@ -1724,8 +1793,8 @@ int __init ubifs_compressors_init(void);
 void ubifs_compressors_exit(void);
 void ubifs_compress(const void *in_buf, int in_len, void *out_buf, int *out_len,
 		    int *compr_type);
-int ubifs_decompress(const void *buf, int len, void *out, int *out_len,
-		     int compr_type);
+int ubifs_decompress(const struct ubifs_info *c, const void *buf, int len,
+		     void *out, int *out_len, int compr_type);
 
 #include "debug.h"
 #include "misc.h"
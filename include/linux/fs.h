@@ -891,6 +891,10 @@ struct file_ra_state {
 	unsigned int ra_pages;		/* Maximum readahead window */
 	unsigned int mmap_miss;		/* Cache miss stat for mmap accesses */
 	loff_t prev_pos;		/* Cache last read() position */
+
+	pgoff_t last_miss;		/* Offset of the last random miss */
+	long miss_stride;		/* ... and its distance to the one
+					   before, for strided streams */
 };
 
 /*
@@ -0,0 +1,77 @@
+/*++
+	include/linux/i2c-algo-wmt.h
+
+	Some descriptions of such software. Copyright (c) 2008 WonderMedia Technologies, Inc.
+
+	This program is free software: you can redistribute it and/or modify it under the
+	terms of the GNU General Public License as published by the Free Software Foundation,
+	either version 2 of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful, but WITHOUT
+	ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+	PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License along with
+	this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	WonderMedia Technologies, Inc.
+	10F, 529, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C.
+--*/
+#ifndef _LINUX_I2C_ALGO_WMT_H
+#define _LINUX_I2C_ALGO_WMT_H
+
+#include <linux/i2c.h>
+#include <linux/wait.h>
+#include <linux/spinlock.h>
+#include <linux/interrupt.h>
+
+#include <mach/hardware.h>
+
+/* Per adapter counters, shown in /proc/wmt-i2c<nr> */
+struct wmt_i2c_stats {
+	unsigned long xfers;		/* master_xfer calls */
+	unsigned long msgs;
+	unsigned long bytes;
+	unsigned long errors;		/* failed master_xfer calls */
+	unsigned long nack;
+	unsigned long scl_timeout;	/* controller SCL time-out */
+	unsigned long sw_timeout;	/* no interrupt in time */
+	unsigned long bus_busy;
+	unsigned int lat_last;		/* us, successful xfers only */
+	unsigned int lat_max;
+	unsigned long long lat_sum;
+};
+
+/*
+ * One I2C controller. The bus driver fills regs, irq_no, div and
+ * i2c_mode, the algo runs a whole i2c_msg array from the interrupt
+ * handler and sleeps once per transfer.
+ */
+struct wmt_i2c_port {
+	struct i2c_regs_s *regs;
+	int irq_no;
+	unsigned short div;		/* I2C_DIV_REG value */
+	enum i2c_mode_e i2c_mode;
+	int enabled;			/* 0 in slave mode */
+
+	wait_queue_head_t wait;
+	spinlock_t lock;
+
+	/* transfer state, msgs is NULL when nothing is in flight */
+	struct i2c_msg *msgs;
+	int num;
+	int cur;			/* message on the wire */
+	int pos;			/* byte in that message */
+	int result;
+
+	struct wmt_i2c_stats stats;
+	char proc_name[16];
+};
+
+extern void wmt_i2c_port_init(struct wmt_i2c_port *port,
+	unsigned int base, int irq_no, unsigned short div);
+extern void wmt_i2c_port_reset(struct wmt_i2c_port *port);
+extern void wmt_i2c_port_set_mode(struct wmt_i2c_port *port, enum i2c_mode_e mode);
+extern int wmt_i2c_port_xfer(struct wmt_i2c_port *port, struct i2c_msg msgs[], int num);
+extern irqreturn_t wmt_i2c_port_handler(int this_irq, void *dev_id);
+
+#endif /* _LINUX_I2C_ALGO_WMT_H */
@@ -1068,6 +1068,9 @@ struct ff_effect {
  * @h_list: list of input handles associated with the device. When
  *	accessing the list dev->mutex must be held
  * @node: used to place the device onto input_dev_list
+ * @timestamp: time the events up to the next SYN_REPORT were sampled,
+ *	set by drivers which read the hardware some time after its
+ *	interrupt. Zero means the time of delivery is used
  */
 struct input_dev {
 	const char *name;
@@ -1129,6 +1132,8 @@ struct input_dev {
 
 	struct list_head	h_list;
 	struct list_head	node;
+
+	ktime_t timestamp;
 };
 #define to_input_dev(d) container_of(d, struct input_dev, dev)
 
@@ -1338,6 +1343,18 @@ static inline void input_mt_sync(struct input_dev *dev)
 	input_event(dev, EV_SYN, SYN_MT_REPORT, 0);
 }
 
+/**
+ * input_set_timestamp() - set the sampling time of the current packet
+ * @dev: input device
+ * @timestamp: CLOCK_MONOTONIC time, usually taken in the interrupt
+ *
+ * Applies to the events up to and including the next SYN_REPORT.
+ */
+static inline void input_set_timestamp(struct input_dev *dev, ktime_t timestamp)
+{
+	dev->timestamp = timestamp;
+}
+
 void input_set_capability(struct input_dev *dev, unsigned int type, unsigned int code);
 
 static inline void input_set_abs_params(struct input_dev *dev, int axis, int min, int max, int fuzz, int flat)
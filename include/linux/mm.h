@@ -186,6 +186,11 @@ struct vm_operations_struct {
 	void (*close)(struct vm_area_struct * area);
 	int (*fault)(struct vm_area_struct *vma, struct vm_fault *vmf);
 
+	/* map the pages around a read fault which are in the page cache
+	 * already, called with the page table lock held */
+	void (*map_pages)(struct vm_area_struct *vma, unsigned long address,
+			  pte_t *pte, pgoff_t pgoff, unsigned long nr);
+
 	/* notification that a previously read-only page is about to become
 	 * writable, if an error is returned it will cause a SIGBUS */
 	int (*page_mkwrite)(struct vm_area_struct *vma, struct vm_fault *vmf);
@@ -332,6 +337,7 @@ void put_page(struct page *page);
 void put_pages_list(struct list_head *pages);
 
 void split_page(struct page *page, unsigned int order);
+int split_free_page(struct page *page);
 
 /*
  * Compound pages have a destructor function.  Provide a
@@ -1164,6 +1170,8 @@ extern void truncate_inode_pages_range(struct address_space *,
 
 /* generic vm_area_ops exported for stackable file systems */
 extern int filemap_fault(struct vm_area_struct *, struct vm_fault *);
+extern void filemap_map_pages(struct vm_area_struct *vma, unsigned long address,
+			      pte_t *pte, pgoff_t pgoff, unsigned long nr);
 
 /* mm/page-writeback.c */
 int write_one_page(struct page *page, int wait);
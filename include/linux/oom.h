@@ -32,6 +32,9 @@ extern int unregister_oom_notifier(struct notifier_block *nb);
 
 extern bool oom_killer_disabled;
 
+/* bumped on every /proc/<pid>/oom_adj write */
+extern atomic_t oom_adj_generation;
+
 static inline void oom_killer_disable(void)
 {
 	oom_killer_disabled = true;
@@ -0,0 +1,108 @@
+/*++
+	include/linux/wmt_ts_core.h
+
+	Some descriptions of such software. Copyright (c) 2008 WonderMedia Technologies, Inc.
+
+	This program is free software: you can redistribute it and/or modify it under the
+	terms of the GNU General Public License as published by the Free Software Foundation,
+	either version 2 of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful, but WITHOUT
+	ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+	PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License along with
+	this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	WonderMedia Technologies, Inc.
+	10F, 529, Chung-Cheng Road, Hsin-Tien, Taipei 231, R.O.C.
+--*/
+#ifndef _LINUX_WMT_TS_CORE_H
+#define _LINUX_WMT_TS_CORE_H
+
+#include <linux/input.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
+
+#define WMT_TS_MAX_CONTACTS	10
+#define WMT_TS_MAX_BATCH	8	/* frames read per interrupt */
+#define WMT_TS_STAMP_RING	16	/* power of 2 */
+
+struct wmt_ts_contact {
+	u16 x;
+	u16 y;
+	u8 width;			/* 0 if not measured */
+	u8 id;				/* contact id of the controller */
+};
+
+/* All contacts of one scan of the panel */
+struct wmt_ts_frame {
+	int count;
+	struct wmt_ts_contact contact[WMT_TS_MAX_CONTACTS];
+};
+
+struct wmt_ts;
+
+struct wmt_ts_ops {
+	/*
+	 * Read up to max frames out of the controller FIFO, oldest first.
+	 * Runs in the IRQ thread and may sleep on the bus.
+	 * Returns the number of frames or a negative error.
+	 */
+	int (*read_frames)(struct wmt_ts *ts, struct wmt_ts_frame *frames, int max);
+	/*
+	 * Optional, hard IRQ: return 0 if the (shared) interrupt is not
+	 * ours, else quiet the controller until irq_done.
+	 */
+	int (*irq_ack)(struct wmt_ts *ts);
+	/* optional, IRQ thread: undo irq_ack after the FIFO was read */
+	void (*irq_done)(struct wmt_ts *ts);
+};
+
+/* contact id to tracking id, like MT protocol B slots */
+struct wmt_ts_slot {
+	int tracking_id;		/* -1 when free */
+	u8 id;
+	u8 seen;
+};
+
+struct wmt_ts_stats {
+	unsigned int irqs;
+	unsigned int frames;
+	unsigned int stamps_lost;	/* stamp ring full, time extrapolated */
+	unsigned int batch_max;		/* most frames read in one interrupt */
+	unsigned int contacts_dropped;	/* more contacts than slots */
+	unsigned int read_errors;
+	unsigned int lat_last;		/* us from interrupt to report */
+	unsigned int lat_max;
+};
+
+struct wmt_ts {
+	/* filled by the driver */
+	struct input_dev *input;
+	const struct wmt_ts_ops *ops;
+	void *priv;
+	int irq;
+	int max_contacts;		/* <= WMT_TS_MAX_CONTACTS */
+	int batch;			/* frames per read, <= WMT_TS_MAX_BATCH, 0 is 1 */
+	unsigned int frame_ns;		/* scan period, 0 if unknown */
+
+	/* private to wmt_ts_core */
+	/*
+	 * Interrupt times, the hard IRQ handler is the only writer of
+	 * stamp_head and the IRQ thread the only writer of stamp_tail.
+	 */
+	ktime_t stamp[WMT_TS_STAMP_RING];
+	unsigned int stamp_head;
+	unsigned int stamp_tail;
+	struct wmt_ts_frame frames[WMT_TS_MAX_BATCH];
+	struct wmt_ts_slot slot[WMT_TS_MAX_CONTACTS];
+	int next_tracking_id;
+	struct wmt_ts_stats stats;
+};
+
+extern void wmt_ts_set_abs(struct wmt_ts *ts, int x_max, int y_max, int width_max);
+extern int wmt_ts_register(struct wmt_ts *ts, unsigned long irqflags, const char *name);
+extern void wmt_ts_unregister(struct wmt_ts *ts);
+extern void wmt_ts_release_all(struct wmt_ts *ts);
+
+#endif /* _LINUX_WMT_TS_CORE_H */
@@ -0,0 +1,70 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM lowmemorykiller
+
+#if !defined(_TRACE_LOWMEMORYKILLER_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_LOWMEMORYKILLER_H
+
+#include <linux/tracepoint.h>
+#include <linux/sched.h>
+
+/**
+ * lowmem_kill - the low memory killer sent SIGKILL to a task
+ * @p:		task killed
+ * @oom_adj:	its oom_adj
+ * @tasksize:	its rss in pages
+ * @min_adj:	lowest oom_adj that could be killed
+ * @reason:	0 below minfree, 1 below minfree counting no page cache
+ *		as free because reclaim is not getting anything back
+ * @other_free:	free pages above the reserves
+ * @other_file:	page cache pages
+ * @efficiency:	percent of the scanned pages reclaimed recently
+ * @latency_ns:	time from entering the shrinker to the kill
+ */
+TRACE_EVENT(lowmem_kill,
+
+	TP_PROTO(struct task_struct *p, int oom_adj, int tasksize, int min_adj,
+		 int reason, int other_free, int other_file, int efficiency,
+		 s64 latency_ns),
+
+	TP_ARGS(p, oom_adj, tasksize, min_adj, reason, other_free, other_file,
+		efficiency, latency_ns),
+
+	TP_STRUCT__entry(
+		__array( char,	comm,	TASK_COMM_LEN	)
+		__field( pid_t,	pid			)
+		__field( int,	oom_adj			)
+		__field( int,	tasksize		)
+		__field( int,	min_adj			)
+		__field( int,	reason			)
+		__field( int,	other_free		)
+		__field( int,	other_file		)
+		__field( int,	efficiency		)
+		__field( s64,	latency_ns		)
+	),
+
+	TP_fast_assign(
+		memcpy(__entry->comm, p->comm, TASK_COMM_LEN);
+		__entry->pid		= p->pid;
+		__entry->oom_adj	= oom_adj;
+		__entry->tasksize	= tasksize;
+		__entry->min_adj	= min_adj;
+		__entry->reason		= reason;
+		__entry->other_free	= other_free;
+		__entry->other_file	= other_file;
+		__entry->efficiency	= efficiency;
+		__entry->latency_ns	= latency_ns;
+	),
+
+	TP_printk("pid=%d comm=%s adj=%d size=%d min_adj=%d reason=%s "
+		  "free=%d file=%d efficiency=%d%% latency=%lldns",
+		  __entry->pid, __entry->comm, __entry->oom_adj,
+		  __entry->tasksize, __entry->min_adj,
+		  __entry->reason ? "reclaim" : "minfree",
+		  __entry->other_free, __entry->other_file,
+		  __entry->efficiency, __entry->latency_ns)
+);
+
+#endif /* _TRACE_LOWMEMORYKILLER_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -0,0 +1,84 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM wmt_mmio
+
+#if !defined(_TRACE_WMT_MMIO_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_WMT_MMIO_H
+
+#include <linux/tracepoint.h>
+#include <mach/wmt_mmio.h>
+
+/**
+ * wmt_mmio_access - register access of a WMT driver
+ * @dev:	WMT_MMIO_xxx block of the register
+ * @addr:	physical address
+ * @val:	value read or written
+ * @flags:	WMT_MMIO_WRITE and access size in bytes
+ * @ip:		code doing the access
+ */
+TRACE_EVENT(wmt_mmio_access,
+
+	TP_PROTO(int dev, unsigned long addr, u32 val, int flags,
+		 unsigned long ip),
+
+	TP_ARGS(dev, addr, val, flags, ip),
+
+	TP_STRUCT__entry(
+		__field( int,		dev	)
+		__field( unsigned long,	addr	)
+		__field( u32,		val	)
+		__field( int,		flags	)
+		__field( u32,		ost	)
+		__field( unsigned long,	ip	)
+	),
+
+	TP_fast_assign(
+		__entry->dev	= dev;
+		__entry->addr	= addr;
+		__entry->val	= val;
+		__entry->flags	= flags;
+		__entry->ost	= wmt_read_oscr();
+		__entry->ip	= ip;
+	),
+
+	TP_printk("dev=%d %c%d 0x%08lx=0x%08x ost=%u %pS",
+		  __entry->dev, (__entry->flags & WMT_MMIO_WRITE) ? 'W' : 'R',
+		  __entry->flags & 0x7f, __entry->addr, __entry->val,
+		  __entry->ost, (void *)__entry->ip)
+);
+
+/**
+ * wmt_mmio_seq - begin and end of a traced register sequence
+ * @name:	name of the sequence, usually the function
+ * @begin:	1 at the begin, 0 at the end
+ * @ost:	OS timer count, 3MHz
+ * @ticks:	OS timer ticks since the begin, 0 at the begin
+ */
+TRACE_EVENT(wmt_mmio_seq,
+
+	TP_PROTO(const char *name, int begin, u32 ost, u32 ticks),
+
+	TP_ARGS(name, begin, ost, ticks),
+
+	TP_STRUCT__entry(
+		__string( name,		name	)
+		__field( int,		begin	)
+		__field( u32,		ost	)
+		__field( u32,		ticks	)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->begin	= begin;
+		__entry->ost	= ost;
+		__entry->ticks	= ticks;
+	),
+
+	TP_printk("%s %s ost=%u ticks=%u (%u us)", __get_str(name),
+		  __entry->begin ? "begin" : "end", __entry->ost,
+		  __entry->ticks, __entry->ticks / 3)
+);
+
+#endif /* _TRACE_WMT_MMIO_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -34,6 +34,11 @@
 #else
 #include <linux/decompress/unlzma.h>
 #include <linux/slab.h>
+#ifdef CONFIG_SQUASHFS_LZMA
+#include <linux/module.h>
+/* Squashfs decompresses with it after boot */
+#define INIT
+#endif
 #endif /* STATIC */
 
 #include <linux/decompress/mm.h>
@@ -288,6 +293,7 @@ struct writer {
 	size_t global_pos;
 	int(*flush)(void*, unsigned int);
 	struct lzma_header *header;
+	int error;		/* corrupt stream */
 };
 
 struct cstate {
@@ -308,6 +314,13 @@ static inline uint8_t INIT peek_old_byte(struct writer *wr,
 		int32_t pos;
 		while (offs > wr->header->dict_size)
 			offs -= wr->header->dict_size;
+		/* nothing before the start of the output to refer to */
+		if (offs > wr->buffer_pos) {
+			if (!wr->error)
+				error("bad match distance");
+			wr->error = 1;
+			return 0;
+		}
 		pos = wr->buffer_pos - offs;
 		return wr->buffer[pos];
 	} else {
@@ -571,6 +584,7 @@ STATIC inline int INIT unlzma(unsigned char *buf, int in_len,
 	wr.global_pos = 0;
 	wr.previous_byte = 0;
 	wr.buffer_pos = 0;
+	wr.error = 0;
 
 	rc_init(&rc, fill, inbuf, in_len);
 
@@ -580,8 +594,10 @@ STATIC inline int INIT unlzma(unsigned char *buf, int in_len,
 		((unsigned char *)&header)[i] = *rc.ptr++;
 	}
 
-	if (header.pos >= (9 * 5 * 5))
+	if (header.pos >= (9 * 5 * 5)) {
 		error("bad header");
+		goto exit_1;
+	}
 
 	mi = 0;
 	lc = header.pos;
@@ -635,13 +651,16 @@ STATIC inline int INIT unlzma(unsigned char *buf, int in_len,
 			if (cst.rep0 == 0)
 				break;
 		}
+		if (wr.error || rc.buffer_size <= 0)
+			break;
 	}
 
 	if (posp)
 		*posp = rc.ptr-rc.buffer;
 	if (wr.flush)
 		wr.flush(wr.buffer, wr.buffer_pos);
-	ret = 0;
+	/* corrupt match distance or input ran out */
+	ret = (wr.error || rc.buffer_size <= 0) ? -1 : 0;
 	large_free(p);
 exit_2:
 	if (!output)
@@ -653,6 +672,10 @@ exit_0:
 	return ret;
 }
 
+#ifdef CONFIG_SQUASHFS_LZMA
+EXPORT_SYMBOL(unlzma);
+#endif
+
 #ifdef PREBOOT
 STATIC int INIT decompress(unsigned char *buf, int in_len,
 			      int(*fill)(void*, unsigned int),
@@ -0,0 +1,464 @@
+/*
+ * mm/boot_prefetch.c
+ *
+ * Boot prefetch: record which file pages a boot has to read from storage,
+ * and read them all ahead, sorted, at the next boot.
+ *
+ * Recording hooks the mm_filemap_miss tracepoint of mm/filemap.c and keeps
+ * the missed ranges for the first seconds after it starts, either from the
+ * kernel command line (boot_prefetch=<seconds>) or with
+ *
+ *	# echo "record 30" > /proc/boot_prefetch
+ *
+ * Once it is over, /proc/boot_prefetch lists the ranges sorted and merged
+ * per file, files in the order they were first missed:
+ *
+ *	<first page> <number of pages> <path>
+ *
+ * and is saved to a file.  Early in the next boot, before the services are
+ * started, the list is replayed with
+ *
+ *	# echo "replay /data/boot_prefetch" > /proc/boot_prefetch
+ *
+ * A kernel thread then issues the reads through force_page_cache_readahead(),
+ * so they go to the device in large requests ahead of the faults which
+ * would otherwise read the same pages one at a time.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/mm.h>
+#include <linux/hash.h>
+#include <linux/kthread.h>
+#include <linux/mutex.h>
+#include <linux/namei.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/spinlock.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <trace/events/filemap.h>
+
+#include <asm/uaccess.h>
+
+#define BP_MAX_FILES	1024
+#define BP_MAX_RANGES	8192
+#define BP_HASH_BITS	8
+#define BP_MAX_LIST	(1 << 20)	/* largest list replayed */
+
+struct bp_file {
+	struct hlist_node hash;
+	struct inode *inode;
+	struct path path;		/* pinned while recording */
+	char *name;			/* its path once recording is over */
+	unsigned int last;		/* its last range, for merging */
+};
+
+struct bp_range {
+	unsigned int file;
+	unsigned int nr;
+	pgoff_t start;
+};
+
+static struct bp_file *bp_files;
+static struct bp_range *bp_ranges;
+static struct hlist_head bp_hash[1 << BP_HASH_BITS];
+static unsigned int bp_nr_files, bp_nr_ranges;
+static unsigned long bp_dropped;
+
+static int bp_recording;
+static int bp_record_secs __initdata;
+static DEFINE_SPINLOCK(bp_lock);
+static DEFINE_MUTEX(bp_mutex);		/* serializes the commands */
+
+static void bp_stop_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(bp_stop_work, bp_stop_fn);
+
+/*
+ * mm_filemap_miss probe.  Called with preemption disabled: the file's path
+ * is only pinned here, it is turned into a name when recording stops.
+ */
+static void bp_miss(struct file *file, pgoff_t index, unsigned long nr)
+{
+	struct inode *inode = file->f_mapping->host;
+	struct hlist_head *head = &bp_hash[hash_ptr(inode, BP_HASH_BITS)];
+	struct hlist_node *node;
+	struct bp_file *f;
+	struct bp_range *r;
+
+	if (!nr)
+		return;
+
+	spin_lock(&bp_lock);
+	if (!bp_recording)
+		goto out;
+
+	hlist_for_each_entry(f, node, head, hash)
+		if (f->inode == inode)
+			goto found;
+
+	if (bp_nr_files == BP_MAX_FILES)
+		goto drop;
+	f = &bp_files[bp_nr_files++];
+	f->inode = inode;
+	f->path = file->f_path;
+	path_get(&f->path);
+	f->name = NULL;
+	f->last = BP_MAX_RANGES;
+	hlist_add_head(&f->hash, head);
+
+found:
+	/* sequential misses just grow the last range of the file */
+	if (f->last < bp_nr_ranges) {
+		r = &bp_ranges[f->last];
+		if (index <= r->start + r->nr && index + nr >= r->start) {
+			pgoff_t end = max_t(pgoff_t, r->start + r->nr,
+					    index + nr);
+
+			r->start = min(r->start, index);
+			r->nr = end - r->start;
+			goto out;
+		}
+	}
+
+	if (bp_nr_ranges == BP_MAX_RANGES)
+		goto drop;
+	r = &bp_ranges[bp_nr_ranges];
+	r->file = f - bp_files;
+	r->start = index;
+	r->nr = nr;
+	f->last = bp_nr_ranges++;
+out:
+	spin_unlock(&bp_lock);
+	return;
+drop:
+	bp_dropped++;
+	spin_unlock(&bp_lock);
+}
+
+static void bp_free(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < bp_nr_files; i++) {
+		if (bp_files[i].path.dentry)
+			path_put(&bp_files[i].path);
+		kfree(bp_files[i].name);
+	}
+	vfree(bp_files);
+	vfree(bp_ranges);
+	bp_files = NULL;
+	bp_ranges = NULL;
+	bp_nr_files = bp_nr_ranges = 0;
+	bp_dropped = 0;
+	memset(bp_hash, 0, sizeof(bp_hash));
+}
+
+static int bp_range_cmp(const void *a, const void *b)
+{
+	const struct bp_range *ra = a, *rb = b;
+
+	if (ra->file != rb->file)
+		return ra->file < rb->file ? -1 : 1;
+	if (ra->start != rb->start)
+		return ra->start < rb->start ? -1 : 1;
+	return 0;
+}
+
+/* Sort the ranges by file, then offset, and merge the overlapping ones. */
+static void bp_sort(void)
+{
+	struct bp_range *r, *prev = NULL;
+	unsigned int i, n = 0;
+
+	sort(bp_ranges, bp_nr_ranges, sizeof(*bp_ranges), bp_range_cmp, NULL);
+	for (i = 0; i < bp_nr_ranges; i++) {
+		r = &bp_ranges[i];
+		if (prev && prev->file == r->file &&
+		    r->start <= prev->start + prev->nr) {
+			if (r->start + r->nr > prev->start + prev->nr)
+				prev->nr = r->start + r->nr - prev->start;
+			continue;
+		}
+		prev = &bp_ranges[n++];
+		*prev = *r;
+	}
+	bp_nr_ranges = n;
+}
+
+/*
+ * Replace the pinned paths by their names, so that the recorded files do
+ * not hold their mounts busy or keep unlinked inodes around until "clear".
+ * Files which are gone by now get no name and are not listed.
+ */
+static void bp_name_files(void)
+{
+	struct bp_file *f;
+	char *buf, *p;
+	unsigned int i;
+
+	buf = (char *)__get_free_page(GFP_KERNEL);
+	for (i = 0; i < bp_nr_files; i++) {
+		f = &bp_files[i];
+		if (buf && !d_unlinked(f->path.dentry)) {
+			p = d_path(&f->path, buf, PAGE_SIZE);
+			if (!IS_ERR(p))
+				f->name = kstrdup(p, GFP_KERNEL);
+		}
+		path_put(&f->path);
+		f->path.dentry = NULL;
+		f->path.mnt = NULL;
+	}
+	free_page((unsigned long)buf);
+}
+
+/* Called with bp_mutex held. */
+static void bp_record_stop(void)
+{
+	if (!bp_recording)
+		return;
+
+	unregister_trace_mm_filemap_miss(bp_miss);
+	tracepoint_synchronize_unregister();
+	spin_lock(&bp_lock);
+	bp_recording = 0;
+	spin_unlock(&bp_lock);
+	bp_name_files();
+	bp_sort();
+	printk(KERN_INFO "boot_prefetch: recorded %u ranges of %u files, "
+	       "%lu dropped\n", bp_nr_ranges, bp_nr_files, bp_dropped);
+}
+
+static void bp_stop_fn(struct work_struct *work)
+{
+	mutex_lock(&bp_mutex);
+	bp_record_stop();
+	mutex_unlock(&bp_mutex);
+}
+
+/* Called with bp_mutex held. */
+static int bp_record_start(unsigned int secs)
+{
+	int ret;
+
+	if (bp_recording)
+		return -EBUSY;
+
+	bp_free();
+	bp_files = vmalloc(BP_MAX_FILES * sizeof(*bp_files));
+	bp_ranges = vmalloc(BP_MAX_RANGES * sizeof(*bp_ranges));
+	if (!bp_files || !bp_ranges) {
+		bp_free();
+		return -ENOMEM;
+	}
+
+	bp_recording = 1;
+	ret = register_trace_mm_filemap_miss(bp_miss);
+	if (ret) {
+		bp_recording = 0;
+		bp_free();
+		return ret;
+	}
+	schedule_delayed_work(&bp_stop_work, secs * HZ);
+	return 0;
+}
+
+/* Undo the escapes of seq_escape(), in place. */
+static void bp_unescape(char *s)
+{
+	char *d = s;
+
+	while (*s) {
+		if (s[0] == '\\' && s[1] >= '0' && s[1] <= '3' &&
+		    s[2] >= '0' && s[2] <= '7' && s[3] >= '0' && s[3] <= '7') {
+			*d++ = ((s[1] - '0') << 6) | ((s[2] - '0') << 3) |
+				(s[3] - '0');
+			s += 4;
+		} else
+			*d++ = *s++;
+	}
+	*d = 0;
+}
+
+static int bp_replay(void *data)
+{
+	char *name = data, *buf, *line, *next, *path, *last = NULL;
+	struct file *list, *file = NULL;
+	unsigned long start, nr, pages = 0;
+	int len, n;
+
+	list = filp_open(name, O_RDONLY | O_LARGEFILE, 0);
+	if (IS_ERR(list)) {
+		printk(KERN_WARNING "boot_prefetch: cannot open %s\n", name);
+		goto out_name;
+	}
+	buf = vmalloc(BP_MAX_LIST + 1);
+	if (!buf)
+		goto out_list;
+	len = kernel_read(list, 0, buf, BP_MAX_LIST);
+	if (len < 0)
+		len = 0;
+	buf[len] = 0;
+
+	for (line = buf; line; line = next) {
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = 0;
+		/* vsscanf() skips a trailing %n at the end of the input */
+		n = -1;
+		if (sscanf(line, "%lu %lu %n", &start, &nr, &n) < 2 || n < 0)
+			continue;
+		path = line + n;
+		bp_unescape(path);
+
+		/* the ranges of a file follow each other */
+		if (!last || strcmp(path, last)) {
+			if (file)
+				fput(file);
+			last = path;
+			file = filp_open(path, O_RDONLY | O_LARGEFILE, 0);
+			if (IS_ERR(file))
+				file = NULL;
+		}
+		if (!file)
+			continue;
+		force_page_cache_readahead(file->f_mapping, file, start, nr);
+		pages += nr;
+	}
+	if (file)
+		fput(file);
+	printk(KERN_INFO "boot_prefetch: read ahead %lu pages from %s\n",
+	       pages, name);
+	vfree(buf);
+out_list:
+	filp_close(list, NULL);
+out_name:
+	kfree(name);
+	return 0;
+}
+
+static void *bp_seq_start(struct seq_file *m, loff_t *pos)
+{
+	mutex_lock(&bp_mutex);
+	if (bp_recording || *pos >= bp_nr_ranges)
+		return NULL;
+	return &bp_ranges[*pos];
+}
+
+static void *bp_seq_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	if (++*pos >= bp_nr_ranges)
+		return NULL;
+	return &bp_ranges[*pos];
+}
+
+static void bp_seq_stop(struct seq_file *m, void *v)
+{
+	mutex_unlock(&bp_mutex);
+}
+
+static int bp_seq_show(struct seq_file *m, void *v)
+{
+	struct bp_range *r = v;
+	const char *name = bp_files[r->file].name;
+
+	if (!name)
+		return 0;
+	seq_printf(m, "%lu %u ", r->start, r->nr);
+	seq_escape(m, name, " \t\n\\");
+	seq_putc(m, '\n');
+	return 0;
+}
+
+static const struct seq_operations bp_seq_ops = {
+	.start	= bp_seq_start,
+	.next	= bp_seq_next,
+	.stop	= bp_seq_stop,
+	.show	= bp_seq_show,
+};
+
+static int bp_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &bp_seq_ops);
+}
+
+/*
+ * "record <seconds>", "stop", "clear" and "replay <list file>".
+ */
+static ssize_t bp_write(struct file *file, const char __user *buffer,
+			size_t count, loff_t *ppos)
+{
+	char buf[128], cmd[8], *str, *arg;
+	unsigned int secs;
+	int ret = 0, n;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, buffer, count))
+		return -EFAULT;
+	buf[count] = 0;
+	str = strstrip(buf);
+
+	n = -1;
+	if (sscanf(str, "%7s %n", cmd, &n) < 1)
+		return -EINVAL;
+	/* %n is not reached when the command has no argument */
+	arg = (n < 0) ? str + strlen(str) : str + n;
+
+	mutex_lock(&bp_mutex);
+	if (!strcmp(cmd, "record") && sscanf(arg, "%u", &secs) == 1 && secs)
+		ret = bp_record_start(secs);
+	else if (!strcmp(cmd, "stop")) {
+		cancel_delayed_work(&bp_stop_work);
+		bp_record_stop();
+	} else if (!strcmp(cmd, "clear") && !bp_recording)
+		bp_free();
+	else if (!strcmp(cmd, "replay") && *arg) {
+		struct task_struct *task;
+
+		arg = kstrdup(arg, GFP_KERNEL);
+		task = arg ? kthread_run(bp_replay, arg, "bprefetch") :
+			     ERR_PTR(-ENOMEM);
+		if (IS_ERR(task)) {
+			kfree(arg);
+			ret = PTR_ERR(task);
+		}
+	} else
+		ret = -EINVAL;
+	mutex_unlock(&bp_mutex);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations bp_fops = {
+	.open		= bp_open,
+	.read		= seq_read,
+	.write		= bp_write,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
+static int __init bp_setup(char *str)
+{
+	bp_record_secs = simple_strtoul(str, NULL, 0);
+	return 1;
+}
+__setup("boot_prefetch=", bp_setup);
+
+static int __init boot_prefetch_init(void)
+{
+	proc_create("boot_prefetch", S_IRUSR | S_IWUSR, NULL, &bp_fops);
+
+	if (bp_record_secs) {
+		mutex_lock(&bp_mutex);
+		if (bp_record_start(bp_record_secs))
+			printk(KERN_WARNING "boot_prefetch: cannot record\n");
+		mutex_unlock(&bp_mutex);
+	}
+	return 0;
+}
+fs_initcall(boot_prefetch_init);
@@ -34,8 +34,12 @@
 #include <linux/hardirq.h> /* for BUG_ON(!in_atomic()) only */
 #include <linux/memcontrol.h>
 #include <linux/mm_inline.h> /* for page_is_file_cache() */
+#include <linux/rmap.h>
 #include "internal.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/filemap.h>
+
 /*
  * FIXME: remove all knowledge of the buffer layer from the core VM
  */
@@ -470,7 +474,15 @@ int add_to_page_cache_lru(struct page *page, struct address_space *mapping,
 
 	ret = add_to_page_cache(page, mapping, offset, gfp_mask);
 	if (ret == 0) {
-		if (page_is_file_cache(page))
+		/*
+		 * A page evicted only recently goes straight to the active
+		 * list, see mm/workingset.c.
+		 */
+		if (page_is_file_cache(page) &&
+		    workingset_refault(mapping, offset)) {
+			workingset_activation(page);
+			lru_cache_add_lru(page, LRU_ACTIVE_FILE);
+		} else if (page_is_file_cache(page))
 			lru_cache_add_file(page);
 		else
 			lru_cache_add_active_anon(page);
@@ -970,6 +982,20 @@ static void shrink_readahead_size_eio(struct file *filp,
 	ra->ra_pages /= 4;
 }
 
+/*
+ * Report a miss at @index, with the readahead window it started when there
+ * is one, so the pages read around the miss are accounted for too.
+ */
+static inline void trace_filemap_miss(struct file *file,
+		struct file_ra_state *ra, pgoff_t index, unsigned long nr)
+{
+	if (index >= ra->start && index - ra->start < ra->size) {
+		index = ra->start;
+		nr = ra->size;
+	}
+	trace_mm_filemap_miss(file, index, nr);
+}
+
 /**
  * do_generic_file_read - generic file read routine
  * @filp:	the file to read
@@ -1015,14 +1041,18 @@ find_page:
 			page_cache_sync_readahead(mapping,
 					ra, filp,
 					index, last_index - index);
+			trace_filemap_miss(filp, ra, index, last_index - index);
 			page = find_get_page(mapping, index);
 			if (unlikely(page == NULL))
 				goto no_cached_page;
-		}
+			readahead_page_used(page, 0);
+		} else
+			readahead_page_used(page, 1);
 		if (PageReadahead(page)) {
 			page_cache_async_readahead(mapping,
 					ra, filp, page,
 					index, last_index - index);
+			trace_mm_filemap_miss(filp, ra->start, ra->size);
 		}
 		if (!PageUptodate(page)) {
 			if (inode->i_blkbits == PAGE_CACHE_SHIFT ||
@@ -1478,9 +1508,11 @@ static void do_async_mmap_readahead(struct vm_area_struct *vma,
 		return;
 	if (ra->mmap_miss > 0)
 		ra->mmap_miss--;
-	if (PageReadahead(page))
+	if (PageReadahead(page)) {
 		page_cache_async_readahead(mapping, ra, file,
 					   page, offset, ra->ra_pages);
+		trace_mm_filemap_miss(file, ra->start, ra->size);
+	}
 }
 
 /**
@@ -1521,6 +1553,7 @@ int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 		 * waiting for the lock.
 		 */
 		do_async_mmap_readahead(vma, ra, file, page, offset);
+		readahead_page_used(page, 1);
 		lock_page(page);
 
 		/* Did it get truncated? */
@@ -1532,12 +1565,14 @@ int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 	} else {
 		/* No page in the page cache at all */
 		do_sync_mmap_readahead(vma, ra, file, offset);
+		trace_filemap_miss(file, ra, offset, 1);
 		count_vm_event(PGMAJFAULT);
 		ret = VM_FAULT_MAJOR;
 retry_find:
 		page = find_lock_page(mapping, offset);
 		if (!page)
 			goto no_cached_page;
+		readahead_page_used(page, 0);
 	}
 
 	/*
@@ -1611,8 +1646,84 @@ page_not_uptodate:
 }
 EXPORT_SYMBOL(filemap_fault);
 
+/**
+ * filemap_map_pages - map cached pages around a read fault
+ * @vma:	vma in which the fault was taken
+ * @address:	user address of the first page
+ * @pte:	its page table entry, the page table lock is held
+ * @pgoff:	its offset into the file
+ * @nr:		number of pages
+ *
+ * Executables and libraries are faulted in at random, a few pages at a
+ * time, and read-around has usually brought the pages next to the faulting
+ * one into the page cache already.  Mapping them here costs much less than
+ * taking a fault for each one later.  Pages which are not up to date, are
+ * locked, carry the async readahead marker or are mapped already are left
+ * to the fault path.
+ */
+void filemap_map_pages(struct vm_area_struct *vma, unsigned long address,
+		       pte_t *pte, pgoff_t pgoff, unsigned long nr)
+{
+	struct address_space *mapping = vma->vm_file->f_mapping;
+	struct mm_struct *mm = vma->vm_mm;
+	struct page *pages[PAGEVEC_SIZE];
+	pgoff_t start = pgoff, end = pgoff + nr, size;
+	unsigned int i, found;
+
+	size = (i_size_read(mapping->host) + PAGE_CACHE_SIZE - 1) >>
+							PAGE_CACHE_SHIFT;
+	if (end > size)
+		end = size;
+
+	while (pgoff < end) {
+		found = find_get_pages(mapping, pgoff,
+				min_t(unsigned long, end - pgoff, PAGEVEC_SIZE),
+				pages);
+		if (!found)
+			break;
+		pgoff = pages[found - 1]->index + 1;
+
+		for (i = 0; i < found; i++) {
+			struct page *page = pages[i];
+			unsigned long delta = page->index - start;
+			pte_t entry;
+
+			if (page->index >= end || !pte_none(pte[delta]) ||
+			    !PageUptodate(page) || PageReadahead(page) ||
+			    PageHWPoison(page) || !trylock_page(page))
+				goto skip;
+			if (page->mapping != mapping || !PageUptodate(page))
+				goto unlock;
+			/* recheck i_size under page lock, like filemap_fault */
+			size = (i_size_read(mapping->host) +
+				PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
+			if (page->index >= size)
+				goto unlock;
+
+			flush_icache_page(vma, page);
+			entry = mk_pte(page, vma->vm_page_prot);
+			inc_mm_counter(mm, file_rss);
+			page_add_file_rmap(page);
+			set_pte_at(mm, address + delta * PAGE_SIZE, pte + delta,
+				   entry);
+			update_mmu_cache(vma, address + delta * PAGE_SIZE, entry);
+			unlock_page(page);
+			readahead_page_used(page, 1);
+			count_vm_event(FAULT_AROUND);
+			/* the mapping keeps the reference */
+			continue;
+unlock:
+			unlock_page(page);
+skip:
+			page_cache_release(page);
+		}
+	}
+}
+EXPORT_SYMBOL(filemap_map_pages);
+
 const struct vm_operations_struct generic_file_vm_ops = {
 	.fault		= filemap_fault,
+	.map_pages	= filemap_map_pages,
 };
 
 /* This is used for a general mmap of a disk file */
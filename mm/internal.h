@@ -252,6 +252,16 @@ static inline void mminit_validate_memmodel_limits(unsigned long *start_pfn,
 }
 #endif /* CONFIG_SPARSEMEM */
 
+/*
+ * A page brought in by readahead is used for the first time.  It is a
+ * readahead hit, unless it is the page whose miss started the readahead.
+ */
+static inline void readahead_page_used(struct page *page, int hit)
+{
+	if (PagePrefetched(page) && TestClearPagePrefetched(page) && hit)
+		count_vm_event(RA_HIT);
+}
+
 int __get_user_pages(struct task_struct *tsk, struct mm_struct *mm,
 		     unsigned long start, int len, unsigned int foll_flags,
 		     struct page **pages, struct vm_area_struct **vmas);
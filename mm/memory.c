@@ -2683,6 +2683,31 @@ oom:
 	return VM_FAULT_OOM;
 }
 
+/*
+ * Pages around a read fault of a file mapping which ->map_pages() maps in
+ * the same fault when they are in the page cache.  A power of two, so that
+ * the window never crosses a page table.
+ */
+#define FAULT_AROUND_PAGES	16
+
+static void do_fault_around(struct vm_area_struct *vma, unsigned long address,
+			    pte_t *pte, pgoff_t pgoff)
+{
+	unsigned long start_addr, end_addr, off;
+
+	if (vma->vm_flags & (VM_LOCKED | VM_NONLINEAR | VM_RAND_READ))
+		return;
+
+	start_addr = address & ~(FAULT_AROUND_PAGES * PAGE_SIZE - 1);
+	end_addr = start_addr + FAULT_AROUND_PAGES * PAGE_SIZE;
+	start_addr = max(start_addr, vma->vm_start);
+	end_addr = min(end_addr, vma->vm_end);
+
+	off = (address - start_addr) >> PAGE_SHIFT;
+	vma->vm_ops->map_pages(vma, start_addr, pte - off, pgoff - off,
+			       (end_addr - start_addr) >> PAGE_SHIFT);
+}
+
 /*
  * __do_fault() tries to create a new page mapping. It aggressively
  * tries to share with existing pages, but makes a separate copy if
@@ -2831,6 +2856,9 @@ static int __do_fault(struct mm_struct *mm, struct vm_area_struct *vma,
 
 		/* no need to invalidate: a not-present page won't be cached */
 		update_mmu_cache(vma, address, entry);
+
+		if (!(flags & FAULT_FLAG_WRITE) && vma->vm_ops->map_pages)
+			do_fault_around(vma, address, page_table, pgoff);
 	} else {
 		if (charged)
 			mem_cgroup_uncharge_page(page);
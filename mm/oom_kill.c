@@ -31,6 +31,7 @@
 int sysctl_panic_on_oom;
 int sysctl_oom_kill_allocating_task;
 int sysctl_oom_dump_tasks;
+atomic_t oom_adj_generation = ATOMIC_INIT(0);
 static DEFINE_SPINLOCK(zone_scan_lock);
 /* #define DEBUG */
 
@@ -180,6 +180,7 @@ __do_page_cache_readahead(struct address_space *mapping, struct file *filp,
 		list_add(&page->lru, &page_pool);
 		if (page_idx == nr_to_read - lookahead_size)
 			SetPageReadahead(page);
+		SetPagePrefetched(page);
 		ret++;
 	}
 
@@ -188,8 +189,10 @@ __do_page_cache_readahead(struct address_space *mapping, struct file *filp,
 	 * uptodate then the caller will launch readpage again, and
 	 * will then handle the error.
 	 */
-	if (ret)
+	if (ret) {
+		count_vm_events(RA_PAGES, ret);
 		read_pages(mapping, filp, &page_pool, ret);
+	}
 	BUG_ON(!list_empty(&page_pool));
 out:
 	return ret;
@@ -320,6 +323,10 @@ static unsigned long get_next_ra_size(struct file_ra_state *ra,
  * for sequential patterns. Hence interleaved reads might be served as
  * sequential ones.
  *
+ * Misses which are not sequential are remembered in last_miss and
+ * miss_stride.  When two in a row are the same distance apart, the reads
+ * are taken as a backward or strided stream (see stride_readahead()).
+ *
  * There is a special-case: if the first page which the application tries to
  * read happens to be the first page of the file, it is assumed that a linear
  * read is about to happen and the window is immediately set to the initial size
@@ -382,6 +389,40 @@ static int try_context_readahead(struct address_space *mapping,
 	return 1;
 }
 
+/*
+ * Backward and strided streams: each miss is ra->miss_stride pages away from
+ * the one before.  A backward stream gets the window which ends with the
+ * request, a strided one gets its next few chunks.  ra->last_miss is then
+ * moved to where the stream will miss next, so that it is recognised again.
+ */
+static unsigned long
+stride_readahead(struct address_space *mapping, struct file_ra_state *ra,
+		 struct file *filp, pgoff_t offset, unsigned long req_size,
+		 unsigned long max)
+{
+	long stride = ra->miss_stride;
+	unsigned long size = get_init_ra_size(req_size, max);
+	unsigned long i, ret = 0;
+	pgoff_t start;
+
+	if (stride < 0 && -stride <= req_size) {
+		start = offset + req_size > size ? offset + req_size - size : 0;
+		ra->last_miss = start;
+		return __do_page_cache_readahead(mapping, filp, start,
+						 offset + req_size - start, 0);
+	}
+
+	for (i = 0; i * req_size < size; i++) {
+		if (stride < 0 && i * -stride > offset)
+			break;
+		start = offset + i * stride;
+		ret += __do_page_cache_readahead(mapping, filp, start,
+						 req_size, 0);
+		ra->last_miss = start;
+	}
+	return ret;
+}
+
 /*
  * A minimal readahead algorithm for trivial sequential/random reads.
  */
@@ -392,6 +433,7 @@ ondemand_readahead(struct address_space *mapping,
 		   unsigned long req_size)
 {
 	unsigned long max = max_sane_readahead(ra->ra_pages);
+	long stride;
 
 	/*
 	 * start of file
@@ -454,6 +496,16 @@ ondemand_readahead(struct address_space *mapping,
 	if (try_context_readahead(mapping, ra, offset, req_size, max))
 		goto readit;
 
+	/*
+	 * the same distance from the last miss as that one from the miss
+	 * before it: backward or strided stream
+	 */
+	stride = offset - ra->last_miss;
+	if (stride && stride == ra->miss_stride)
+		return stride_readahead(mapping, ra, filp, offset, req_size, max);
+	ra->last_miss = offset;
+	ra->miss_stride = stride;
+
 	/*
 	 * standalone, small random read
 	 * Read as is, and do not pollute the readahead state.
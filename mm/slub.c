@@ -137,6 +137,17 @@
  */
 #define MAX_PARTIAL 10
 
+/*
+ * Uniprocessor systems with less memory than this run SLUB in small mode:
+ * one empty slab at most is kept on the partial lists of a cache and slabs
+ * are of order 1 at most, unless slub_max_order= says otherwise.  A few
+ * hundred caches each holding on to several empty high order slabs add up
+ * to megabytes on such systems.
+ */
+#define SLUB_SMALL_MEMORY	((512 << 20) >> PAGE_SHIFT)
+#define MIN_PARTIAL_SMALL	1
+#define MAX_ORDER_SMALL		1
+
 #define DEBUG_DEFAULT_FLAGS (SLAB_DEBUG_FREE | SLAB_RED_ZONE | \
 				SLAB_POISON | SLAB_STORE_USER)
 
@@ -833,42 +844,6 @@ static void remove_full(struct kmem_cache *s, struct page *page)
 	spin_unlock(&n->list_lock);
 }
 
-/* Tracking of the number of slabs for debugging purposes */
-static inline unsigned long slabs_node(struct kmem_cache *s, int node)
-{
-	struct kmem_cache_node *n = get_node(s, node);
-
-	return atomic_long_read(&n->nr_slabs);
-}
-
-static inline unsigned long node_nr_slabs(struct kmem_cache_node *n)
-{
-	return atomic_long_read(&n->nr_slabs);
-}
-
-static inline void inc_slabs_node(struct kmem_cache *s, int node, int objects)
-{
-	struct kmem_cache_node *n = get_node(s, node);
-
-	/*
-	 * May be called early in order to allocate a slab for the
-	 * kmem_cache_node structure. Solve the chicken-egg
-	 * dilemma by deferring the increment of the count during
-	 * bootstrap (see early_kmem_cache_node_alloc).
-	 */
-	if (!NUMA_BUILD || n) {
-		atomic_long_inc(&n->nr_slabs);
-		atomic_long_add(objects, &n->total_objects);
-	}
-}
-static inline void dec_slabs_node(struct kmem_cache *s, int node, int objects)
-{
-	struct kmem_cache_node *n = get_node(s, node);
-
-	atomic_long_dec(&n->nr_slabs);
-	atomic_long_sub(objects, &n->total_objects);
-}
-
 /* Object debug checks for alloc/free paths */
 static void setup_object_debug(struct kmem_cache *s, struct page *page,
 								void *object)
@@ -1072,16 +1047,43 @@ static inline unsigned long kmem_cache_flags(unsigned long objsize,
 #define slub_debug 0
 
 #define disable_higher_order_debug 0
+#endif
 
+/* Tracking of the number of slabs, for debugging and /proc/slabinfo */
 static inline unsigned long slabs_node(struct kmem_cache *s, int node)
-							{ return 0; }
+{
+	struct kmem_cache_node *n = get_node(s, node);
+
+	return atomic_long_read(&n->nr_slabs);
+}
+
 static inline unsigned long node_nr_slabs(struct kmem_cache_node *n)
-							{ return 0; }
-static inline void inc_slabs_node(struct kmem_cache *s, int node,
-							int objects) {}
-static inline void dec_slabs_node(struct kmem_cache *s, int node,
-							int objects) {}
-#endif
+{
+	return atomic_long_read(&n->nr_slabs);
+}
+
+static inline void inc_slabs_node(struct kmem_cache *s, int node, int objects)
+{
+	struct kmem_cache_node *n = get_node(s, node);
+
+	/*
+	 * May be called early in order to allocate a slab for the
+	 * kmem_cache_node structure. Solve the chicken-egg
+	 * dilemma by deferring the increment of the count during
+	 * bootstrap (see early_kmem_cache_node_alloc).
+	 */
+	if (!NUMA_BUILD || n) {
+		atomic_long_inc(&n->nr_slabs);
+		atomic_long_add(objects, &n->total_objects);
+	}
+}
+static inline void dec_slabs_node(struct kmem_cache *s, int node, int objects)
+{
+	struct kmem_cache_node *n = get_node(s, node);
+
+	atomic_long_dec(&n->nr_slabs);
+	atomic_long_sub(objects, &n->total_objects);
+}
 
 /*
  * Slab allocation and freeing
@@ -1559,11 +1561,7 @@ static unsigned long count_partial(struct kmem_cache_node *n,
 
 static inline unsigned long node_nr_objs(struct kmem_cache_node *n)
 {
-#ifdef CONFIG_SLUB_DEBUG
 	return atomic_long_read(&n->total_objects);
-#else
-	return 0;
-#endif
 }
 
 static noinline void
@@ -1930,9 +1928,12 @@ static struct page *get_object_page(const void *x)
  * take the list_lock.
  */
 static int slub_min_order;
-static int slub_max_order = PAGE_ALLOC_COSTLY_ORDER;
+static int slub_max_order = -1;		/* set in kmem_cache_init() */
 static int slub_min_objects;
 
+/* Lower bound of min_partial, lowered in small mode */
+static unsigned long slub_min_partial = MIN_PARTIAL;
+
 /*
  * Merge control. If this is set then no merging of slab caches will occur.
  * (Could be removed. This was introduced to pacify the merge skeptics.)
@@ -2088,9 +2089,9 @@ init_kmem_cache_node(struct kmem_cache_node *n, struct kmem_cache *s)
 	n->nr_partial = 0;
 	spin_lock_init(&n->list_lock);
 	INIT_LIST_HEAD(&n->partial);
-#ifdef CONFIG_SLUB_DEBUG
 	atomic_long_set(&n->nr_slabs, 0);
 	atomic_long_set(&n->total_objects, 0);
+#ifdef CONFIG_SLUB_DEBUG
 	INIT_LIST_HEAD(&n->full);
 #endif
 }
@@ -2330,8 +2331,8 @@ static int init_kmem_cache_nodes(struct kmem_cache *s, gfp_t gfpflags)
 
 static void set_min_partial(struct kmem_cache *s, unsigned long min)
 {
-	if (min < MIN_PARTIAL)
-		min = MIN_PARTIAL;
+	if (min < slub_min_partial)
+		min = slub_min_partial;
 	else if (min > MAX_PARTIAL)
 		min = MAX_PARTIAL;
 	s->min_partial = min;
@@ -2490,9 +2491,11 @@ static int kmem_cache_open(struct kmem_cache *s, gfp_t gfpflags,
 
 	/*
 	 * The larger the object size is, the more pages we want on the partial
-	 * list to avoid pounding the page allocator excessively.
+	 * list to avoid pounding the page allocator excessively.  Unless
+	 * memory is short, then that is better used elsewhere.
 	 */
-	set_min_partial(s, ilog2(s->size));
+	set_min_partial(s, slub_min_partial == MIN_PARTIAL_SMALL ?
+			   0 : ilog2(s->size));
 	s->refcount = 1;
 #ifdef CONFIG_NUMA
 	s->remote_node_defrag_ratio = 1000;
@@ -3176,6 +3179,14 @@ void __init kmem_cache_init(void)
 	int i;
 	int caches = 0;
 
+	if (nr_cpu_ids == 1 && totalram_pages < SLUB_SMALL_MEMORY) {
+		slub_min_partial = MIN_PARTIAL_SMALL;
+		if (slub_max_order < 0)
+			slub_max_order = MAX_ORDER_SMALL;
+	}
+	if (slub_max_order < 0)
+		slub_max_order = PAGE_ALLOC_COSTLY_ORDER;
+
 	init_alloc_cpu();
 
 #ifdef CONFIG_NUMA
@@ -3269,10 +3280,10 @@ void __init kmem_cache_init(void)
 
 	printk(KERN_INFO
 		"SLUB: Genslabs=%d, HWalign=%d, Order=%d-%d, MinObjects=%d,"
-		" CPUs=%d, Nodes=%d\n",
+		" MinPartial=%lu, CPUs=%d, Nodes=%d\n",
 		caches, cache_line_size(),
 		slub_min_order, slub_max_order, slub_min_objects,
-		nr_cpu_ids, nr_node_ids);
+		slub_min_partial, nr_cpu_ids, nr_node_ids);
 }
 
 void __init kmem_cache_init_late(void)
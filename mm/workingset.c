@@ -0,0 +1,197 @@
+/*
+ * mm/workingset.c
+ *
+ * Workingset detection: tell pages which are evicted and read back soon
+ * after from pages which are really cold.
+ *
+ * The inactive file list of a zone is a FIFO: pages enter at the head,
+ * and are either activated on a second access or evicted at the tail.
+ * zone->inactive_age counts the pages which leave it either way, so
+ * between the eviction of a page and its refault, the list moved by
+ *
+ *	refault distance = inactive_age at refault - inactive_age at eviction
+ *
+ * pages.  Had the inactive list been that much longer, the page would
+ * have been accessed again while still in memory and activated.  The
+ * inactive list can only grow at the expense of the active list, so when
+ * the refault distance is not larger than the active file list, the
+ * refaulting page is put on the active list right away: it competes with
+ * the pages there, instead of being thrown out again by streaming I/O
+ * before its next use.
+ *
+ * The eviction age is remembered in a shadow table instead of the page
+ * cache radix tree, whose users all expect pages in its slots.  The table
+ * is direct mapped, hashed by mapping and index, and sized for about one
+ * shadow per two pages of memory; newer evictions overwrite older ones on
+ * collision and a few tag bits keep false matches rare.  A stale or false
+ * match at worst activates a page which did not deserve it.
+ *
+ * /proc/vmstat counts the refaults found (workingset_refault) and the
+ * pages activated on refault (workingset_activate).
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/hash.h>
+#include <linux/swap.h>
+#include <linux/vmalloc.h>
+#include <linux/vmstat.h>
+
+/*
+ * Shadow entry layout, from the top: eviction age, node, zone, tag bits
+ * and a valid bit, so that no used entry is 0.
+ */
+#define TAG_BITS	8
+#define ZONEID_BITS	(NODES_SHIFT + ZONES_SHIFT)
+#define EVICTION_SHIFT	(1 + TAG_BITS + ZONEID_BITS)
+#define EVICTION_BITS	(BITS_PER_LONG - EVICTION_SHIFT)
+#define EVICTION_MASK	(~0UL >> EVICTION_SHIFT)
+
+static unsigned long *shadow_table __read_mostly;
+static unsigned int shadow_bits __read_mostly;
+
+/*
+ * Eviction ages are kept to bucket_order pages when memory has more pages
+ * than EVICTION_BITS can count.
+ */
+static unsigned int bucket_order __read_mostly;
+
+static unsigned long shadow_key(struct address_space *mapping, pgoff_t index)
+{
+	return hash_long((unsigned long)mapping ^ hash_long(index, BITS_PER_LONG),
+			 BITS_PER_LONG);
+}
+
+static unsigned long *shadow_slot(unsigned long key)
+{
+	return &shadow_table[key >> (BITS_PER_LONG - shadow_bits)];
+}
+
+static unsigned long pack_shadow(unsigned long key, struct zone *zone,
+				 unsigned long eviction)
+{
+	unsigned long entry;
+
+	entry = (eviction >> bucket_order) & EVICTION_MASK;
+	entry = (entry << NODES_SHIFT) | zone_to_nid(zone);
+	entry = (entry << ZONES_SHIFT) | zone_idx(zone);
+	entry = (entry << TAG_BITS) | (key & ((1UL << TAG_BITS) - 1));
+	return (entry << 1) | 1;
+}
+
+static struct zone *unpack_shadow(unsigned long entry, unsigned long *eviction)
+{
+	int zid, nid;
+
+	entry >>= 1 + TAG_BITS;
+	zid = entry & ((1UL << ZONES_SHIFT) - 1);
+	entry >>= ZONES_SHIFT;
+	nid = entry & ((1UL << NODES_SHIFT) - 1);
+	entry >>= NODES_SHIFT;
+
+	*eviction = entry;
+	return NODE_DATA(nid)->node_zones + zid;
+}
+
+static int shadow_matches(unsigned long entry, unsigned long key)
+{
+	return (entry & 1) &&
+	       ((entry >> 1) & ((1UL << TAG_BITS) - 1)) ==
+	       (key & ((1UL << TAG_BITS) - 1));
+}
+
+/**
+ * workingset_eviction - note the eviction of a page from memory
+ * @mapping: address space the page was backing
+ * @page: the page being evicted
+ *
+ * Called from reclaim with mapping->tree_lock held, before the page is
+ * taken out of the page cache.
+ */
+void workingset_eviction(struct address_space *mapping, struct page *page)
+{
+	struct zone *zone = page_zone(page);
+	unsigned long eviction, key;
+
+	eviction = atomic_long_inc_return(&zone->inactive_age);
+	if (!shadow_table)
+		return;
+	key = shadow_key(mapping, page->index);
+	*shadow_slot(key) = pack_shadow(key, zone, eviction);
+}
+
+/**
+ * workingset_refault - evaluate the refault of a previously evicted page
+ * @mapping: address space the page is read into
+ * @index: its offset in @mapping
+ *
+ * Returns 1 if the page was evicted recently enough that it would have
+ * been activated with a longer inactive list, so it should go on the
+ * active list now, 0 otherwise.
+ */
+int workingset_refault(struct address_space *mapping, pgoff_t index)
+{
+	unsigned long entry, eviction, refault, distance, key;
+	unsigned long *slot;
+	struct zone *zone;
+
+	if (!shadow_table)
+		return 0;
+
+	key = shadow_key(mapping, index);
+	slot = shadow_slot(key);
+	entry = *slot;
+	if (!shadow_matches(entry, key))
+		return 0;
+	*slot = 0;
+
+	zone = unpack_shadow(entry, &eviction);
+	refault = atomic_long_read(&zone->inactive_age);
+	distance = ((refault >> bucket_order) - eviction) & EVICTION_MASK;
+	distance <<= bucket_order;
+
+	count_vm_event(WORKINGSET_REFAULT);
+	if (distance <= zone_page_state(zone, NR_ACTIVE_FILE)) {
+		count_vm_event(WORKINGSET_ACTIVATE);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * workingset_activation - note a page activation
+ * @page: page that is being activated
+ *
+ * An activated page leaves the inactive list like an evicted one does.
+ */
+void workingset_activation(struct page *page)
+{
+	atomic_long_inc(&page_zone(page)->inactive_age);
+}
+
+static int __init workingset_init(void)
+{
+	unsigned int max_order;
+	unsigned long *table;
+
+	max_order = fls_long(totalram_pages - 1);
+	if (max_order > EVICTION_BITS)
+		bucket_order = max_order - EVICTION_BITS;
+
+	shadow_bits = max_t(unsigned int, fls_long(totalram_pages / 2), 11) - 1;
+	table = vmalloc(sizeof(unsigned long) << shadow_bits);
+	if (!table) {
+		printk(KERN_WARNING "workingset: no memory for %lu shadow "
+		       "entries\n", 1UL << shadow_bits);
+		return -ENOMEM;
+	}
+	memset(table, 0, sizeof(unsigned long) << shadow_bits);
+	smp_wmb();
+	shadow_table = table;
+	printk(KERN_INFO "workingset: %lu shadow entries, bucket order %u\n",
+	       1UL << shadow_bits, bucket_order);
+	return 0;
+}
+module_init(workingset_init);